@@ -0,0 +1,526 @@
+/*---------------------------------------------------------------------------*/
+/*cache.c*/
+/*---------------------------------------------------------------------------*/
+/*The per-node block cache of the data read from the target translator*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <hurd/io.h>
+/*---------------------------------------------------------------------------*/
+#include "debug.h"
+#include "cache.h"
+#include "stats.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The maximal number of bytes cached for a single node (no caching by
+  default)*/
+size_t cache_size = 0;
+/*---------------------------------------------------------------------------*/
+/*The size of a cached block*/
+size_t cache_block_size = CACHE_BLOCK_SIZE_DEFAULT;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Removes `block` from the list of blocks of `cache`*/
+static void cache_unlink (cache_t * cache, cache_block_t * block)
+{
+  /*Make the neighbours of the block point to each other */
+  if (block->prev)
+    block->prev->next = block->next;
+  else
+    cache->head = block->next;
+
+  if (block->next)
+    block->next->prev = block->prev;
+  else
+    cache->tail = block->prev;
+
+  block->next = block->prev = NULL;
+}				/*cache_unlink */
+
+/*---------------------------------------------------------------------------*/
+/*Puts `block` at the head of the list of blocks of `cache`*/
+static void cache_link (cache_t * cache, cache_block_t * block)
+{
+  block->prev = NULL;
+  block->next = cache->head;
+
+  if (cache->head)
+    cache->head->prev = block;
+  else
+    cache->tail = block;
+
+  cache->head = block;
+}				/*cache_link */
+
+/*---------------------------------------------------------------------------*/
+/*Frees the storage occupied by `block`*/
+static void cache_block_free (cache_block_t * block)
+{
+  munmap (block->data, cache_block_size);
+  free (block);
+}				/*cache_block_free */
+
+/*---------------------------------------------------------------------------*/
+/*Removes the least recently used block of `cache`*/
+static void cache_evict (cache_t * cache)
+{
+  cache_block_t *block = cache->tail;
+
+  /*If there is nothing to evict, stop */
+  if (!block)
+    return;
+
+  /*Remove the block from the list and from the hash table */
+  cache_unlink (cache, block);
+  hurd_ihash_locp_remove (&cache->blocks, block->locp);
+  --cache->nblocks;
+
+  cache_block_free (block);
+}				/*cache_evict */
+
+/*---------------------------------------------------------------------------*/
+/*Reads the block number `index` from `port` into a newly mapped buffer*/
+static
+  error_t
+  cache_fetch (mach_port_t port, loff_t index, char **data, size_t * len)
+{
+  error_t err = 0;
+
+  /*The number of bytes of the block read so far */
+  size_t filled = 0;
+
+  /*Map the buffer for the contents of the block */
+  char *block = mmap (0, cache_block_size, PROT_READ | PROT_WRITE,
+		      MAP_ANON, 0, 0);
+  if (block == MAP_FAILED)
+    return ENOMEM;
+
+  /*The target may return less than asked for, so read until the block is
+     full or the end of file is reached */
+  while (filled < cache_block_size)
+    {
+      char *buf = block + filled;
+      mach_msg_type_number_t amount = cache_block_size - filled;
+
+      err = STATS_RPC (STATS_RPC_IO_READ,
+		       io_read (port, &buf, &amount,
+				index * cache_block_size + filled, amount));
+      if (err)
+	break;
+
+      /*If the data has been returned out of line */
+      if (buf != block + filled)
+	{
+	  /*move it into the block and drop the buffer */
+	  memcpy (block + filled, buf, amount);
+	  munmap (buf, amount);
+	}
+
+      /*If we have reached the end of file, stop */
+      if (amount == 0)
+	break;
+
+      filled += amount;
+    }
+
+  /*If nothing could be read, drop the block */
+  if (err)
+    {
+      munmap (block, cache_block_size);
+      return err;
+    }
+
+  /*Return the block */
+  *data = block;
+  *len = filled;
+  return 0;
+}				/*cache_fetch */
+
+/*---------------------------------------------------------------------------*/
+/*Stores the block number `index` in `cache`, evicting old blocks if the
+  cache is full; returns the block which is in the cache afterwards. The
+  cache must be locked.*/
+static
+  cache_block_t *
+  cache_insert (cache_t * cache, loff_t index, char *data, size_t len)
+{
+  /*If someone has fetched the same block while the cache was unlocked */
+  cache_block_t *block =
+    hurd_ihash_find (&cache->blocks, (hurd_ihash_key_t) index);
+  if (block)
+    {
+      /*keep the old copy */
+      munmap (data, cache_block_size);
+      return block;
+    }
+
+  /*Create the new block */
+  block = malloc (sizeof (cache_block_t));
+  if (!block)
+    {
+      munmap (data, cache_block_size);
+      return NULL;
+    }
+
+  block->index = index;
+  block->data = data;
+  block->len = len;
+
+  /*Make room for the new block */
+  while (cache->nblocks && (cache->nblocks >= CACHE_MAX_BLOCKS))
+    cache_evict (cache);
+
+  /*Add the block to the hash table and to the list */
+  if (hurd_ihash_add (&cache->blocks, (hurd_ihash_key_t) index, block))
+    {
+      cache_block_free (block);
+      return NULL;
+    }
+  cache_link (cache, block);
+  ++cache->nblocks;
+
+  return block;
+}				/*cache_insert */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the block number `index` of `cache`, reading it from `port` if it
+  is missing or waiting for the reader which is already reading it; returns
+  NULL and sets `err` on failure. The cache must be locked; the lock is
+  released while the block is being read.*/
+static
+  cache_block_t *
+  cache_get (cache_t * cache, mach_port_t port, loff_t index, error_t * err)
+{
+  cache_block_t *block = NULL;
+  cache_flight_t *flight, **prevp;
+
+  char *bdata = NULL;
+  size_t blen = 0;
+
+  /*The generation of the cache when the block was requested */
+  unsigned long generation;
+
+  for (;;)
+    {
+      /*if the block is cached, we are done */
+      block = hurd_ihash_find (&cache->blocks, (hurd_ihash_key_t) index);
+      if (block)
+	return block;
+
+      /*look for a reader fetching the same block */
+      for (flight = cache->flights; flight; flight = flight->next)
+	if (flight->index == index)
+	  break;
+
+      if (flight)
+	{
+	  /*wait for the block and share the result */
+	  ++flight->waiters;
+	  while (!flight->done)
+	    condition_wait (&cache->flight_done, &cache->lock);
+	  *err = flight->err;
+
+	  /*the last waiter lets the fetching reader go */
+	  if (--flight->waiters == 0)
+	    condition_broadcast (&cache->flight_done);
+
+	  if (*err)
+	    return NULL;
+
+	  STATS_ADD (stats_coalesced, 1);
+
+	  /*the block may have been dropped in the meantime, so look again */
+	  continue;
+	}
+
+      /*let the other readers know that the block is being read */
+      cache_flight_t own = {.index = index,.done = 0,.err = 0,.waiters = 0 };
+      own.next = cache->flights;
+      cache->flights = &own;
+
+      /*fetch the block from the target without holding the lock */
+      generation = cache->generation;
+      mutex_unlock (&cache->lock);
+      *err = cache_fetch (port, index, &bdata, &blen);
+      mutex_lock (&cache->lock);
+
+      /*if the cache has been invalidated meanwhile, the block may have
+         been read before the change, so drop it and read it again */
+      if (!*err && (cache->generation != generation))
+	munmap (bdata, cache_block_size);
+      else if (!*err && !cache_insert (cache, index, bdata, blen))
+	*err = ENOMEM;
+
+      /*publish the result and wake up the readers waiting for it */
+      for (prevp = &cache->flights; *prevp != &own; prevp = &(*prevp)->next)
+	;
+      *prevp = own.next;
+
+      own.err = *err;
+      own.done = 1;
+      condition_broadcast (&cache->flight_done);
+
+      /*the waiters read the result from our stack, so wait until they
+         have */
+      while (own.waiters)
+	condition_wait (&cache->flight_done, &cache->lock);
+
+      if (*err)
+	return NULL;
+
+      /*the lock has been released while waiting, so the block may have
+         been dropped; look it up again */
+    }
+}				/*cache_get */
+
+/*---------------------------------------------------------------------------*/
+/*Initializes an empty block cache*/
+void cache_init (cache_t * cache)
+{
+  mutex_init (&cache->lock);
+  hurd_ihash_init (&cache->blocks, offsetof (cache_block_t, locp));
+
+  cache->head = cache->tail = NULL;
+  cache->nblocks = 0;
+  cache->flights = NULL;
+  condition_init (&cache->flight_done);
+  cache->generation = 0;
+  cache->stat_valid = 0;
+}				/*cache_init */
+
+/*---------------------------------------------------------------------------*/
+/*Drops all the blocks and frees the resources held by the cache*/
+void cache_destroy (cache_t * cache)
+{
+  cache_invalidate (cache);
+  hurd_ihash_destroy (&cache->blocks);
+}				/*cache_destroy */
+
+/*---------------------------------------------------------------------------*/
+/*Drops all the blocks stored in the cache*/
+void cache_invalidate (cache_t * cache)
+{
+  mutex_lock (&cache->lock);
+
+  /*Evict everything, including the blocks being read */
+  ++cache->generation;
+  while (cache->tail)
+    cache_evict (cache);
+
+  mutex_unlock (&cache->lock);
+}				/*cache_invalidate */
+
+/*---------------------------------------------------------------------------*/
+/*Drops the cached blocks overlapping the region of `len` bytes starting at
+  `offset`*/
+void cache_invalidate_range (cache_t * cache, loff_t offset, size_t len)
+{
+  /*The blocks containing the first and the last byte of the region */
+  loff_t first = offset / cache_block_size;
+  loff_t last = (offset + (len ? len : 1) - 1) / cache_block_size;
+
+  cache_block_t *block, *next;
+
+  mutex_lock (&cache->lock);
+
+  /*The blocks being read might be in the region */
+  ++cache->generation;
+
+  /*Go through all the blocks and drop those in the region */
+  for (block = cache->head; block; block = next)
+    {
+      next = block->next;
+
+      if ((block->index >= first) && (block->index <= last))
+	{
+	  cache_unlink (cache, block);
+	  hurd_ihash_locp_remove (&cache->blocks, block->locp);
+	  --cache->nblocks;
+
+	  cache_block_free (block);
+	}
+    }
+
+  mutex_unlock (&cache->lock);
+}				/*cache_invalidate_range */
+
+/*---------------------------------------------------------------------------*/
+/*Drops the cached blocks if `stat` shows that the file has changed since
+  they were read*/
+void cache_validate (cache_t * cache, io_statbuf_t * stat)
+{
+  mutex_lock (&cache->lock);
+
+  /*If the file has been modified or resized */
+  if (cache->stat_valid
+      && ((cache->size != stat->st_size)
+	  || (cache->mtime.tv_sec != stat->st_mtim.tv_sec)
+	  || (cache->mtime.tv_nsec != stat->st_mtim.tv_nsec)))
+    {
+      LOG_AT (LOG_READ, LOG_LEVEL_DEBUG,
+	      "cache_validate: File changed, dropping %lu blocks.",
+	      (unsigned long) cache->nblocks);
+
+      /*the cached blocks and the blocks being read are stale */
+      ++cache->generation;
+      while (cache->tail)
+	cache_evict (cache);
+    }
+
+  /*Remember the state of the file */
+  cache->mtime = stat->st_mtim;
+  cache->size = stat->st_size;
+  cache->stat_valid = 1;
+
+  mutex_unlock (&cache->lock);
+}				/*cache_validate */
+
+/*---------------------------------------------------------------------------*/
+/*Reads up to `len` bytes from `offset` into `data`, taking the blocks
+  from the cache and fetching the missing ones from `port`*/
+error_t
+  cache_read
+  (cache_t * cache, mach_port_t port, loff_t offset, size_t * len,
+   char *data)
+{
+  error_t err = 0;
+
+  /*The number of bytes copied into `data` so far */
+  size_t done = 0;
+
+  /*The block containing `offset` and the position of `offset` in it */
+  loff_t index = offset / cache_block_size;
+  size_t skip = offset % cache_block_size;
+
+  cache_block_t *block;
+
+  mutex_lock (&cache->lock);
+
+  /*Go through the blocks covering the requested region */
+  while (done < *len)
+    {
+      /*try to find the block in the cache */
+      block = hurd_ihash_find (&cache->blocks, (hurd_ihash_key_t) index);
+      if (block)
+	{
+	  /*this block has just been used */
+	  cache_unlink (cache, block);
+	  cache_link (cache, block);
+	}
+      else
+	{
+	  /*fetch the block or wait for the reader fetching it */
+	  block = cache_get (cache, port, index, &err);
+	  if (!block)
+	    break;
+	}
+
+      /*If the end of file lies before the requested offset, stop */
+      if (skip >= block->len)
+	break;
+
+      /*Copy the required part of the block */
+      size_t n = block->len - skip;
+      if (n > *len - done)
+	n = *len - done;
+      memcpy (data + done, block->data + skip, n);
+
+      done += n;
+      skip = 0;
+      ++index;
+
+      /*If this block contains the end of file, stop */
+      if (block->len < cache_block_size)
+	break;
+    }
+
+  mutex_unlock (&cache->lock);
+
+  /*Report the error only if no data at all could be read */
+  if (done)
+    err = 0;
+
+  *len = done;
+  return err;
+}				/*cache_read */
+
+/*---------------------------------------------------------------------------*/
+/*Checks whether the blocks covering `len` bytes from `offset` (up to the
+  end of file) are all in the cache*/
+int cache_holds (cache_t * cache, loff_t offset, size_t len)
+{
+  /*The blocks containing the first and the last byte of the region */
+  loff_t index = offset / cache_block_size;
+  loff_t last = (offset + (len ? len : 1) - 1) / cache_block_size;
+
+  cache_block_t *block;
+  int held = 1;
+
+  mutex_lock (&cache->lock);
+
+  for (; index <= last; ++index)
+    {
+      block = hurd_ihash_find (&cache->blocks, (hurd_ihash_key_t) index);
+      if (!block)
+	{
+	  held = 0;
+	  break;
+	}
+
+      /*nothing lies beyond the block containing the end of file */
+      if (block->len < cache_block_size)
+	break;
+    }
+
+  mutex_unlock (&cache->lock);
+  return held;
+}				/*cache_holds */
+
+/*---------------------------------------------------------------------------*/
+/*Reads the block number `index` from `port` into the cache unless it is
+  already there; sets `eof` if the block contains the end of file*/
+error_t
+  cache_prefetch (cache_t * cache, mach_port_t port, loff_t index, int *eof)
+{
+  error_t err = 0;
+
+  /*Make sure the block is cached, sharing the read with the clients which
+     may be asking for the same block right now */
+  mutex_lock (&cache->lock);
+  cache_block_t *block = cache_get (cache, port, index, &err);
+  if (block)
+    *eof = (block->len < cache_block_size);
+  mutex_unlock (&cache->lock);
+
+  return err;
+}				/*cache_prefetch */
+
+/*---------------------------------------------------------------------------*/
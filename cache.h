@@ -0,0 +1,175 @@
+/*---------------------------------------------------------------------------*/
+/*cache.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for the per-node block cache of the data read from the
+  target translator*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __CACHE_H__
+#define __CACHE_H__
+/*---------------------------------------------------------------------------*/
+#include <error.h>
+#include <cthreads.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <hurd/ihash.h>
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The default size of a cached block*/
+#define CACHE_BLOCK_SIZE_DEFAULT (16 * 1024)
+/*---------------------------------------------------------------------------*/
+/*The maximal number of blocks a single node may cache*/
+#define CACHE_MAX_BLOCKS (cache_size / cache_block_size)
+/*---------------------------------------------------------------------------*/
+/*Checks whether reads should go through the block cache at all*/
+#define CACHE_ENABLED (CACHE_MAX_BLOCKS > 0)
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A block of data read from the target and kept in memory*/
+struct cache_block
+{
+  /*the index of the block in the file (the offset divided by the block
+     size) */
+  loff_t index;
+
+  /*the number of valid bytes in the block (smaller than the block size
+     only for the block containing the end of file) */
+  size_t len;
+
+  /*the contents of the block (always `cache_block_size` bytes mapped) */
+  char *data;
+
+  /*the neighbours in the list of blocks ordered by the time of the last
+     access (the most recently used block is at the head) */
+  struct cache_block *next, *prev;
+
+  /*the location of the pointer to this block in the hash table */
+  hurd_ihash_locp_t locp;
+};				/*struct cache_block */
+/*---------------------------------------------------------------------------*/
+typedef struct cache_block cache_block_t;
+/*---------------------------------------------------------------------------*/
+/*A block which is being read from the target; the readers needing the
+  same block wait for it instead of asking the target once more*/
+struct cache_flight
+{
+  /*the index of the block being read */
+  loff_t index;
+
+  /*set once the block has been read (or could not be read) */
+  int done;
+
+  /*the result of reading the block */
+  error_t err;
+
+  /*the number of the readers waiting for the block */
+  int waiters;
+
+  /*the next block being read for the same cache */
+  struct cache_flight *next;
+};				/*struct cache_flight */
+/*---------------------------------------------------------------------------*/
+typedef struct cache_flight cache_flight_t;
+/*---------------------------------------------------------------------------*/
+/*The block cache of a node*/
+struct cache
+{
+  /*protects all the fields below; it is never held during RPCs */
+  struct mutex lock;
+
+  /*the cached blocks keyed by their indices */
+  struct hurd_ihash blocks;
+
+  /*the most and the least recently used blocks */
+  cache_block_t *head, *tail;
+
+  /*the number of blocks currently cached */
+  size_t nblocks;
+
+  /*the blocks being read from the target at the moment and the condition
+     signalled when one of them has been read */
+  cache_flight_t *flights;
+  struct condition flight_done;
+
+  /*incremented whenever cached blocks are dropped as stale, so that the
+     blocks read before cannot be stored afterwards */
+  unsigned long generation;
+
+  /*set if the fields below describe the contents of the cache */
+  int stat_valid;
+
+  /*the modification time and the size of the file at the moment the
+     cached blocks were read */
+  struct timespec mtime;
+  off_t size;
+};				/*struct cache */
+/*---------------------------------------------------------------------------*/
+typedef struct cache cache_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The maximal number of bytes cached for a single node*/
+extern size_t cache_size;
+/*---------------------------------------------------------------------------*/
+/*The size of a cached block*/
+extern size_t cache_block_size;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Initializes an empty block cache*/
+void cache_init (cache_t * cache);
+/*---------------------------------------------------------------------------*/
+/*Drops all the blocks and frees the resources held by the cache*/
+void cache_destroy (cache_t * cache);
+/*---------------------------------------------------------------------------*/
+/*Drops all the blocks stored in the cache*/
+void cache_invalidate (cache_t * cache);
+/*---------------------------------------------------------------------------*/
+/*Drops the cached blocks overlapping the region of `len` bytes starting at
+  `offset`*/
+void cache_invalidate_range (cache_t * cache, loff_t offset, size_t len);
+/*---------------------------------------------------------------------------*/
+/*Drops the cached blocks if `stat` shows that the file has changed since
+  they were read*/
+void cache_validate (cache_t * cache, io_statbuf_t * stat);
+/*---------------------------------------------------------------------------*/
+/*Reads up to `len` bytes from `offset` into `data`, taking the blocks
+  from the cache and fetching the missing ones from `port`*/
+error_t
+  cache_read
+  (cache_t * cache, mach_port_t port, loff_t offset, size_t * len,
+   char *data);
+/*---------------------------------------------------------------------------*/
+/*Checks whether the blocks covering `len` bytes from `offset` (up to the
+  end of file) are all in the cache*/
+int cache_holds (cache_t * cache, loff_t offset, size_t len);
+/*---------------------------------------------------------------------------*/
+/*Reads the block number `index` from `port` into the cache unless it is
+  already there; sets `eof` if the block contains the end of file*/
+error_t
+  cache_prefetch (cache_t * cache, mach_port_t port, loff_t index, int *eof);
+/*---------------------------------------------------------------------------*/
+#endif /*__CACHE_H__*/
@@ -27,33 +27,35 @@
 #define __DEBUG_H__
 
 /*---------------------------------------------------------------------------*/
-#include <stdio.h>
+#include "log.h"
 /*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*--------Macros-------------------------------------------------------------*/
-/*Print debug messages here*/
-#define DEBUG_OUTPUT "/var/log/filter.dbg"
-/*---------------------------------------------------------------------------*/
+/*A filter built with debugging logs everything from the start; otherwise
+  the messages are enabled with --log*/
 #ifdef DEBUG
-/*Initializes the log */
-# define INIT_LOG() filter_dbg = fopen(DEBUG_OUTPUT, "wt")
-/*Closes the log */
-# define CLOSE_LOG() fclose(filter_dbg)
-/*Prints a debug message and flushes the debug output */
-# define LOG_MSG(fmt, args...) {fprintf(filter_dbg, fmt"\n", ##args);\
-    fflush(filter_dbg);}
+# define LOG_LEVEL_DEFAULT LOG_LEVEL_DEBUG
 #else
-/*Remove requests for debugging output */
-# define INIT_LOG()
-# define CLOSE_LOG()
-# define LOG_MSG(fmt, args...)
+# define LOG_LEVEL_DEFAULT LOG_LEVEL_OFF
 #endif /*DEBUG*/
 /*---------------------------------------------------------------------------*/
-
-/*---------------------------------------------------------------------------*/
-/*--------Global Variables---------------------------------------------------*/
-/*The file to write debugging info to*/
-extern FILE *filter_dbg;
+/*Initializes the log */
+#define INIT_LOG() log_init(LOG_LEVEL_DEFAULT)
+/*Closes the log */
+#define CLOSE_LOG() log_stop()
+/*Continues logging in a child forked off the filter */
+#define RESTART_LOG() log_restart()
+/*Releases the log of a thread which is about to exit */
+#define EXIT_LOG() log_release()
+/*---------------------------------------------------------------------------*/
+/*Records a message of the category `cat` if that category is logged at
+  `level`; otherwise costs a single test*/
+#define LOG_AT(cat, level, fmt, args...) \
+  {if (__builtin_expect (log_levels[cat] >= (level), 0)) {\
+      static log_site_t log_site = {fmt}; log_msg(&log_site, ##args);}}
+/*---------------------------------------------------------------------------*/
+/*Records a debug message of the general category*/
+#define LOG_MSG(fmt, args...) LOG_AT(LOG_GENERAL, LOG_LEVEL_DEBUG, fmt, ##args)
 /*---------------------------------------------------------------------------*/
 #endif /*__DEBUG_H__*/
@@ -0,0 +1,524 @@
+/*---------------------------------------------------------------------------*/
+/*dircache.c*/
+/*---------------------------------------------------------------------------*/
+/*The per-directory cache of the names looked up in and the entries read
+  from the target translator*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <hurd/fs.h>
+/*---------------------------------------------------------------------------*/
+#include "debug.h"
+#include "dircache.h"
+#include "filter.h"
+#include "stats.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The time (in milliseconds) a missing name is remembered for (0 disables
+  remembering)*/
+int negative_ttl = DIRCACHE_NEGATIVE_TTL_DEFAULT;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Computes the number of the bucket `name` belongs to*/
+static unsigned int dircache_hash (const char *name)
+{
+  unsigned int hash = 0;
+
+  for (; *name; ++name)
+    hash = hash * 31 + (unsigned char) *name;
+
+  return hash % DIRCACHE_BUCKETS;
+}				/*dircache_hash */
+
+/*---------------------------------------------------------------------------*/
+/*Drops all the names (the cache must be locked)*/
+static void dircache_drop_names (dircache_t * dc)
+{
+  dircache_entry_t *entry, *next;
+  int i;
+
+  for (i = 0; i < DIRCACHE_BUCKETS; ++i)
+    {
+      for (entry = dc->buckets[i]; entry; entry = next)
+	{
+	  next = entry->next;
+	  free (entry->name);
+	  free (entry);
+	}
+      dc->buckets[i] = NULL;
+    }
+
+  dc->nentries = 0;
+  dc->nnegative = 0;
+}				/*dircache_drop_names */
+
+/*---------------------------------------------------------------------------*/
+/*Finds the entry of `name` (the cache must be locked)*/
+static dircache_entry_t **dircache_find (dircache_t * dc, const char *name)
+{
+  dircache_entry_t **prevp;
+
+  for (prevp = &dc->buckets[dircache_hash (name)]; *prevp;
+       prevp = &(*prevp)->next)
+    if (strcmp ((*prevp)->name, name) == 0)
+      break;
+
+  return prevp;
+}				/*dircache_find */
+
+/*---------------------------------------------------------------------------*/
+/*Unlinks and frees the entry `*prevp` points to (the cache must be
+  locked)*/
+static void dircache_entry_remove (dircache_t * dc, dircache_entry_t ** prevp)
+{
+  dircache_entry_t *entry = *prevp;
+
+  *prevp = entry->next;
+  if (entry->negative)
+    --dc->nnegative;
+  --dc->nentries;
+
+  free (entry->name);
+  free (entry);
+}				/*dircache_entry_remove */
+
+/*---------------------------------------------------------------------------*/
+/*Drops all the negative entries (the cache must be locked)*/
+static void dircache_drop_negative (dircache_t * dc)
+{
+  dircache_entry_t **prevp;
+  int i;
+
+  for (i = 0; i < DIRCACHE_BUCKETS; ++i)
+    for (prevp = &dc->buckets[i]; *prevp;)
+      if ((*prevp)->negative)
+	dircache_entry_remove (dc, prevp);
+      else
+	prevp = &(*prevp)->next;
+}				/*dircache_drop_negative */
+
+/*---------------------------------------------------------------------------*/
+/*Creates a new entry for `name` (the cache must be locked and the name
+  must not be in it)*/
+static dircache_entry_t *dircache_entry_new (dircache_t * dc,
+					     const char *name)
+{
+  dircache_entry_t *entry;
+  unsigned int hash = dircache_hash (name);
+
+  /*If the directory is too large, start over rather than grow further */
+  if (dc->nentries >= DIRCACHE_MAX)
+    dircache_drop_names (dc);
+
+  entry = malloc (sizeof (dircache_entry_t));
+  if (entry)
+    entry->name = strdup (name);
+  if (!entry || !entry->name)
+    {
+      free (entry);
+      return NULL;
+    }
+
+  entry->negative = 0;
+  entry->next = dc->buckets[hash];
+  dc->buckets[hash] = entry;
+  ++dc->nentries;
+
+  return entry;
+}				/*dircache_entry_new */
+
+/*---------------------------------------------------------------------------*/
+/*Drops all the entries read from the target (the cache must be locked)*/
+static void dircache_drop_dirents (dircache_t * dc)
+{
+  free (dc->dirents);
+  dc->dirents = NULL;
+  dc->dirents_len = dc->dirents_alloced = 0;
+
+  free (dc->offsets);
+  dc->offsets = NULL;
+  dc->ndirents = dc->offsets_alloced = 0;
+
+  dc->complete = 0;
+}				/*dircache_drop_dirents */
+
+/*---------------------------------------------------------------------------*/
+/*Appends `amount` packed dirents occupying `len` bytes of `buf` to the
+  entries read from the target (the cache must be locked)*/
+static error_t
+  dircache_append (dircache_t * dc, char *buf, size_t len, int amount)
+{
+  size_t offset;
+  int i;
+
+  /*Make room for the entries */
+  if (dc->dirents_len + len > dc->dirents_alloced)
+    {
+      size_t alloced = dc->dirents_alloced ? dc->dirents_alloced : len;
+      char *dirents;
+
+      while (alloced < dc->dirents_len + len)
+	alloced *= 2;
+
+      dirents = realloc (dc->dirents, alloced);
+      if (!dirents)
+	return ENOMEM;
+
+      dc->dirents = dirents;
+      dc->dirents_alloced = alloced;
+    }
+
+  if (dc->ndirents + amount > dc->offsets_alloced)
+    {
+      int alloced = dc->offsets_alloced ? dc->offsets_alloced : amount;
+      size_t *offsets;
+
+      while (alloced < dc->ndirents + amount)
+	alloced *= 2;
+
+      offsets = realloc (dc->offsets, alloced * sizeof (size_t));
+      if (!offsets)
+	return ENOMEM;
+
+      dc->offsets = offsets;
+      dc->offsets_alloced = alloced;
+    }
+
+  /*Copy the entries and index them */
+  memcpy (dc->dirents + dc->dirents_len, buf, len);
+
+  for (i = 0, offset = 0; (i < amount) && (offset < len); ++i)
+    {
+      dc->offsets[dc->ndirents++] = dc->dirents_len + offset;
+      offset += ((struct dirent *) (buf + offset))->d_reclen;
+    }
+
+  dc->dirents_len += len;
+  return 0;
+}				/*dircache_append */
+
+/*---------------------------------------------------------------------------*/
+/*Initializes an empty name cache*/
+void dircache_init (dircache_t * dc)
+{
+  memset (dc, 0, sizeof (dircache_t));
+  mutex_init (&dc->lock);
+}				/*dircache_init */
+
+/*---------------------------------------------------------------------------*/
+/*Drops all the names and frees the resources held by the cache*/
+void dircache_destroy (dircache_t * dc)
+{
+  dircache_invalidate (dc);
+}				/*dircache_destroy */
+
+/*---------------------------------------------------------------------------*/
+/*Drops all the names and entries stored in the cache*/
+void dircache_invalidate (dircache_t * dc)
+{
+  mutex_lock (&dc->lock);
+
+  dircache_drop_names (dc);
+  dircache_drop_dirents (dc);
+  ++dc->gen;
+
+  mutex_unlock (&dc->lock);
+}				/*dircache_invalidate */
+
+/*---------------------------------------------------------------------------*/
+/*Drops the names if `stat` shows that the directory has changed since they
+  were looked up*/
+void dircache_validate (dircache_t * dc, io_statbuf_t * stat)
+{
+  mutex_lock (&dc->lock);
+
+  /*If the directory has been modified */
+  if (dc->stat_valid
+      && ((dc->mtime.tv_sec != stat->st_mtim.tv_sec)
+	  || (dc->mtime.tv_nsec != stat->st_mtim.tv_nsec)))
+    {
+      LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG,
+	      "dircache_validate: Directory changed, dropping %lu names.",
+	      (unsigned long) dc->nentries);
+
+      /*the cached names and entries are stale */
+      dircache_drop_names (dc);
+      dircache_drop_dirents (dc);
+      ++dc->gen;
+    }
+
+  /*Remember the state of the directory */
+  dc->mtime = stat->st_mtim;
+  dc->stat_valid = 1;
+
+  mutex_unlock (&dc->lock);
+}				/*dircache_validate */
+
+/*---------------------------------------------------------------------------*/
+/*Finds `name` in the cache and stores the inode number and the filesystem
+  it refers to in `ino` and `fsid`; returns 0 if the name is not cached*/
+int
+  dircache_lookup
+  (dircache_t * dc, const char *name, ino_t * ino, dev_t * fsid)
+{
+  dircache_entry_t *entry;
+  int found = 0;
+
+  mutex_lock (&dc->lock);
+
+  entry = *dircache_find (dc, name);
+  if (entry && !entry->negative)
+    {
+      *ino = entry->ino;
+      *fsid = entry->fsid;
+      found = 1;
+    }
+
+  mutex_unlock (&dc->lock);
+  return found;
+}				/*dircache_lookup */
+
+/*---------------------------------------------------------------------------*/
+/*Remembers that `name` refers to the inode number `ino` in the filesystem
+  `fsid`*/
+error_t
+  dircache_add (dircache_t * dc, const char *name, ino_t ino, dev_t fsid)
+{
+  dircache_entry_t *entry;
+
+  mutex_lock (&dc->lock);
+
+  /*If the name is known, just update it */
+  entry = *dircache_find (dc, name);
+  if (entry && entry->negative)
+    {
+      entry->negative = 0;
+      --dc->nnegative;
+    }
+  else if (!entry)
+    entry = dircache_entry_new (dc, name);
+
+  if (entry)
+    {
+      entry->ino = ino;
+      entry->fsid = fsid;
+    }
+
+  mutex_unlock (&dc->lock);
+  return entry ? 0 : ENOMEM;
+}				/*dircache_add */
+
+/*---------------------------------------------------------------------------*/
+/*Checks whether `name` is known not to exist in the directory*/
+int dircache_lookup_negative (dircache_t * dc, const char *name)
+{
+  dircache_entry_t **prevp;
+  struct timeval now;
+  int found = 0;
+
+  mutex_lock (&dc->lock);
+
+  prevp = dircache_find (dc, name);
+  if (*prevp && (*prevp)->negative)
+    {
+      /*the entry is good only until it expires */
+      maptime_read (maptime, &now);
+      if (timercmp (&now, &(*prevp)->expires, <))
+	found = 1;
+      else
+	dircache_entry_remove (dc, prevp);
+    }
+
+  mutex_unlock (&dc->lock);
+  return found;
+}				/*dircache_lookup_negative */
+
+/*---------------------------------------------------------------------------*/
+/*Remembers for `negative_ttl` milliseconds that `name` does not exist*/
+error_t dircache_add_negative (dircache_t * dc, const char *name)
+{
+  dircache_entry_t *entry;
+  struct timeval ttl;
+
+  if (!negative_ttl)
+    return 0;
+
+  mutex_lock (&dc->lock);
+
+  /*Keep the number of the missing names bounded */
+  if (dc->nnegative >= DIRCACHE_NEGATIVE_MAX)
+    dircache_drop_negative (dc);
+
+  entry = *dircache_find (dc, name);
+  if (!entry)
+    entry = dircache_entry_new (dc, name);
+
+  if (entry)
+    {
+      if (!entry->negative)
+	++dc->nnegative;
+      entry->negative = 1;
+
+      ttl.tv_sec = negative_ttl / 1000;
+      ttl.tv_usec = (negative_ttl % 1000) * 1000;
+      maptime_read (maptime, &entry->expires);
+      timeradd (&entry->expires, &ttl, &entry->expires);
+    }
+
+  mutex_unlock (&dc->lock);
+  return entry ? 0 : ENOMEM;
+}				/*dircache_add_negative */
+
+/*---------------------------------------------------------------------------*/
+/*Forgets whatever is known about `name` and drops the entries read from
+  the target, since the directory has changed*/
+void dircache_forget (dircache_t * dc, const char *name)
+{
+  dircache_entry_t **prevp;
+
+  mutex_lock (&dc->lock);
+
+  prevp = dircache_find (dc, name);
+  if (*prevp)
+    dircache_entry_remove (dc, prevp);
+
+  dircache_drop_dirents (dc);
+  ++dc->gen;
+
+  mutex_unlock (&dc->lock);
+}				/*dircache_forget */
+
+/*---------------------------------------------------------------------------*/
+/*Returns in `data` at most `num_entries` (all if -1) entries starting with
+  the entry number `first_entry`, and not more than `max_data_len` bytes of
+  them (unlimited if 0), reading the entries missing in the cache from the
+  directory `port` in large batches*/
+error_t
+  dircache_readdir
+  (dircache_t * dc,
+   mach_port_t port,
+   int first_entry,
+   int num_entries,
+   vm_size_t max_data_len,
+   char **data, mach_msg_type_number_t * data_len, int *data_entries)
+{
+  error_t err = 0;
+
+  /*The entry after the last one requested */
+  int last;
+
+  /*The size of the reply */
+  size_t len;
+  int i;
+
+  mutex_lock (&dc->lock);
+
+  /*Read the entries until the requested window is covered */
+  while (!err && !dc->complete
+	 && ((num_entries == -1)
+	     || (dc->ndirents < first_entry + num_entries)))
+    {
+      char *buf = NULL;
+      mach_msg_type_number_t buf_len = 0;
+      int amount = 0;
+      int start = dc->ndirents;
+      unsigned long gen = dc->gen;
+
+      /*do not hold the lock during the RPC */
+      mutex_unlock (&dc->lock);
+      err = STATS_RPC (STATS_RPC_DIR_READDIR,
+		       dir_readdir (port, &buf, &buf_len, start,
+				    DIRCACHE_READDIR_BATCH, 0, &amount));
+      mutex_lock (&dc->lock);
+
+      if (err)
+	break;
+
+      LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG,
+	      "dircache_readdir: Read %d entries from %d.", amount, start);
+
+      /*if the cache has not changed meanwhile, store the batch */
+      if ((gen == dc->gen) && (start == dc->ndirents))
+	{
+	  if (amount == 0)
+	    dc->complete = 1;
+	  else
+	    err = dircache_append (dc, buf, buf_len, amount);
+	}
+
+      if (buf_len)
+	munmap (buf, buf_len);
+    }
+
+  if (err)
+    {
+      mutex_unlock (&dc->lock);
+      return err;
+    }
+
+  /*Find out how many of the requested entries fit in the reply */
+  last = ((num_entries == -1) || (first_entry + num_entries > dc->ndirents))
+    ? dc->ndirents : first_entry + num_entries;
+  if (first_entry > last)
+    first_entry = last;
+
+  len = 0;
+  for (i = first_entry; i < last; ++i)
+    {
+      size_t end = (i + 1 < dc->ndirents)
+	? dc->offsets[i + 1] : dc->dirents_len;
+
+      if (max_data_len && (end - dc->offsets[first_entry] > max_data_len))
+	break;
+
+      len = end - dc->offsets[first_entry];
+    }
+  last = i;
+
+  /*Copy the entries out */
+  *data = NULL;
+  *data_len = len;
+  *data_entries = last - first_entry;
+
+  if (len)
+    {
+      *data = mmap (0, len, PROT_READ | PROT_WRITE, MAP_ANON, 0, 0);
+      if (*data == MAP_FAILED)
+	err = ENOMEM;
+      else
+	memcpy (*data, dc->dirents + dc->offsets[first_entry], len);
+    }
+
+  mutex_unlock (&dc->lock);
+  return err;
+}				/*dircache_readdir */
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,172 @@
+/*---------------------------------------------------------------------------*/
+/*dircache.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for the per-directory cache of the names looked up in and
+  the entries read from the target translator*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __DIRCACHE_H__
+#define __DIRCACHE_H__
+/*---------------------------------------------------------------------------*/
+#include <error.h>
+#include <cthreads.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The number of hash buckets of the names of a directory*/
+#define DIRCACHE_BUCKETS 64
+/*---------------------------------------------------------------------------*/
+/*The maximal number of names cached for a single directory*/
+#define DIRCACHE_MAX 1024
+/*---------------------------------------------------------------------------*/
+/*The number of entries read from the target by a single dir_readdir*/
+#define DIRCACHE_READDIR_BATCH 1024
+/*---------------------------------------------------------------------------*/
+/*The maximal number of missing names remembered for a single directory*/
+#define DIRCACHE_NEGATIVE_MAX 256
+/*---------------------------------------------------------------------------*/
+/*The default time (in milliseconds) a missing name is remembered for*/
+#define DIRCACHE_NEGATIVE_TTL_DEFAULT 1000
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A name found in a directory*/
+struct dircache_entry
+{
+  /*the name and the inode number and the filesystem it refers to */
+  char *name;
+  ino_t ino;
+  dev_t fsid;
+
+  /*set if the name does not exist in the directory; the entry is valid
+     until `expires` */
+  int negative;
+  struct timeval expires;
+
+  /*the next entry in the same bucket */
+  struct dircache_entry *next;
+};				/*struct dircache_entry */
+/*---------------------------------------------------------------------------*/
+typedef struct dircache_entry dircache_entry_t;
+/*---------------------------------------------------------------------------*/
+/*The names and the entries cached for a directory*/
+struct dircache
+{
+  /*protects all the fields below; it is never held during RPCs */
+  struct mutex lock;
+
+  /*incremented each time the cache is invalidated */
+  unsigned long gen;
+
+  /*the entries hashed by their names */
+  dircache_entry_t *buckets[DIRCACHE_BUCKETS];
+
+  /*the number of entries and the number of the negative ones among them */
+  size_t nentries;
+  size_t nnegative;
+
+  /*set if the field below describes the state the entries were found in */
+  int stat_valid;
+
+  /*the modification time of the directory at the moment the entries were
+     looked up */
+  struct timespec mtime;
+
+  /*the packed dirents read from the target so far, their size and the
+     size of the buffer */
+  char *dirents;
+  size_t dirents_len;
+  size_t dirents_alloced;
+
+  /*the offsets of the entries in `dirents`, the number of the entries
+     and the size of the array */
+  size_t *offsets;
+  int ndirents;
+  int offsets_alloced;
+
+  /*set if all the entries of the directory have been read */
+  int complete;
+};				/*struct dircache */
+/*---------------------------------------------------------------------------*/
+typedef struct dircache dircache_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The time (in milliseconds) a missing name is remembered for (0 disables
+  remembering)*/
+extern int negative_ttl;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Initializes an empty name cache*/
+void dircache_init (dircache_t * dc);
+/*---------------------------------------------------------------------------*/
+/*Drops all the names and frees the resources held by the cache*/
+void dircache_destroy (dircache_t * dc);
+/*---------------------------------------------------------------------------*/
+/*Drops all the names and entries stored in the cache*/
+void dircache_invalidate (dircache_t * dc);
+/*---------------------------------------------------------------------------*/
+/*Drops the names if `stat` shows that the directory has changed since they
+  were looked up*/
+void dircache_validate (dircache_t * dc, io_statbuf_t * stat);
+/*---------------------------------------------------------------------------*/
+/*Finds `name` in the cache and stores the inode number and the filesystem
+  it refers to in `ino` and `fsid`; returns 0 if the name is not cached*/
+int
+  dircache_lookup
+  (dircache_t * dc, const char *name, ino_t * ino, dev_t * fsid);
+/*---------------------------------------------------------------------------*/
+/*Remembers that `name` refers to the inode number `ino` in the filesystem
+  `fsid`*/
+error_t
+  dircache_add (dircache_t * dc, const char *name, ino_t ino, dev_t fsid);
+/*---------------------------------------------------------------------------*/
+/*Checks whether `name` is known not to exist in the directory*/
+int dircache_lookup_negative (dircache_t * dc, const char *name);
+/*---------------------------------------------------------------------------*/
+/*Remembers for `negative_ttl` milliseconds that `name` does not exist*/
+error_t dircache_add_negative (dircache_t * dc, const char *name);
+/*---------------------------------------------------------------------------*/
+/*Forgets whatever is known about `name` and drops the entries read from
+  the target, since the directory has changed*/
+void dircache_forget (dircache_t * dc, const char *name);
+/*---------------------------------------------------------------------------*/
+/*Returns in `data` at most `num_entries` (all if -1) entries starting with
+  the entry number `first_entry`, and not more than `max_data_len` bytes of
+  them (unlimited if 0), reading the entries missing in the cache from the
+  directory `port` in large batches*/
+error_t
+  dircache_readdir
+  (dircache_t * dc,
+   mach_port_t port,
+   int first_entry,
+   int num_entries,
+   vm_size_t max_data_len,
+   char **data, mach_msg_type_number_t * data_len, int *data_entries);
+/*---------------------------------------------------------------------------*/
+#endif /*__DIRCACHE_H__*/
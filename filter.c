@@ -33,11 +33,36 @@
 #include <argp.h>
 #include <argz.h>
 #include <hurd/netfs.h>
+#include <hurd/fsys.h>
 #include <fcntl.h>
+#include <signal.h>
 /*---------------------------------------------------------------------------*/
 #include "debug.h"
 #include "options.h"
 #include "trace.h"
+#include "stats.h"
+#include "notify.h"
+#include "instance.h"
+#include "tracetab.h"
+#include "server.h"
+#include "pipeline.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A node handed over to the zygote waiting for a filter to be forked*/
+struct zygote_request
+{
+  /*the port to report the startup of the node to */
+  mach_port_t bootstrap;
+
+  /*the name of the translator to filter out */
+  char *name;
+
+  /*the next request in the queue */
+  struct zygote_request *next;
+};				/*struct zygote_request */
+/*---------------------------------------------------------------------------*/
+typedef struct zygote_request zygote_request_t;
 /*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
@@ -63,29 +88,456 @@ volatile struct mapped_time_value *maptime;
 /*The filesystem ID*/
 pid_t fsid;
 /*---------------------------------------------------------------------------*/
-/*The port from which we will read (TODO: and write) the data*/
-mach_port_t target;
-/*---------------------------------------------------------------------------*/
-/*The file to print debug messages to*/
-FILE *filter_dbg;
-/*---------------------------------------------------------------------------*/
 /*The name of the translator to filter out*/
 char *target_name = NULL;
 /*---------------------------------------------------------------------------*/
+/*Set if the target should be found only when it is accessed first*/
+int lazy = 0;
+/*---------------------------------------------------------------------------*/
+/*Set if the filter should serve the whole directory tree of the target*/
+int directory = 0;
+/*---------------------------------------------------------------------------*/
+/*The file on which the filter serving the files of other filters sits (if
+  set, the node we are started on is handed over to that filter)*/
+char *server_file = NULL;
+/*---------------------------------------------------------------------------*/
+/*Set if the filter should only fork new filters for the nodes handed over
+  to it*/
+int zygote = 0;
+/*---------------------------------------------------------------------------*/
+/*The time the startup has begun at and the time the current step of the
+  startup has begun at*/
+static struct timeval startup_begin, startup_mark;
+/*---------------------------------------------------------------------------*/
+/*Signalled when the target of a node has been looked up*/
+static struct condition resolve_cond = CONDITION_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+/*The nodes handed over to the zygote which are waiting for a filter to be
+  forked for them, the lock protecting them and the condition signalled
+  when one is queued*/
+static zygote_request_t *zygote_head, *zygote_tail;
+static struct mutex zygote_lock = MUTEX_INITIALIZER;
+static struct condition zygote_cond = CONDITION_INITIALIZER;
+/*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*--------Functions----------------------------------------------------------*/
+/*Logs the time spent in the step `step` of the startup, which has just
+  finished, and starts timing the next step*/
+static void startup_step (const char *step)
+{
+  struct timeval now;
+
+  gettimeofday (&now, NULL);
+  LOG_AT (LOG_GENERAL, LOG_LEVEL_INFO,
+	  "startup: %s: %ld us (%ld us since the start).", step,
+	  (long) ((now.tv_sec - startup_mark.tv_sec) * 1000000
+		  + (now.tv_usec - startup_mark.tv_usec)),
+	  (long) ((now.tv_sec - startup_begin.tv_sec) * 1000000
+		  + (now.tv_usec - startup_begin.tv_usec)));
+  startup_mark = now;
+}				/*startup_step */
+
+/*---------------------------------------------------------------------------*/
+/*Looks up `name` in the target directory `dirport` with `flags`, creating
+  it with `mode` if requested*/
+static error_t
+  lookup_name
+  (mach_port_t dirport, char *name, int flags, mode_t mode,
+   mach_port_t * port)
+{
+  error_t err = 0;
+
+  /*The retry name and retry type returned by dir_lookup */
+  string_t retry_name;
+  retry_type retry;
+
+  err = STATS_RPC (STATS_RPC_DIR_LOOKUP,
+		   dir_lookup (dirport, name, flags, mode, &retry, retry_name,
+			       port));
+  if (err)
+    return err;
+
+  /*The names which the target cannot resolve completely by itself (such
+     as symlinks leading out of it) are not filtered */
+  if ((retry != FS_RETRY_NORMAL) || (*retry_name != 0))
+    {
+      LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG,
+	      "lookup_name: '%s' needs a retry to '%s'.", name, retry_name);
+
+      PORT_DEALLOC (*port);
+      return EOPNOTSUPP;
+    }
+
+  return 0;
+}				/*lookup_name */
+
+/*---------------------------------------------------------------------------*/
+/*Opens the target of `np` with `flags`: the root nodes find it by tracing
+  the translator stacks under themselves, the other nodes look their names
+  up in the targets of their directories*/
+static error_t lookup_target (struct node *np, int flags, mach_port_t * port)
+{
+  if (np->nn->name)
+    return lookup_name (np->nn->dirport, np->nn->name, flags, 0, port);
+
+  /*Filter the translator stack under ourselves */
+  return trace_find (np->nn->underlying, np->nn->target, flags, port);
+}				/*lookup_target */
+
+/*---------------------------------------------------------------------------*/
+/*Opens the target with `flags` for node `np`, replacing the port the node
+  has been using*/
+static error_t open_target (struct node *np, int flags)
+{
+  error_t err = 0;
+
+  /*The port to the target */
+  mach_port_t port;
+
+  /*Let the lazy lookup of the target finish first */
+  while (np->nn->flags & FLAG_NODE_RESOLVING)
+    condition_wait (&resolve_cond, &np->lock);
+
+  /*Find the target again */
+  err = lookup_target (np, flags, &port);
+  if (err)
+    return err;
+
+  LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG,
+	  "open_target: Opened the target with flags 0x%x.", flags);
+
+  /*Drop the old port, unless it is the underlying node we still use */
+  if (MACH_PORT_VALID (np->nn->port) && (np->nn->port != np->nn->underlying))
+    PORT_DEALLOC (np->nn->port);
+
+  /*Store the new port in the node */
+  np->nn->port = port;
+  np->nn->openmodes = flags;
+
+  /*Ask the new target to tell us about its changes (if it cannot, the
+     cached state will be checked by asking it) */
+  notify_subscribe (np);
+
+  return 0;
+}				/*open_target */
+
+/*---------------------------------------------------------------------------*/
+/*Makes sure the target of `np` has been opened, tracing the stack now if
+  this has been deferred. Concurrent callers wait for a single lookup. The
+  node must be locked; it is unlocked while the stack is traced, since
+  tracing may ask ourselves for our control port.*/
+static error_t resolve_target (struct node *np)
+{
+  error_t err = 0;
+
+  /*The port to the target */
+  mach_port_t port;
+
+  /*If another thread is looking up the target, wait for it */
+  while (np->nn->flags & FLAG_NODE_RESOLVING)
+    condition_wait (&resolve_cond, &np->lock);
+
+  /*If the target is known, there is nothing to do */
+  if (MACH_PORT_VALID (np->nn->port))
+    return 0;
+
+  np->nn->flags |= FLAG_NODE_RESOLVING;
+  mutex_unlock (&np->lock);
+
+  /*Filter the translator stack under ourselves */
+  err = lookup_target (np, np->nn->openmodes, &port);
+
+  mutex_lock (&np->lock);
+  np->nn->flags &= ~FLAG_NODE_RESOLVING;
+
+  LOG_AT (LOG_TRACE, LOG_LEVEL_INFO,
+	  "resolve_target: Traced the stack lazily: %d.", (int) err);
+
+  /*Store the port and listen to the changes of the target; if the lookup
+     has failed, the next access will try again */
+  if (!err)
+    {
+      np->nn->port = port;
+      notify_subscribe (np);
+    }
+
+  /*Wake up the threads waiting for the lookup */
+  condition_broadcast (&resolve_cond);
+  return err;
+}				/*resolve_target */
+
+/*---------------------------------------------------------------------------*/
+/*The thread looking up the new target of the node `arg` after the old one
+  has died*/
+static any_t retrace_thread (any_t arg)
+{
+  struct node *np = arg;
+  error_t err = 0;
+  int i, delay = RETRACE_DELAY;
+
+  /*The port to the new target and the dead one it replaces */
+  mach_port_t port = MACH_PORT_NULL, dead;
+
+  /*Open the new target in the same way as the old one */
+  mutex_lock (&np->lock);
+  int flags = np->nn->openmodes;
+  dead = np->nn->port;
+  mutex_unlock (&np->lock);
+
+  for (;;)
+    {
+      /*the target may be restarting, so try several times */
+      for (i = 0; i < RETRACE_TRIES; ++i)
+	{
+	  err = lookup_target (np, flags, &port);
+	  if (!err)
+	    break;
+
+	  usleep (delay * 1000);
+	  delay *= 2;
+	}
+
+      LOG_AT (LOG_TRACE, LOG_LEVEL_INFO,
+	      "retrace_thread: Traced the stack again: %d.", (int) err);
+      if (err)
+	break;
+
+      /*swap the port under the lock, so every request uses either the
+         old port or the new one; the readers holding their own reference
+         to the old port finish with it */
+      mutex_lock (&np->lock);
+
+      /*if the target has been opened anew meanwhile, keep that port */
+      if (np->nn->port != dead)
+	{
+	  mutex_unlock (&np->lock);
+	  PORT_DEALLOC (port);
+	  break;
+	}
+
+      /*if the node has been opened for writing meanwhile, the new target
+         must be opened in the same way */
+      if (np->nn->openmodes != flags)
+	{
+	  flags = np->nn->openmodes;
+	  mutex_unlock (&np->lock);
+	  PORT_DEALLOC (port);
+	  continue;
+	}
+
+      if (MACH_PORT_VALID (np->nn->port)
+	  && (np->nn->port != np->nn->underlying))
+	PORT_DEALLOC (np->nn->port);
+      np->nn->port = port;
+
+      /*nothing known about the old target applies to the new one */
+      cache_invalidate (&np->nn->cache);
+      node_stat_changed (np);
+      notify_subscribe (np);
+
+      mutex_unlock (&np->lock);
+      break;
+    }
+
+  __sync_lock_release (&np->nn->retracing);
+  netfs_nrele (np);
+
+  EXIT_LOG ();
+  return 0;
+}				/*retrace_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Finds the new target of `np` in the background and swaps it in for the
+  dead one*/
+void retrace_target (struct node *np)
+{
+  /*If the new target is already being looked up, stop */
+  if (__sync_lock_test_and_set (&np->nn->retracing, 1))
+    return;
+
+  /*The node must live until the lookup is done */
+  netfs_nref (np);
+
+  cthread_detach (cthread_fork (retrace_thread, np));
+}				/*retrace_target */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the name under which the translator called `name` appears in the
+  translator stack in a newly allocated string*/
+static char *target_path (const char *name)
+{
+  char *path;
+
+  /*The translators are usually started by their short names from /hurd */
+  if (strchr (name, '/'))
+    return strdup (name);
+  if (asprintf (&path, "/hurd/%s", name) < 0)
+    return NULL;
+
+  return path;
+}				/*target_path */
+
+/*---------------------------------------------------------------------------*/
+/*Makes `np` the root node of the file sitting on `underlying` (whose stat
+  information is `stat`) filtering out the translator `target`; the port
+  and the string are consumed. The target is looked up on the first access
+  or by `resolve_target`.*/
+static void
+  setup_root
+  (struct node *np, mach_port_t underlying, io_statbuf_t * stat,
+   char *target)
+{
+  np->nn->underlying = underlying;
+  np->nn->target = target;
+
+  /*Setup the stat information for the root node */
+  np->nn_stat = *stat;
+  np->nn_stat.st_fsid = fsid;
+  np->nn_translated = np->nn_stat.st_mode;
+
+  /*The target will be opened for reading; the root node must not use the
+     underlying node in the meantime */
+  np->nn->openmodes = O_READ;
+  np->nn->port = MACH_PORT_NULL;
+
+  /*Update the timestamps of the root node */
+  fshelp_touch
+    (&np->nn_stat, TOUCH_ATIME | TOUCH_MTIME | TOUCH_CTIME, maptime);
+}				/*setup_root */
+
+/*---------------------------------------------------------------------------*/
+/*Finds or creates the node of the target `port`, which has been found as
+  `name` in `dir`, and returns it with a new reference in `node` (the port
+  is consumed). The directory must be locked.*/
+static error_t
+  make_node (struct node *dir, char *name, mach_port_t port,
+	     struct node **node)
+{
+  error_t err = 0;
+
+  /*The node and the stat information of its target */
+  node_t *np = NULL;
+  io_statbuf_t stat;
+
+  err = STATS_RPC (STATS_RPC_IO_STAT, io_stat (port, &stat));
+  if (err)
+    {
+      PORT_DEALLOC (port);
+      return err;
+    }
+
+  /*If the inode has a node already (a hard link or a name whose cached
+     entry has been dropped), use it */
+  np = node_cache_find (stat.st_ino, stat.st_fsid);
+  if (np)
+    PORT_DEALLOC (port);
+  else
+    {
+      err = node_create (&np);
+      if (err)
+	{
+	  PORT_DEALLOC (port);
+	  return err;
+	}
+
+      /*the node uses the port we have just obtained */
+      np->nn->port = port;
+      np->nn->openmodes = O_READ;
+      np->nn_stat = stat;
+      np->nn_translated = stat.st_mode & ~S_ITRANS;
+      node_stat_update (np, node_stat_changes (np));
+
+      /*remember where the node has been found to be able to open it
+         again */
+      np->nn->name = strdup (name);
+      if (np->nn->name)
+	err = node_get_port (dir, &np->nn->dirport);
+      else
+	err = ENOMEM;
+
+      if (err)
+	{
+	  netfs_nrele (np);
+	  return err;
+	}
+
+      notify_subscribe (np);
+      node_cache_add (np);
+    }
+
+  /*Remember the name */
+  dircache_add (&dir->nn->names, name, np->nn_stat.st_ino,
+		np->nn_stat.st_fsid);
+
+  *node = np;
+  return 0;
+}				/*make_node */
+
+/*---------------------------------------------------------------------------*/
+/*Records that `name` has been created in `dir` by the filter itself*/
+static void dir_entry_created (struct node *dir, char *name)
+{
+  /*The name is not missing any more and the listing has changed */
+  dircache_forget (&dir->nn->names, name);
+  NODE_STAT_INVALIDATE (dir);
+}				/*dir_entry_created */
+
+/*---------------------------------------------------------------------------*/
 /*Attempts to create a file named `name` in `dir` for `user` with mode `mode`*/
 error_t
   netfs_attempt_create_file
   (struct iouser *user,
    struct node *dir, char *name, mode_t mode, struct node **node)
 {
-  LOG_MSG ("netfs_attempt_create_file");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_create_file");
+  STATS_CALL (STATS_OP_CREATE_FILE);
+
+  error_t err = 0;
+
+  /*The port to the new file */
+  mach_port_t port;
+
+  /*The new node */
+  node_t *np = NULL;
+
+  *node = NULL;
+
+  /*Only the directory mode has directories */
+  if (!directory)
+    {
+      mutex_unlock (&dir->lock);
+      return STATS_RESULT (STATS_OP_CREATE_FILE, EOPNOTSUPP);
+    }
+
+  /*The user must be allowed to modify the directory */
+  err = netfs_validate_stat (dir, user);
+  if (!err)
+    err = fshelp_access (&dir->nn_stat, S_IWRITE, user);
+
+  /*Create the file in the target (libnetfs looks the name up again if it
+     has appeared meanwhile) */
+  if (!err)
+    err = lookup_name
+      (dir->nn->port, name, O_CREAT | O_EXCL | O_READ, mode & ~S_IFMT,
+       &port);
+
+  if (!err)
+    {
+      dir_entry_created (dir, name);
+      err = make_node (dir, name, port, &np);
+    }
 
-  /*Unlock `dir` and say that we can do nothing else here */
   mutex_unlock (&dir->lock);
-  return EOPNOTSUPP;
+
+  if (!err)
+    {
+      mutex_lock (&np->lock);
+      *node = np;
+    }
+
+  /*Return the result of operations */
+  return STATS_RESULT (STATS_OP_CREATE_FILE, err);
 }				/*netfs_attempt_create_file */
 
 /*---------------------------------------------------------------------------*/
@@ -95,7 +547,8 @@ error_t
   netfs_check_open_permissions
   (struct iouser * user, struct node * np, int flags, int newnode)
 {
-  LOG_MSG ("netfs_check_open_permissions");
+  LOG_AT (LOG_PERM, LOG_LEVEL_DEBUG, "netfs_check_open_permissions");
+  STATS_CALL (STATS_OP_CHECK_OPEN_PERMISSIONS);
 
   error_t err = 0;
 
@@ -107,8 +560,13 @@ error_t
   if (!err && (flags & O_EXEC))
     err = fshelp_access (&np->nn_stat, S_IEXEC, user);
 
+  /*If the client is going to write, but the target has been opened only
+     for reading, reopen it */
+  if (!err && (flags & O_WRITE) && !(np->nn->openmodes & O_WRITE))
+    err = open_target (np, np->nn->openmodes | O_READ | O_WRITE);
+
   /*Return the result of the check */
-  return err;
+  return STATS_RESULT (STATS_OP_CHECK_OPEN_PERMISSIONS, err);
 }				/*netfs_check_open_permissions */
 
 /*---------------------------------------------------------------------------*/
@@ -118,7 +576,8 @@ error_t
   (struct iouser * cred,
    struct node * node, struct timespec * atime, struct timespec * mtime)
 {
-  LOG_MSG ("netfs_attempt_utimes");
+  LOG_AT (LOG_PERM, LOG_LEVEL_DEBUG, "netfs_attempt_utimes");
+  STATS_CALL (STATS_OP_UTIMES);
 
   error_t err = 0;
 
@@ -152,7 +611,7 @@ error_t
     }
 
   /*Return the result of operations */
-  return err;
+  return STATS_RESULT (STATS_OP_UTIMES, err);
 }				/*netfs_attempt_utimes */
 
 /*---------------------------------------------------------------------------*/
@@ -160,7 +619,8 @@ error_t
 error_t
   netfs_report_access (struct iouser * cred, struct node * np, int *types)
 {
-  LOG_MSG ("netfs_report_access");
+  LOG_AT (LOG_PERM, LOG_LEVEL_DEBUG, "netfs_report_access");
+  STATS_CALL (STATS_OP_REPORT_ACCESS);
 
   /*No access at first */
   *types = 0;
@@ -181,15 +641,57 @@ error_t
 /*Validates the stat data for the node*/
 error_t netfs_validate_stat (struct node * np, struct iouser * cred)
 {
-  LOG_MSG ("netfs_validate_stat");
+  LOG_AT (LOG_PERM, LOG_LEVEL_DEBUG, "netfs_validate_stat");
+  STATS_CALL (STATS_OP_VALIDATE_STAT);
 
   error_t err = 0;
 
+  /*If the cached stat information is still good, use it */
+  if (node_stat_fresh (np))
+    return 0;
+
+  /*Find the target if this has not been done yet */
+  err = resolve_target (np);
+  if (err)
+    return STATS_RESULT (STATS_OP_VALIDATE_STAT, err);
+
+  /*Remember how many changes have been notified before asking */
+  unsigned long changes = node_stat_changes (np);
+
   /*Validate the stat information about the node */
-  err = io_stat (np->nn->port, &np->nn_stat);
+  err = STATS_RPC (STATS_RPC_IO_STAT, io_stat (np->nn->port, &np->nn_stat));
+  if (TARGET_DEAD (err))
+    retrace_target (np);
+
+  /*The information may be cached only if no change has been notified
+     while we were waiting for it */
+  if (!err)
+    node_stat_update (np, changes);
+
+  /*If the file has changed, the cached blocks must be dropped */
+  if (!err)
+    cache_validate (&np->nn->cache, &np->nn_stat);
+
+  /*The same goes for the names cached for a directory; besides, in the
+     directory mode the node must be found by its inode number */
+  if (!err && directory)
+    {
+      if (S_ISDIR (np->nn_stat.st_mode))
+	dircache_validate (&np->nn->names, &np->nn_stat);
+      node_cache_add (np);
+    }
+
+  /*The file ends where the data not written to the target yet ends, if
+     that is farther */
+  if (!err)
+    {
+      loff_t end = writeback_end (np);
+      if (end > np->nn_stat.st_size)
+	np->nn_stat.st_size = end;
+    }
 
   /*Return the result of operations */
-  return err;
+  return STATS_RESULT (STATS_OP_VALIDATE_STAT, err);
 }				/*netfs_validate_stat */
 
 /*---------------------------------------------------------------------------*/
@@ -197,10 +699,26 @@ error_t netfs_validate_stat (struct node * np, struct iouser * cred)
 error_t
   netfs_attempt_sync (struct iouser * cred, struct node * node, int wait)
 {
-  LOG_MSG ("netfs_attempt_sync");
+  LOG_AT (LOG_READ, LOG_LEVEL_DEBUG, "netfs_attempt_sync");
+  STATS_CALL (STATS_OP_SYNC);
 
-  /*Operation is not supported */
-  return EOPNOTSUPP;
+  error_t err = 0;
+
+  /*If the target has never been accessed, there is nothing to sync */
+  if (!MACH_PORT_VALID (node->nn->port))
+    return 0;
+
+  /*Write the buffered data to the target */
+  err = writeback_flush (node);
+
+  /*Ask the target to sync the node, too */
+  error_t e =
+    STATS_RPC (STATS_RPC_FILE_SYNC, file_sync (node->nn->port, wait, 0));
+  if (!err && (e != EOPNOTSUPP))
+    err = e;
+
+  /*Return the result of operations */
+  return STATS_RESULT (STATS_OP_SYNC, err);
 }				/*netfs_attempt_sync */
 
 /*---------------------------------------------------------------------------*/
@@ -215,10 +733,31 @@ error_t
    mach_msg_type_number_t * data_len,
    vm_size_t max_data_len, int *data_entries)
 {
-  LOG_MSG ("netfs_get_dirents");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_get_dirents");
+  STATS_CALL (STATS_OP_GET_DIRENTS);
 
-  /*This node is not a directory */
-  return ENOTDIR;
+  error_t err = 0;
+
+  /*Only the directory mode has directories */
+  if (!directory)
+    return STATS_RESULT (STATS_OP_GET_DIRENTS, ENOTDIR);
+
+  /*Find the target if this has not been done yet */
+  err = resolve_target (dir);
+  if (err)
+    return STATS_RESULT (STATS_OP_GET_DIRENTS, err);
+
+  /*Serve the entries from the cache, which reads them from the target in
+     large batches; they carry the inode numbers of the target, which our
+     nodes report, too */
+  err = dircache_readdir
+    (&dir->nn->names, dir->nn->port, first_entry, num_entries, max_data_len,
+     data, data_len, data_entries);
+  if (TARGET_DEAD (err))
+    retrace_target (dir);
+
+  /*Return the result of operations */
+  return STATS_RESULT (STATS_OP_GET_DIRENTS, err);
 }				/*netfs_get_dirents */
 
 /*---------------------------------------------------------------------------*/
@@ -227,11 +766,89 @@ error_t
   netfs_attempt_lookup
   (struct iouser * user, struct node * dir, char *name, struct node ** node)
 {
-  LOG_MSG ("netfs_attempt_lookup: '%s'", name);
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_lookup: '%s'", name);
+  STATS_CALL (STATS_OP_LOOKUP);
+
+  error_t err = 0;
+
+  /*The node found */
+  node_t *np = NULL;
+
+  /*The port to the target of the node */
+  mach_port_t port = MACH_PORT_NULL;
+
+  /*The identity of the node found */
+  ino_t ino;
+  dev_t fsid;
+
+  *node = NULL;
+
+  /*Only the directory mode has directories */
+  if (!directory)
+    {
+      mutex_unlock (&dir->lock);
+      return STATS_RESULT (STATS_OP_LOOKUP, EOPNOTSUPP);
+    }
 
-  /*Unlock the mutexes in `dir` */
+  /*The directory itself stays locked */
+  if (strcmp (name, ".") == 0)
+    {
+      netfs_nref (dir);
+      *node = dir;
+      return STATS_RESULT (STATS_OP_LOOKUP, 0);
+    }
+
+  /*If the name has been found missing recently, it still is: the entry
+     expires by itself and is dropped when the directory reports a change,
+     so the directory is not asked for its stat information again, and the
+     cached one tells whether the user may search it */
+  if (dircache_lookup_negative (&dir->nn->names, name))
+    {
+      err = fshelp_access (&dir->nn_stat, S_IEXEC, user);
+      mutex_unlock (&dir->lock);
+      return STATS_RESULT (STATS_OP_LOOKUP, err ? err : ENOENT);
+    }
+
+  /*Make sure the names cached for the directory are still valid */
+  err = netfs_validate_stat (dir, user);
+
+  /*The user must be allowed to search the directory */
+  if (!err)
+    err = fshelp_access (&dir->nn_stat, S_IEXEC, user);
+
+  /*If the name has been looked up before and its node is alive, use it */
+  if (!err && dircache_lookup (&dir->nn->names, name, &ino, &fsid))
+    np = node_cache_find (ino, fsid);
+
+  if (!err && !np)
+    {
+      /*ask the target */
+      err = lookup_name (dir->nn->port, name, O_READ, 0, &port);
+      if (err == EACCES)
+	err = lookup_name (dir->nn->port, name, 0, 0, &port);
+      if (TARGET_DEAD (err))
+	retrace_target (dir);
+
+      /*remember the missing names, so that probing them again is cheap */
+      if (err == ENOENT)
+	dircache_add_negative (&dir->nn->names, name);
+
+      if (!err)
+	err = make_node (dir, name, port, &np);
+    }
+
+  /*Lock the node found only after unlocking the directory, since the node
+     may be the parent of the directory */
   mutex_unlock (&dir->lock);
-  return EOPNOTSUPP;
+
+  if (!err)
+    {
+      mutex_lock (&np->lock);
+      *node = np;
+    }
+
+  /*Return the result of operations */
+  return STATS_RESULT (STATS_OP_LOOKUP, err);
 }				/*netfs_attempt_lookup */
 
 /*---------------------------------------------------------------------------*/
@@ -239,7 +856,8 @@ error_t
 error_t
   netfs_attempt_unlink (struct iouser * user, struct node * dir, char *name)
 {
-  LOG_MSG ("netfs_attempt_unlink");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_unlink");
+  STATS_CALL (STATS_OP_UNLINK);
 
   return 0;
 }				/*netfs_attempt_unlink */
@@ -252,10 +870,11 @@ error_t
    struct node * fromdir,
    char *fromname, struct node * todir, char *toname, int excl)
 {
-  LOG_MSG ("netfs_attempt_rename");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_rename");
+  STATS_CALL (STATS_OP_RENAME);
 
   /*Operation not supported */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_RENAME, EOPNOTSUPP);
 }				/*netfs_attempt_rename */
 
 /*---------------------------------------------------------------------------*/
@@ -264,9 +883,30 @@ error_t
   netfs_attempt_mkdir
   (struct iouser * user, struct node * dir, char *name, mode_t mode)
 {
-  LOG_MSG ("netfs_attempt_mkdir");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_mkdir");
+  STATS_CALL (STATS_OP_MKDIR);
 
-  return 0;
+  error_t err = 0;
+
+  /*Only the directory mode has directories */
+  if (!directory)
+    return STATS_RESULT (STATS_OP_MKDIR, EOPNOTSUPP);
+
+  /*The user must be allowed to modify the directory */
+  err = netfs_validate_stat (dir, user);
+  if (!err)
+    err = fshelp_access (&dir->nn_stat, S_IWRITE, user);
+
+  /*Create the directory in the target */
+  if (!err)
+    err = STATS_RPC (STATS_RPC_DIR_MKDIR,
+		     dir_mkdir (dir->nn->port, name, mode & ~S_IFMT));
+
+  if (!err)
+    dir_entry_created (dir, name);
+
+  /*Return the result of operations */
+  return STATS_RESULT (STATS_OP_MKDIR, err);
 }				/*netfs_attempt_mkdir */
 
 /*---------------------------------------------------------------------------*/
@@ -274,7 +914,8 @@ error_t
 error_t
   netfs_attempt_rmdir (struct iouser * user, struct node * dir, char *name)
 {
-  LOG_MSG ("netfs_attempt_rmdir");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_rmdir");
+  STATS_CALL (STATS_OP_RMDIR);
 
   return 0;
 }				/*netfs_attempt_rmdir */
@@ -285,10 +926,11 @@ error_t
   netfs_attempt_chown
   (struct iouser * cred, struct node * node, uid_t uid, uid_t gid)
 {
-  LOG_MSG ("netfs_attempt_chown");
+  LOG_AT (LOG_PERM, LOG_LEVEL_DEBUG, "netfs_attempt_chown");
+  STATS_CALL (STATS_OP_CHOWN);
 
   /*Operation is not supported */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_CHOWN, EOPNOTSUPP);
 }				/*netfs_attempt_chown */
 
 /*---------------------------------------------------------------------------*/
@@ -297,10 +939,11 @@ error_t
   netfs_attempt_chauthor
   (struct iouser * cred, struct node * node, uid_t author)
 {
-  LOG_MSG ("netfs_attempt_chauthor");
+  LOG_AT (LOG_PERM, LOG_LEVEL_DEBUG, "netfs_attempt_chauthor");
+  STATS_CALL (STATS_OP_CHAUTHOR);
 
   /*Operation is not supported */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_CHAUTHOR, EOPNOTSUPP);
 }				/*netfs_attempt_chauthor */
 
 /*---------------------------------------------------------------------------*/
@@ -308,10 +951,11 @@ error_t
 error_t
   netfs_attempt_chmod (struct iouser * user, struct node * node, mode_t mode)
 {
-  LOG_MSG ("netfs_attempt_chmod");
+  LOG_AT (LOG_PERM, LOG_LEVEL_DEBUG, "netfs_attempt_chmod");
+  STATS_CALL (STATS_OP_CHMOD);
 
   /*Operation is not supported */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_CHMOD, EOPNOTSUPP);
 }				/*netfs_attempt_chmod */
 
 /*---------------------------------------------------------------------------*/
@@ -320,10 +964,11 @@ error_t
   netfs_attempt_mksymlink
   (struct iouser * cred, struct node * node, char *name)
 {
-  LOG_MSG ("netfs_attempt_mksymlink");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_mksymlink");
+  STATS_CALL (STATS_OP_MKSYMLINK);
 
   /*Operation is not supported */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_MKSYMLINK, EOPNOTSUPP);
 }				/*netfs_attempt_mksymlink */
 
 /*---------------------------------------------------------------------------*/
@@ -333,10 +978,11 @@ error_t
   netfs_attempt_mkdev
   (struct iouser * cred, struct node * node, mode_t type, dev_t indexes)
 {
-  LOG_MSG ("netfs_attempt_mkdev");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_mkdev");
+  STATS_CALL (STATS_OP_MKDEV);
 
   /*Operation is not supported */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_MKDEV, EOPNOTSUPP);
 }				/*netfs_attempt_mkdev */
 
 /*---------------------------------------------------------------------------*/
@@ -345,10 +991,11 @@ error_t
   netfs_set_translator
   (struct iouser * cred, struct node * node, char *argz, size_t arglen)
 {
-  LOG_MSG ("netfs_set_translator");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_set_translator");
+  STATS_CALL (STATS_OP_SET_TRANSLATOR);
 
   /*Operation is not supported */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_SET_TRANSLATOR, EOPNOTSUPP);
 }				/*netfs_set_translator */
 
 /*---------------------------------------------------------------------------*/
@@ -356,10 +1003,11 @@ error_t
 error_t
   netfs_attempt_chflags (struct iouser * cred, struct node * node, int flags)
 {
-  LOG_MSG ("netfs_attempt_chflags");
+  LOG_AT (LOG_PERM, LOG_LEVEL_DEBUG, "netfs_attempt_chflags");
+  STATS_CALL (STATS_OP_CHFLAGS);
 
   /*Operation is not supported */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_CHFLAGS, EOPNOTSUPP);
 }				/*netfs_attempt_chflags */
 
 /*---------------------------------------------------------------------------*/
@@ -368,10 +1016,31 @@ error_t
   netfs_attempt_set_size
   (struct iouser * cred, struct node * node, loff_t size)
 {
-  LOG_MSG ("netfs_attempt_set_size");
+  LOG_AT (LOG_READ, LOG_LEVEL_DEBUG, "netfs_attempt_set_size");
+  STATS_CALL (STATS_OP_SET_SIZE);
 
-  /*Operation is not supported */
-  return EOPNOTSUPP;
+  error_t err = 0;
+
+  /*Find the target if this has not been done yet */
+  err = resolve_target (node);
+  if (err)
+    return STATS_RESULT (STATS_OP_SET_SIZE, err);
+
+  /*The target must see the data written to the node before */
+  err = writeback_flush (node);
+  if (err)
+    return STATS_RESULT (STATS_OP_SET_SIZE, err);
+
+  /*Set the size of the target */
+  err = STATS_RPC (STATS_RPC_FILE_SET_SIZE,
+		   file_set_size (node->nn->port, size));
+
+  /*The cached blocks and the stat information are stale now */
+  cache_invalidate (&node->nn->cache);
+  NODE_STAT_INVALIDATE (node);
+
+  /*Return the result of operations */
+  return STATS_RESULT (STATS_OP_SET_SIZE, err);
 }				/*netfs_attempt_set_size */
 
 /*---------------------------------------------------------------------------*/
@@ -380,20 +1049,37 @@ error_t
   netfs_attempt_statfs
   (struct iouser * cred, struct node * node, fsys_statfsbuf_t * st)
 {
-  LOG_MSG ("netfs_attempt_statfs");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_statfs");
+  STATS_CALL (STATS_OP_STATFS);
 
   /*Operation is not supported */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_STATFS, EOPNOTSUPP);
 }				/*netfs_attempt_statfs */
 
 /*---------------------------------------------------------------------------*/
 /*Syncs the filesystem*/
 error_t netfs_attempt_syncfs (struct iouser * cred, int wait)
 {
-  LOG_MSG ("netfs_attempt_syncfs");
+  LOG_AT (LOG_READ, LOG_LEVEL_DEBUG, "netfs_attempt_syncfs");
+  STATS_CALL (STATS_OP_SYNCFS);
 
-  /*Everythin OK */
-  return 0;
+  error_t err = 0;
+
+  /*Write the buffered data of all nodes to the target */
+  err = writeback_flush_all ();
+
+  /*If the target has never been accessed, there is nothing more to sync */
+  if (!MACH_PORT_VALID (netfs_root_node->nn->port))
+    return STATS_RESULT (STATS_OP_SYNCFS, err);
+
+  /*Ask the target to sync the filesystem, too */
+  error_t e = STATS_RPC (STATS_RPC_FILE_SYNCFS,
+			 file_syncfs (netfs_root_node->nn->port, wait, 0));
+  if (!err && (e != EOPNOTSUPP))
+    err = e;
+
+  /*Return the result of operations */
+  return STATS_RESULT (STATS_OP_SYNCFS, err);
 }				/*netfs_attempt_syncfs */
 
 /*---------------------------------------------------------------------------*/
@@ -403,54 +1089,154 @@ error_t
   (struct iouser * user,
    struct node * dir, struct node * file, char *name, int excl)
 {
-  LOG_MSG ("netfs_attempt_link");
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_link");
+  STATS_CALL (STATS_OP_LINK);
 
-  /*Operation not supported */
-  return EOPNOTSUPP;
-}				/*netfs_attempt_link */
+  error_t err = 0;
 
-/*---------------------------------------------------------------------------*/
-/*Attempts to create an anonymous file related to `dir` with `mode`*/
-error_t
-  netfs_attempt_mkfile
-  (struct iouser * user, struct node * dir, mode_t mode, struct node ** node)
-{
-  LOG_MSG ("netfs_attempt_mkfile");
+  /*Only the directory mode has directories */
+  if (!directory)
+    return STATS_RESULT (STATS_OP_LINK, EOPNOTSUPP);
 
-  /*Unlock the directory */
-  mutex_unlock (&dir->lock);
+  /*Neither node is locked by libnetfs; hold our own reference to the
+     target of the file, so that the directory can be locked alone */
+  mach_port_t port = MACH_PORT_NULL;
 
-  /*Operation not supported */
-  return EOPNOTSUPP;
-}				/*netfs_attempt_mkfile */
+  mutex_lock (&file->lock);
+  err = resolve_target (file);
+  if (!err)
+    err = node_get_port (file, &port);
+  mutex_unlock (&file->lock);
+  if (err)
+    return STATS_RESULT (STATS_OP_LINK, err);
 
-/*---------------------------------------------------------------------------*/
-/*Reads the contents of symlink `node` into `buf`*/
+  mutex_lock (&dir->lock);
+
+  /*The user must be allowed to modify the directory */
+  err = netfs_validate_stat (dir, user);
+  if (!err)
+    err = fshelp_access (&dir->nn_stat, S_IWRITE, user);
+
+  /*Link the target of the file into the target of the directory */
+  if (!err)
+    err = STATS_RPC (STATS_RPC_DIR_LINK,
+		     dir_link (dir->nn->port, port, name, excl));
+
+  if (!err)
+    dir_entry_created (dir, name);
+
+  mutex_unlock (&dir->lock);
+  PORT_DEALLOC (port);
+
+  /*The file has got one more link */
+  if (!err)
+    {
+      mutex_lock (&file->lock);
+      NODE_STAT_INVALIDATE (file);
+      mutex_unlock (&file->lock);
+    }
+
+  /*Return the result of operations */
+  return STATS_RESULT (STATS_OP_LINK, err);
+}				/*netfs_attempt_link */
+
+/*---------------------------------------------------------------------------*/
+/*Attempts to create an anonymous file related to `dir` with `mode`*/
+error_t
+  netfs_attempt_mkfile
+  (struct iouser * user, struct node * dir, mode_t mode, struct node ** node)
+{
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "netfs_attempt_mkfile");
+  STATS_CALL (STATS_OP_MKFILE);
+
+  /*Unlock the directory */
+  mutex_unlock (&dir->lock);
+
+  /*Operation not supported */
+  return STATS_RESULT (STATS_OP_MKFILE, EOPNOTSUPP);
+}				/*netfs_attempt_mkfile */
+
+/*---------------------------------------------------------------------------*/
+/*Reads the contents of symlink `node` into `buf`*/
 error_t
   netfs_attempt_readlink (struct iouser * user, struct node * node, char *buf)
 {
-  LOG_MSG ("netfs_attempt_readlink");
+  LOG_AT (LOG_READ, LOG_LEVEL_DEBUG, "netfs_attempt_readlink");
+  STATS_CALL (STATS_OP_READLINK);
 
   /*Operation not supported (why?..) */
-  return EOPNOTSUPP;
+  return STATS_RESULT (STATS_OP_READLINK, EOPNOTSUPP);
 }				/*netfs_attempt_readlink */
 
 /*---------------------------------------------------------------------------*/
-/*Reads from file `node` up to `len` bytes from `offset` into `data`*/
-error_t
-  netfs_attempt_read
-  (struct iouser * cred,
-   struct node * np, loff_t offset, size_t * len, void *data)
+/*Reads from node `np` up to `len` bytes from `offset` into `data` and
+  reports the number of bytes which had to be copied to do so. If `unlock`
+  is set, the node is unlocked while the block cache is read, so that the
+  clients reading the same blocks share the requests to the target.*/
+static
+  error_t
+  read_node
+  (struct node *np, loff_t offset, size_t * len, void *data,
+   size_t * copied, int unlock)
 {
-  LOG_MSG ("netfs_attempt_read");
-
   error_t err = 0;
 
+  /*The port the block cache reads from */
+  mach_port_t port;
+
+  /*Find the target if this has not been done yet */
+  err = resolve_target (np);
+  if (err)
+    return err;
+
+  /*The target must see the data written to the node before */
+  if (np->nn->wb.extents)
+    {
+      err = writeback_flush (np);
+      if (err)
+	return err;
+    }
+
+  /*If the block cache is enabled, serve the request from it */
+  if (CACHE_ENABLED)
+    {
+      /*hold our own reference to the target if the node is unlocked,
+         since the target may be replaced meanwhile */
+      port = np->nn->port;
+      if (unlock)
+	{
+	  err = node_get_port (np, &port);
+	  if (err)
+	    return err;
+	  mutex_unlock (&np->lock);
+	}
+
+      err = cache_read (&np->nn->cache, port, offset, len, data);
+
+      if (unlock)
+	{
+	  mutex_lock (&np->lock);
+	  PORT_DEALLOC (port);
+	}
+
+      /*everything we return has been copied out of the cache */
+      *copied = err ? 0 : *len;
+      return err;
+    }
+
+  /*Send the requests for the chunks of a large read at once */
+  if (PIPELINE_READ (*len))
+    return pipeline_read (np->nn->port, offset, len, data, copied);
+
   /*Obtain a pointer to the first byte of the supplied buffer */
   char *buf = data;
 
+  /*Nothing has been copied yet */
+  *copied = 0;
+
   /*Try to read the requested information from the file */
-  err = io_read (np->nn->port, &buf, len, offset, *len);
+  err = STATS_RPC (STATS_RPC_IO_READ,
+		   io_read (np->nn->port, &buf, len, offset, *len));
 
   /*If some data has been read successfully */
   if (!err && (buf != data))
@@ -458,6 +1244,7 @@ error_t
       /*copy the data from the buffer into which it has just been read into
          the supplied receiver */
       memcpy (data, buf, *len);
+      *copied = *len;
 
       /*unmap the new buffer */
       munmap (buf, *len);
@@ -465,6 +1252,35 @@ error_t
 
   /*Return the result of reading */
   return err;
+}				/*read_node */
+
+/*---------------------------------------------------------------------------*/
+/*Reads from file `node` up to `len` bytes from `offset` into `data`*/
+error_t
+  netfs_attempt_read
+  (struct iouser * cred,
+   struct node * np, loff_t offset, size_t * len, void *data)
+{
+  LOG_AT (LOG_READ, LOG_LEVEL_DEBUG, "netfs_attempt_read");
+  STATS_CALL (STATS_OP_READ);
+
+  error_t err = 0;
+
+  /*The number of bytes copied while reading */
+  size_t copied;
+
+  /*Read the data */
+  err = read_node (np, offset, len, data, &copied, 1);
+  STATS_ADD (stats_read_copied, copied);
+  if (!err)
+    STATS_ADD (stats_read_bytes, *len);
+
+  /*If the target has died, find the new one for the next readers */
+  if (TARGET_DEAD (err))
+    retrace_target (np);
+
+  /*Return the result of reading */
+  return STATS_RESULT (STATS_OP_READ, err);
 }				/*netfs_attempt_read */
 
 /*---------------------------------------------------------------------------*/
@@ -474,19 +1290,143 @@ error_t
   (struct iouser * cred,
    struct node * node, loff_t offset, size_t * len, void *data)
 {
-  LOG_MSG ("netfs_attempt_write");
+  LOG_AT (LOG_READ, LOG_LEVEL_DEBUG, "netfs_attempt_write");
+  STATS_CALL (STATS_OP_WRITE);
 
-  return 0;
+  error_t err = 0;
+
+  /*The number of bytes written */
+  vm_size_t amount = 0;
+
+  /*Find the target if this has not been done yet */
+  err = resolve_target (node);
+  if (err)
+    return STATS_RESULT (STATS_OP_WRITE, err);
+
+  /*The size and the times of the file are going to change */
+  NODE_STAT_INVALIDATE (node);
+
+  /*If the data is small enough, just buffer it */
+  if (WRITEBACK_ENABLED && (*len < writeback_size))
+    {
+      err = writeback_write (node, offset, *len, data);
+      cache_invalidate_range (&node->nn->cache, offset, *len);
+      if (!err)
+	STATS_ADD (stats_write_bytes, *len);
+      return STATS_RESULT (STATS_OP_WRITE, err);
+    }
+
+  /*Large writes go straight to the target, but after the data buffered
+     before them */
+  if (node->nn->wb.extents)
+    {
+      err = writeback_flush (node);
+      if (err)
+	return STATS_RESULT (STATS_OP_WRITE, err);
+    }
+
+  /*Forward the data to the target; MIG sends buffers larger than what fits
+     in a message out of line, and the data the client has sent out of line
+     is page-aligned, so large writes are passed on by mapping the pages
+     instead of copying them */
+  err = STATS_RPC (STATS_RPC_IO_WRITE,
+		   io_write (node->nn->port, data, *len, offset, &amount));
+  if (TARGET_DEAD (err))
+    retrace_target (node);
+
+  /*Drop the cached blocks covering the region, even if only a part of it
+     has been written */
+  cache_invalidate_range (&node->nn->cache, offset, *len);
+
+  /*Report the number of bytes actually written */
+  if (!err)
+    {
+      *len = amount;
+      STATS_ADD (stats_write_bytes, amount);
+    }
+
+  /*Return the result of writing */
+  return STATS_RESULT (STATS_OP_WRITE, err);
 }				/*netfs_attempt_write */
 
 /*---------------------------------------------------------------------------*/
 /*Frees all storage associated with the node*/
 void netfs_node_norefs (struct node *np)
 {
+  STATS_CALL (STATS_OP_NODE_NOREFS);
+
+  /*Only make the node unreachable under `netfs_node_refcnt_lock`, which
+     libnetfs holds here; the rest of the destruction takes locks and
+     sends messages, so it is done with the spin lock released (nobody
+     can find the node any more by then) */
+  node_forget (np);
+  spin_unlock (&netfs_node_refcnt_lock);
+
   /*Destroy the node */
   node_destroy (np);
+
+  spin_lock (&netfs_node_refcnt_lock);
 }				/*netfs_node_norefs */
 
+/*---------------------------------------------------------------------------*/
+/*Appends the runtime options of the filter to `argz` (overrides the libnetfs
+  version, which fsysopts and file_get_fs_options reach); the counters of
+  the filter follow the standard options*/
+error_t netfs_append_args (char **argz, size_t * argz_len)
+{
+  error_t err = 0;
+
+  /*Append the options of libnetfs */
+  err = netfs_append_std_options (argz, argz_len);
+
+  /*Report what the filter has done so far */
+  if (!err)
+    err = stats_append (argz, argz_len);
+
+  return err;
+}				/*netfs_append_args */
+
+/*---------------------------------------------------------------------------*/
+/*Drops a reference to the open `po` and frees it when the last one is gone
+  (overrides the libnetfs version, which it follows); the read-ahead stream
+  of the open is forgotten first, since a new open may get the same address*/
+void netfs_release_peropen (struct peropen *po)
+{
+  /*Lock the node of the open */
+  mutex_lock (&po->np->lock);
+
+  /*If the open is still in use, stop */
+  if (--po->refcnt)
+    {
+      mutex_unlock (&po->np->lock);
+      return;
+    }
+
+  /*Forget how the open has been reading the node */
+  readahead_forget (po->np, po);
+
+  if (po->root_parent)
+    mach_port_deallocate (mach_task_self (), po->root_parent);
+
+  if (po->shadow_root && (po->shadow_root != po->np))
+    {
+      mutex_lock (&po->shadow_root->lock);
+      netfs_nput (po->shadow_root);
+    }
+  if (po->shadow_root_parent)
+    mach_port_deallocate (mach_task_self (), po->shadow_root_parent);
+
+  /*Release the lock on the file the open may still hold */
+  if (po->lock_status != LOCK_UN)
+    fshelp_acquire_lock (&po->np->userlock, &po->lock_status,
+			 &po->np->lock, LOCK_UN);
+
+  /*Drop the reference to the node held by the open */
+  netfs_nput (po->np);
+
+  free (po);
+}				/*netfs_release_peropen */
+
 /*---------------------------------------------------------------------------*/
 /*Implements file_get_translator_cntl as described in <hurd/fs.defs>
   (according to diskfs_S_file_get_translator_cntl)*/
@@ -494,9 +1434,11 @@ kern_return_t
   netfs_S_file_get_translator_cntl
   (struct protid *user, mach_port_t * cntl, mach_msg_type_name_t * cntltype)
 {
+  STATS_CALL (STATS_OP_FILE_GET_TRANSLATOR_CNTL);
+
   /*If the information about the user is missing */
   if (!user)
-    return EOPNOTSUPP;
+    return STATS_RESULT (STATS_OP_FILE_GET_TRANSLATOR_CNTL, EOPNOTSUPP);
 
   error_t err = 0;
 
@@ -528,16 +1470,711 @@ kern_return_t
   mutex_unlock (&np->lock);
 
   /*Return the result of operations */
-  return err;
+  return STATS_RESULT (STATS_OP_FILE_GET_TRANSLATOR_CNTL, err);
 }				/*netfs_S_file_get_translator_cntl */
 
+/*---------------------------------------------------------------------------*/
+/*Implements io_read as described in <hurd/io.defs> (overrides the libnetfs
+  version). Large reads are forwarded to the target with the buffer of the
+  reply, so the out-of-line pages returned by the target go back to the
+  client without being copied.*/
+kern_return_t
+  netfs_S_io_read
+  (struct protid * user,
+   char **data,
+   mach_msg_type_number_t * datalen,
+   loff_t offset, mach_msg_type_number_t amount)
+{
+  STATS_CALL (STATS_OP_IO_READ);
+
+  /*If the information about the user is missing */
+  if (!user)
+    return STATS_RESULT (STATS_OP_IO_READ, EOPNOTSUPP);
+
+  error_t err = 0;
+
+  /*The offset to start reading at */
+  loff_t start;
+
+  /*The number of bytes copied by the filter to serve this request */
+  size_t copied = 0;
+
+  /*Set if we have mapped the buffer for the reply ourselves */
+  int alloced = 0;
+
+  /*Obtain the node for which we are called */
+  node_t *np = user->po->np;
+
+  /*Lock the node */
+  mutex_lock (&np->lock);
+
+  /*If the node has not been opened for reading, stop */
+  if ((user->po->openstat & O_READ) == 0)
+    {
+      mutex_unlock (&np->lock);
+      return STATS_RESULT (STATS_OP_IO_READ, EBADF);
+    }
+
+  /*Find out where to start reading */
+  start = (offset == -1) ? user->po->filepointer : offset;
+
+  if (start < 0)
+    err = EINVAL;
+  else if ((amount >= READ_ZERO_COPY_MIN)
+	   && (CACHE_ENABLED ? !cache_holds (&np->nn->cache, start, amount)
+	       : !PIPELINE_READ (amount)))
+    {
+      /*(the reads split into chunks are assembled in our own buffer
+         below instead, as are the reads the block cache holds all the
+         data for) */
+
+      /*find the target if this has not been done yet */
+      err = resolve_target (np);
+
+      /*the target must see the data written to the node before */
+      if (!err && np->nn->wb.extents)
+	err = writeback_flush (np);
+
+      /*let the target fill in the reply; if it returns the data out of
+         line, `*data` will point to its pages, which MIG will pass on to
+         the client and deallocate afterwards */
+      if (!err)
+	err = STATS_RPC (STATS_RPC_IO_READ,
+			 io_read (np->nn->port, data, datalen, start,
+				  amount));
+
+      /*the data is not cached, but the blocks following it may be read
+         ahead, so that the next sequential read finds them in the cache */
+      if (!err)
+	readahead_note (np, user->po, start, *datalen);
+    }
+  else
+    {
+      /*if the buffer supplied by MIG is too small, map a larger one */
+      if (amount > *datalen)
+	{
+	  *data = mmap (0, amount, PROT_READ | PROT_WRITE, MAP_ANON, 0, 0);
+	  if (*data == MAP_FAILED)
+	    {
+	      mutex_unlock (&np->lock);
+	      return STATS_RESULT (STATS_OP_IO_READ, ENOMEM);
+	    }
+	  alloced = 1;
+	}
+      *datalen = amount;
+
+      /*read the data into the buffer; the reads at the file pointer
+         must not overlap, so the node stays locked for them */
+      size_t len = amount;
+      err = read_node (np, start, &len, *data, &copied, offset != -1);
+      *datalen = len;
+
+      /*if the reads of this open are sequential, prefetch the data the
+         client will ask for next */
+      if (!err)
+	readahead_note (np, user->po, start, len);
+    }
+
+  /*If the target has died, find the new one for the next readers */
+  if (TARGET_DEAD (err))
+    retrace_target (np);
+
+  /*If the file pointer has been used, move it */
+  if ((offset == -1) && !err)
+    user->po->filepointer += *datalen;
+
+  /*Unlock the node */
+  mutex_unlock (&np->lock);
+
+  /*If we have mapped the buffer, unmap the part of it which is not used */
+  if (alloced)
+    {
+      if (err)
+	munmap (*data, amount);
+      else if (round_page (*datalen) < round_page (amount))
+	munmap (*data + round_page (*datalen),
+		round_page (amount) - round_page (*datalen));
+    }
+
+  /*Account for the request */
+  if (!err)
+    {
+      STATS_ADD (stats_reads, 1);
+      STATS_ADD (stats_read_bytes, *datalen);
+      STATS_ADD (stats_read_copied, copied);
+    }
+
+  LOG_AT (LOG_READ, LOG_LEVEL_DEBUG,
+	  "netfs_S_io_read: %lu bytes read, %lu bytes copied.",
+	  (unsigned long) *datalen, (unsigned long) copied);
+
+  /*Return the result of operations */
+  return STATS_RESULT (STATS_OP_IO_READ, err);
+}				/*netfs_S_io_read */
+
+/*---------------------------------------------------------------------------*/
+/*Implements io_map as described in <hurd/io.defs> (overrides the libnetfs
+  version). The client receives the memory objects of the target, so its
+  page faults are served by the pager of the target directly.*/
+kern_return_t
+  netfs_S_io_map
+  (struct protid * user,
+   mach_port_t * rdobj,
+   mach_msg_type_name_t * rdtype,
+   mach_port_t * wrobj, mach_msg_type_name_t * wrtype)
+{
+  STATS_CALL (STATS_OP_IO_MAP);
+
+  /*If the information about the user is missing */
+  if (!user)
+    return STATS_RESULT (STATS_OP_IO_MAP, EOPNOTSUPP);
+
+  error_t err = 0;
+
+  /*Obtain the node for which we are called */
+  node_t *np = user->po->np;
+
+  /*Fetch the memory objects from the target, after giving it the data
+     written to the node before */
+  mutex_lock (&np->lock);
+  err = resolve_target (np);
+  if (!err && np->nn->wb.extents)
+    err = writeback_flush (np);
+  if (!err)
+    err = STATS_RPC (STATS_RPC_IO_MAP, io_map (np->nn->port, rdobj, wrobj));
+  mutex_unlock (&np->lock);
+
+  if (err)
+    return STATS_RESULT (STATS_OP_IO_MAP, err);
+
+  /*Do not give the client more access than its open allows */
+  if (!(user->po->openstat & O_READ) && MACH_PORT_VALID (*rdobj))
+    {
+      PORT_DEALLOC (*rdobj);
+      *rdobj = MACH_PORT_NULL;
+    }
+  if (!(user->po->openstat & O_WRITE) && MACH_PORT_VALID (*wrobj))
+    {
+      PORT_DEALLOC (*wrobj);
+      *wrobj = MACH_PORT_NULL;
+    }
+
+  LOG_AT (LOG_READ, LOG_LEVEL_DEBUG,
+	  "netfs_S_io_map: Read object: %lu, write object: %lu.",
+	  (unsigned long) *rdobj, (unsigned long) *wrobj);
+
+  /*The rights are ours to give away */
+  *rdtype = MACH_MSG_TYPE_MOVE_SEND;
+  *wrtype = MACH_MSG_TYPE_MOVE_SEND;
+
+  return 0;
+}				/*netfs_S_io_map */
+
+/*---------------------------------------------------------------------------*/
+/*Starts serving the node whose startup is reported to `bootstrap_port`;
+  the process-wide initialization must have been done*/
+static void serve_node (mach_port_t bootstrap_port)
+{
+  error_t err = 0;
+
+  /*Obtain a port to the underlying node opened as O_NOTRANS */
+  underlying_node = netfs_startup (bootstrap_port, O_READ | O_NOTRANS);
+  startup_step ("netfs startup");
+
+  /*Initialize the root node */
+  err = node_init_root (underlying_node, netfs_root_node);
+  if (err)
+    error (EXIT_FAILURE, err, "Failed to initialize the root node");
+  LOG_MSG ("\tRoot node address: 0x%lX", (unsigned long) netfs_root_node);
+  startup_step ("root node initialization");
+
+  /*Start the thread receiving the change notifications of the targets */
+  err = notify_start ();
+  if (err)
+    error (EXIT_FAILURE, err, "Failed to start the notification thread");
+
+  /*Start the thread reading the data ahead of the clients */
+  err = readahead_start ();
+  if (err)
+    error (EXIT_FAILURE, err, "Failed to start the prefetch thread");
+
+  /*Start the threads reading the chunks of large reads */
+  err = pipeline_start ();
+  if (err)
+    error (EXIT_FAILURE, err, "Failed to start the chunk reading threads");
+
+  /*If the written data should be buffered, start the thread flushing it */
+  if (WRITEBACK_ENABLED)
+    {
+      err = writeback_start ();
+      if (err)
+	error (EXIT_FAILURE, err, "Failed to start the flusher thread");
+    }
+  startup_step ("helper threads");
+
+  /*Obtain stat information about the underlying node */
+  err = STATS_RPC (STATS_RPC_IO_STAT,
+		   io_stat (underlying_node, &underlying_node_stat));
+  if (err)
+    error (EXIT_FAILURE, err,
+	   "Cannot obtain stat information about the underlying node");
+
+  /*Obtain the ID of the current process */
+  fsid = getpid ();
+
+  /*Setup the root node */
+  char *path = target_path (target_name);
+  if (!path)
+    error (EXIT_FAILURE, ENOMEM, "Could not allocate the target name");
+  setup_root (netfs_root_node, underlying_node, &underlying_node_stat, path);
+  netfs_root_node->nn_stat.st_ino = FILTER_ROOT_INODE;
+  startup_step ("root node setup");
+
+  /*Filter the translator stack under ourselves, unless this should be done
+     on the first access */
+  if (!lazy)
+    {
+      mutex_lock (&netfs_root_node->lock);
+      err = resolve_target (netfs_root_node);
+      mutex_unlock (&netfs_root_node->lock);
+      if (err)
+	error
+	  (EXIT_FAILURE, err,
+	   "Could not trace the translator stack on the underlying node");
+      startup_step ("stack trace");
+    }
+
+  LOG_AT (LOG_GENERAL, LOG_LEVEL_INFO,
+	  ">> Initialization complete. Entering netfs server loop...");
+
+  /*Start serving clients */
+  server_loop ();
+}				/*serve_node */
+
+/*---------------------------------------------------------------------------*/
+/*Queues the node whose startup is to be reported to `bootstrap` to be
+  served by a new filter filtering out the translator `name` (in the
+  zygote mode); the port is consumed on success*/
+static error_t zygote_queue_node (mach_port_t bootstrap, char *name)
+{
+  zygote_request_t *req;
+
+  req = malloc (sizeof (zygote_request_t));
+  if (!req)
+    return ENOMEM;
+
+  /*the name lives in the request message, which is gone once we reply */
+  req->name = strdup (name);
+  if (!req->name)
+    {
+      free (req);
+      return ENOMEM;
+    }
+  req->bootstrap = bootstrap;
+  req->next = NULL;
+
+  /*Append the request to the queue and wake up the fork loop */
+  mutex_lock (&zygote_lock);
+  if (zygote_tail)
+    zygote_tail->next = req;
+  else
+    zygote_head = req;
+  zygote_tail = req;
+  condition_signal (&zygote_cond);
+  mutex_unlock (&zygote_lock);
+
+  return 0;
+}				/*zygote_queue_node */
+
+/*---------------------------------------------------------------------------*/
+/*Destroys a control port of the zygote inherited by a forked filter*/
+static error_t zygote_drop_control (void *port)
+{
+  ports_destroy_right (port);
+  return 0;
+}				/*zygote_drop_control */
+
+/*---------------------------------------------------------------------------*/
+/*Turns the calling process, just forked off the zygote, into a filter
+  serving the node of `req`; never returns*/
+static void zygote_child (zygote_request_t * req)
+{
+  zygote_request_t *other;
+  mach_port_t bootstrap = req->bootstrap;
+
+  gettimeofday (&startup_begin, NULL);
+  startup_mark = startup_begin;
+
+  /*Only the fork loop exists in the child, so the libports bookkeeping
+     holds no requests; let the ports of the child serve them again */
+  ports_resume_bucket_rpcs (netfs_port_bucket);
+
+  /*The nodes queued after ours are served by the zygote itself */
+  mutex_init (&zygote_lock);
+  for (; zygote_head; zygote_head = other)
+    {
+      other = zygote_head->next;
+      PORT_DEALLOC (zygote_head->bootstrap);
+      free (zygote_head->name);
+      free (zygote_head);
+    }
+  zygote_tail = NULL;
+
+  /*Nobody can reach the control port of the zygote in the child */
+  ports_class_iterate (netfs_control_class, zygote_drop_control);
+  signal (SIGCHLD, SIG_DFL);
+
+  zygote = 0;
+  target_name = req->name;
+  free (req);
+
+  RESTART_LOG ();
+  LOG_AT (LOG_GENERAL, LOG_LEVEL_INFO,
+	  ">> Forked from the zygote. Target name: '%s'.", target_name);
+  serve_node (bootstrap);
+}				/*zygote_child */
+
+/*---------------------------------------------------------------------------*/
+/*Serves the requests to the zygote in a thread of its own*/
+static any_t zygote_server_thread (any_t arg)
+{
+  server_loop ();
+  return 0;
+}				/*zygote_server_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Forks a new filter for every node queued by fsys_forward (in the zygote
+  mode); never returns. The forks are done by the main thread, which
+  serves no requests and holds no locks, while the requests are held off,
+  so that no thread of the zygote is in the middle of one at the fork; the
+  locks the other threads might still hold (those of the log and of
+  malloc) are reset by the child or by the C library.*/
+static void zygote_loop (void)
+{
+  error_t err = 0;
+  zygote_request_t *req;
+  pid_t pid;
+
+  for (;;)
+    {
+      /*wait for a node to serve */
+      mutex_lock (&zygote_lock);
+      while (!zygote_head)
+	condition_wait (&zygote_cond, &zygote_lock);
+
+      req = zygote_head;
+      zygote_head = req->next;
+      if (!zygote_head)
+	zygote_tail = NULL;
+      mutex_unlock (&zygote_lock);
+
+      /*wait until no thread is serving a request */
+      err = ports_inhibit_bucket_rpcs (netfs_port_bucket);
+      if (!err)
+	{
+	  pid = fork ();
+	  if (pid == 0)
+	    zygote_child (req);
+	  err = (pid < 0) ? errno : 0;
+
+	  ports_resume_bucket_rpcs (netfs_port_bucket);
+	}
+
+      if (err)
+	{
+	  LOG_AT (LOG_GENERAL, LOG_LEVEL_ERROR,
+		  "zygote_loop: Could not fork a filter for '%s': %d.",
+		  req->name, (int) err);
+	}
+      else
+	{
+	  LOG_AT (LOG_GENERAL, LOG_LEVEL_INFO,
+		  "zygote_loop: Forked filter %d for '%s'.", (int) pid,
+		  req->name);
+	}
+
+      /*the child reports the startup */
+      PORT_DEALLOC (req->bootstrap);
+      free (req->name);
+      free (req);
+    }
+}				/*zygote_loop */
+
+/*---------------------------------------------------------------------------*/
+/*Implements fsys_forward as described in <hurd/fsys.defs> (overrides the
+  libnetfs version). A filter started with --server hands the node it has
+  been started on over to us together with its name and the name of the
+  translator to filter out; the file is then served by a root node of this
+  filter, shared by all the files sitting on the same node.*/
+kern_return_t
+  netfs_S_fsys_forward
+  (mach_port_t server,
+   mach_port_t reply,
+   mach_msg_type_name_t reply_type,
+   mach_port_t requestor, char *argz, size_t argz_len)
+{
+  STATS_CALL (STATS_OP_FSYS_FORWARD);
+
+  error_t err = 0;
+
+  /*Our control port */
+  struct port_info *pi;
+
+  /*The name of the translator to filter out */
+  char *name, *path;
+
+  /*The control port of the new file and the node it sits on */
+  instance_t *inst;
+  mach_port_t underlying;
+  io_statbuf_t stat;
+
+  /*The root node serving the file */
+  node_t *np = NULL;
+
+  /*Only our own control port accepts the files */
+  pi = ports_lookup_port (netfs_port_bucket, server, netfs_control_class);
+  if (!pi)
+    return STATS_RESULT (STATS_OP_FSYS_FORWARD, EOPNOTSUPP);
+  ports_port_deref (pi);
+
+  /*Skip the name of the other filter */
+  name = argz_next (argz, argz_len, argz);
+  if (!name)
+    return STATS_RESULT (STATS_OP_FSYS_FORWARD, EINVAL);
+
+  /*The zygote serves the file in a new process, forked once we have
+     replied */
+  if (zygote)
+    return STATS_RESULT (STATS_OP_FSYS_FORWARD,
+			 zygote_queue_node (requestor, name));
+
+  path = target_path (name);
+  if (!path)
+    return STATS_RESULT (STATS_OP_FSYS_FORWARD, ENOMEM);
+
+  err = instance_create (&inst);
+  if (err)
+    {
+      free (path);
+      return STATS_RESULT (STATS_OP_FSYS_FORWARD, err);
+    }
+
+  /*Report the startup of the file to the filesystem it sits on in place
+     of the other filter */
+  err = fsys_startup
+    (requestor, O_READ | O_NOTRANS, ports_get_right (inst),
+     MACH_MSG_TYPE_MAKE_SEND, &underlying);
+  if (err)
+    {
+      free (path);
+      instance_fail (inst, err);
+      ports_port_deref (inst);
+      return STATS_RESULT (STATS_OP_FSYS_FORWARD, err);
+    }
+
+  err = STATS_RPC (STATS_RPC_IO_STAT, io_stat (underlying, &stat));
+  if (err)
+    {
+      free (path);
+      PORT_DEALLOC (underlying);
+      instance_fail (inst, err);
+      ports_port_deref (inst);
+      return STATS_RESULT (STATS_OP_FSYS_FORWARD, err);
+    }
+
+  /*If the file is served already, share its root node */
+  np = instance_find (stat.st_ino, stat.st_fsid, path);
+  if (np)
+    {
+      free (path);
+      PORT_DEALLOC (underlying);
+
+      instance_attach (inst, np, stat.st_ino, stat.st_fsid);
+      netfs_nrele (np);
+    }
+  else
+    {
+      err = node_create (&np);
+      if (err)
+	{
+	  free (path);
+	  PORT_DEALLOC (underlying);
+	  instance_fail (inst, err);
+	  ports_port_deref (inst);
+	  return STATS_RESULT (STATS_OP_FSYS_FORWARD, err);
+	}
+
+      setup_root (np, underlying, &stat, path);
+
+      /*the root must be known to the instance before the stack is traced,
+         since tracing may ask the instance for it */
+      instance_attach (inst, np, stat.st_ino, stat.st_fsid);
+
+      /*filter the translator stack under the file, unless this should be
+         done on the first access (if this fails, the first access will
+         try again) */
+      mutex_lock (&np->lock);
+      if (!lazy)
+	resolve_target (np);
+      netfs_nput (np);
+    }
+
+  LOG_AT (LOG_NODE, LOG_LEVEL_INFO,
+	  "netfs_S_fsys_forward: Serving '%s' with 0x%lX.", name,
+	  (unsigned long) np);
+
+  /*The other filter has handed its bootstrap port over to us */
+  PORT_DEALLOC (requestor);
+  ports_port_deref (inst);
+
+  return 0;
+}				/*netfs_S_fsys_forward */
+
+/*---------------------------------------------------------------------------*/
+/*Implements fsys_getroot as described in <hurd/fsys.defs> (overrides the
+  libnetfs version). The files handed over to us by other filters have
+  their own control ports, which give their own root nodes.*/
+kern_return_t
+  netfs_S_fsys_getroot
+  (mach_port_t cntl,
+   mach_port_t reply,
+   mach_msg_type_name_t reply_type,
+   mach_port_t dotdot,
+   uid_t * uids,
+   mach_msg_type_number_t nuids,
+   uid_t * gids,
+   mach_msg_type_number_t ngids,
+   int flags,
+   retry_type * do_retry,
+   char *retry_name,
+   mach_port_t * retry_port, mach_msg_type_name_t * retry_port_type)
+{
+  STATS_CALL (STATS_OP_FSYS_GETROOT);
+
+  error_t err = 0;
+
+  /*The control port and the root node it gives */
+  struct port_info *pi;
+  node_t *np;
+
+  /*The user asking for the root and the new open of the root */
+  struct iouser *cred;
+  struct protid *newpi;
+  struct peropen peropen_context = {.root_parent = dotdot };
+
+  /*Find the root node the control port gives */
+  pi = ports_lookup_port (netfs_port_bucket, cntl, netfs_control_class);
+  if (pi)
+    {
+      ports_port_deref (pi);
+
+      /*the node of the zygote is only used to reach it */
+      if (zygote)
+	return STATS_RESULT (STATS_OP_FSYS_GETROOT, EOPNOTSUPP);
+
+      np = netfs_root_node;
+      netfs_nref (np);
+    }
+  else
+    {
+      np = instance_root (cntl);
+      if (!np)
+	return STATS_RESULT (STATS_OP_FSYS_GETROOT, EOPNOTSUPP);
+    }
+
+  err = iohelp_create_complex_iouser (&cred, uids, nuids, gids, ngids);
+  if (err)
+    {
+      netfs_nrele (np);
+      return STATS_RESULT (STATS_OP_FSYS_GETROOT, err);
+    }
+
+  flags &= O_HURD;
+
+  /*The root nodes carry neither translators nor symbolic links of their
+     own, so only the permissions have to be checked */
+  mutex_lock (&np->lock);
+  err = netfs_validate_stat (np, cred);
+  if (!err)
+    err = netfs_check_open_permissions (cred, np, flags, 0);
+
+  if (!err)
+    {
+      flags &= ~OPENONLY_STATE_MODES;
+
+      newpi = netfs_make_protid
+	(netfs_make_peropen (np, flags, &peropen_context), cred);
+      if (newpi)
+	{
+	  PORT_DEALLOC (dotdot);
+
+	  *do_retry = FS_RETRY_NORMAL;
+	  *retry_port = ports_get_right (newpi);
+	  *retry_port_type = MACH_MSG_TYPE_MAKE_SEND;
+	  retry_name[0] = '\0';
+	  ports_port_deref (newpi);
+	}
+      else
+	err = errno;
+    }
+
+  if (err)
+    iohelp_free_iouser (cred);
+  netfs_nput (np);
+
+  return STATS_RESULT (STATS_OP_FSYS_GETROOT, err);
+}				/*netfs_S_fsys_getroot */
+
+/*---------------------------------------------------------------------------*/
+/*Asks the filter sitting on `file` to serve the node we have been started
+  on (`bootstrap` is the port to report our startup to) instead of us*/
+static error_t forward_node (char *file, mach_port_t bootstrap)
+{
+  error_t err = 0;
+
+  /*The node the server sits on and the control port of the server */
+  file_t node;
+  fsys_t fsys;
+
+  /*Our name and the name of the translator to filter out */
+  char *argz = NULL;
+  size_t argz_len = 0;
+
+  node = file_name_lookup (file, O_NOTRANS, 0);
+  if (node == MACH_PORT_NULL)
+    return errno;
+
+  err = STATS_RPC (STATS_RPC_FILE_GET_TRANSLATOR_CNTL,
+		   file_get_translator_cntl (node, &fsys));
+  PORT_DEALLOC (node);
+  if (err)
+    return err;
+
+  err = argz_add (&argz, &argz_len, program_invocation_name);
+  if (!err)
+    err = argz_add (&argz, &argz_len, target_name);
+
+  /*The server reports the startup in our place */
+  if (!err)
+    err = fsys_forward
+      (fsys, bootstrap, MACH_MSG_TYPE_COPY_SEND, argz, argz_len);
+
+  free (argz);
+  PORT_DEALLOC (fsys);
+  return err;
+}				/*forward_node */
+
 /*---------------------------------------------------------------------------*/
 /*Entry point*/
 int main (int argc, char **argv)
 {
   /*Start logging */
   INIT_LOG ();
-  LOG_MSG (">> Starting initialization...");
+  LOG_AT (LOG_GENERAL, LOG_LEVEL_INFO, ">> Starting initialization...");
+
+  /*Start timing the startup */
+  gettimeofday (&startup_begin, NULL);
+  startup_mark = startup_begin;
 
   /*The port on which this translator will be set upon */
   mach_port_t bootstrap_port;
@@ -569,7 +2206,32 @@ int main (int argc, char **argv)
 
       target_name = p;
     }
-  LOG_MSG ("Command line arguments parsed. Target name: '%s'.", target_name);
+
+  /*Open the log if the options have asked for it */
+  log_start ();
+
+  LOG_AT (LOG_GENERAL, LOG_LEVEL_INFO,
+	  "Command line arguments parsed. Target name: '%s'.", target_name);
+  startup_step ("argument parsing");
+
+  /*Obtain the bootstrap port */
+  task_get_bootstrap_port (mach_task_self (), &bootstrap_port);
+
+  /*If there is a filter serving the files of other filters, let it serve
+     our node, too */
+  if (server_file)
+    {
+      err = forward_node (server_file, bootstrap_port);
+      if (!err)
+	{
+	  startup_step ("handing the node over");
+	  LOG_AT (LOG_GENERAL, LOG_LEVEL_INFO,
+		  ">> The node has been handed over to '%s'.", server_file);
+	  return 0;
+	}
+
+      error (0, err, "Could not hand the node over to %s", server_file);
+    }
 
   /*Try to create the root node */
   err = node_create_root (&netfs_root_node);
@@ -577,67 +2239,58 @@ int main (int argc, char **argv)
     error (EXIT_FAILURE, err, "Failed to create the root node");
   LOG_MSG ("Root node created.");
 
-  /*Obtain the bootstrap port */
-  task_get_bootstrap_port (mach_task_self (), &bootstrap_port);
-
   /*Initialize the translator */
   netfs_init ();
-
-  /*Obtain a port to the underlying node opened as O_NOTRANS */
-  underlying_node = netfs_startup (bootstrap_port, O_READ | O_NOTRANS);
-  LOG_MSG ("netfs initialization complete.");
-
-  /*Initialize the root node */
-  err = node_init_root (underlying_node, netfs_root_node);
-  if (err)
-    error (EXIT_FAILURE, err, "Failed to initialize the root node");
-  LOG_MSG ("Root node initialized.");
-  LOG_MSG ("\tRoot node address: 0x%lX", (unsigned long) netfs_root_node);
+  startup_step ("netfs initialization");
 
   /*Map the time for updating node information */
   err = maptime_map (0, 0, &maptime);
   if (err)
     error (EXIT_FAILURE, err, "Failed to map the time");
-  LOG_MSG ("Time mapped.");
+  startup_step ("time mapping");
 
-  /*Obtain stat information about the underlying node */
-  err = io_stat (underlying_node, &underlying_node_stat);
+  /*Find out who we are for tracing the translator stacks */
+  err = trace_init ();
   if (err)
-    error (EXIT_FAILURE, err,
-	   "Cannot obtain stat information about the underlying node");
-  LOG_MSG ("Stat information for undelying node obtained.");
+    error (EXIT_FAILURE, err, "Failed to fetch the identity of the filter");
+  startup_step ("identity lookup");
 
-  /*Obtain the ID of the current process */
-  fsid = getpid ();
-
-  /*Setup the stat information for the root node */
-  netfs_root_node->nn_stat = underlying_node_stat;
-
-  netfs_root_node->nn_stat.st_ino = FILTER_ROOT_INODE;
-  netfs_root_node->nn_stat.st_fsid = fsid;
-  netfs_root_node->nn_stat.st_mode = underlying_node_stat.st_mode;
-
-  netfs_root_node->nn_translated = netfs_root_node->nn_stat.st_mode;
+  /*Share the traced stacks with the other filters, if requested */
+  if (tracetab_file)
+    {
+      err = tracetab_open ();
+      if (err)
+	{
+	  error (0, err, "Could not map the trace table %s", tracetab_file);
+	  free (tracetab_file);
+	  tracetab_file = NULL;
+	}
+      startup_step ("trace table mapping");
+    }
 
-  /*Filter the translator stack under ourselves */
-  err = trace_find (underlying_node, "/hurd/m", O_READ, &target);
+  /*Prepare for serving the files handed over by other filters */
+  err = instance_start ();
   if (err)
-    error
-      (EXIT_FAILURE, err,
-       "Could not trace the translator stack on the underlying node");
+    error (EXIT_FAILURE, err, "Failed to create the instance port class");
 
-  netfs_root_node->nn->port = target;
+  /*In the zygote mode, sit on our node only to be reachable by the
+     filters which will hand their nodes over to us */
+  if (zygote)
+    {
+      underlying_node = netfs_startup (bootstrap_port, O_READ | O_NOTRANS);
 
-  /*Update the timestamps of the root node */
-  fshelp_touch
-    (&netfs_root_node->nn_stat, TOUCH_ATIME | TOUCH_MTIME | TOUCH_CTIME,
-     maptime);
+      /*the forked filters are not waited for */
+      signal (SIGCHLD, SIG_IGN);
 
-  LOG_MSG (">> Initialization complete. Entering netfs server loop...");
+      LOG_AT (LOG_GENERAL, LOG_LEVEL_INFO,
+	      ">> Zygote initialized. Entering netfs server loop...");
+      cthread_detach (cthread_fork (zygote_server_thread, 0));
+      zygote_loop ();
+    }
 
-  /*Start serving clients */
-  for (;;)
-    netfs_server_loop ();
+  /*Serve our own node */
+  serve_node (bootstrap_port);
+  return 0;
 }				/*main */
 
 /*---------------------------------------------------------------------------*/
@@ -46,6 +46,19 @@
 /*The inode for the root node*/
 #define FILTER_ROOT_INODE 1
 /*---------------------------------------------------------------------------*/
+/*Reads at least this large are passed through to the target without
+  copying the data in the filter*/
+#define READ_ZERO_COPY_MIN (64 * 1024)
+/*---------------------------------------------------------------------------*/
+/*Checks whether `err` means that the target translator has gone away*/
+#define TARGET_DEAD(err) \
+  (((err) == EMACH_SEND_INVALID_DEST) || ((err) == MIG_SERVER_DIED))
+/*---------------------------------------------------------------------------*/
+/*The number of attempts to find a new target and the delay (in
+  milliseconds) before the second one (it doubles after each attempt)*/
+#define RETRACE_TRIES 8
+#define RETRACE_DELAY 50
+/*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*--------Global Variables---------------------------------------------------*/
@@ -203,10 +216,63 @@ error_t
 /*Frees all storage associated with the node*/
 void netfs_node_norefs (struct node *np);
 /*---------------------------------------------------------------------------*/
+/*Appends the runtime options of the filter to `argz` (overrides the libnetfs
+  version, which fsysopts and file_get_fs_options reach); the counters of
+  the filter follow the standard options*/
+error_t netfs_append_args (char **argz, size_t * argz_len);
+/*---------------------------------------------------------------------------*/
 /*Implements file_get_translator_cntl as described in <hurd/fs.defs>
   (according to diskfs_S_file_get_translator_cntl)*/
 kern_return_t
   netfs_S_file_get_translator_cntl
   (struct protid *user, mach_port_t * cntl, mach_msg_type_name_t * cntltype);
 /*---------------------------------------------------------------------------*/
+/*Implements io_read as described in <hurd/io.defs> (overrides the libnetfs
+  version)*/
+kern_return_t
+  netfs_S_io_read
+  (struct protid *user,
+   char **data,
+   mach_msg_type_number_t * datalen,
+   loff_t offset, mach_msg_type_number_t amount);
+/*---------------------------------------------------------------------------*/
+/*Implements io_map as described in <hurd/io.defs> (overrides the libnetfs
+  version)*/
+kern_return_t
+  netfs_S_io_map
+  (struct protid *user,
+   mach_port_t * rdobj,
+   mach_msg_type_name_t * rdtype,
+   mach_port_t * wrobj, mach_msg_type_name_t * wrtype);
+/*---------------------------------------------------------------------------*/
+/*Implements fsys_forward as described in <hurd/fsys.defs> (overrides the
+  libnetfs version)*/
+kern_return_t
+  netfs_S_fsys_forward
+  (mach_port_t server,
+   mach_port_t reply,
+   mach_msg_type_name_t reply_type,
+   mach_port_t requestor, char *argz, size_t argz_len);
+/*---------------------------------------------------------------------------*/
+/*Implements fsys_getroot as described in <hurd/fsys.defs> (overrides the
+  libnetfs version)*/
+kern_return_t
+  netfs_S_fsys_getroot
+  (mach_port_t cntl,
+   mach_port_t reply,
+   mach_msg_type_name_t reply_type,
+   mach_port_t dotdot,
+   uid_t * uids,
+   mach_msg_type_number_t nuids,
+   uid_t * gids,
+   mach_msg_type_number_t ngids,
+   int flags,
+   retry_type * do_retry,
+   char *retry_name,
+   mach_port_t * retry_port, mach_msg_type_name_t * retry_port_type);
+/*---------------------------------------------------------------------------*/
+/*Finds the new target of `np` in the background and swaps it in for the
+  dead one*/
+void retrace_target (struct node *np);
+/*---------------------------------------------------------------------------*/
 #endif /*__FILTER_H__*/
@@ -0,0 +1,203 @@
+/*---------------------------------------------------------------------------*/
+/*instance.c*/
+/*---------------------------------------------------------------------------*/
+/*Serving the files handed over to a running filter by other filters (the
+  multiplexed mode)*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <string.h>
+#include <cthreads.h>
+#include <hurd/ports.h>
+#include <hurd/netfs.h>
+/*---------------------------------------------------------------------------*/
+#include "debug.h"
+#include "node.h"
+#include "instance.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The class of the instance control ports (they live in the bucket of
+  libnetfs, so they are served by the threads serving the nodes)*/
+static struct port_class *instance_class;
+/*---------------------------------------------------------------------------*/
+/*The list of all instances*/
+static instance_t *instances;
+/*---------------------------------------------------------------------------*/
+/*The lock protecting the list of instances and their roots*/
+static struct mutex instance_lock = MUTEX_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+/*Signalled when a file is attached to an instance*/
+static struct condition instance_cond = CONDITION_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Called by libports when the last reference to the instance `arg` is gone
+  (the filesystem the file sits on has dropped its control port)*/
+static void instance_clean (void *arg)
+{
+  instance_t *inst = arg, **prevp;
+
+  /*Remove the instance from the list */
+  mutex_lock (&instance_lock);
+  for (prevp = &instances; *prevp; prevp = &(*prevp)->next)
+    if (*prevp == inst)
+      {
+	*prevp = inst->next;
+	break;
+      }
+  mutex_unlock (&instance_lock);
+
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG,
+	  "instance_clean: Instance 0x%lX detached.", (unsigned long) inst);
+
+  /*The root node goes away with the last instance using it */
+  if (inst->root)
+    netfs_nrele (inst->root);
+}				/*instance_clean */
+
+/*---------------------------------------------------------------------------*/
+/*Creates the class of the instance control ports*/
+error_t instance_start (void)
+{
+  instance_class = ports_create_class (instance_clean, 0);
+  if (!instance_class)
+    return ENOMEM;
+
+  return 0;
+}				/*instance_start */
+
+/*---------------------------------------------------------------------------*/
+/*Creates a new control port in `inst`; the file is attached to it later
+  with `instance_attach`*/
+error_t instance_create (instance_t ** inst)
+{
+  error_t err = 0;
+
+  err = ports_create_port (instance_class, netfs_port_bucket,
+			   sizeof (instance_t), inst);
+  if (err)
+    return err;
+
+  (*inst)->root = NULL;
+  (*inst)->err = 0;
+  (*inst)->ino = 0;
+  (*inst)->fsid = 0;
+
+  /*Add the instance to the list */
+  mutex_lock (&instance_lock);
+  (*inst)->next = instances;
+  instances = *inst;
+  mutex_unlock (&instance_lock);
+
+  return 0;
+}				/*instance_create */
+
+/*---------------------------------------------------------------------------*/
+/*Makes `inst` serve the file sitting on the inode `ino` of the filesystem
+  `fsid` with the node `root` and adds a reference to the node*/
+void instance_attach (instance_t * inst, struct node *root, ino_t ino,
+		      dev_t fsid)
+{
+  netfs_nref (root);
+
+  mutex_lock (&instance_lock);
+  inst->root = root;
+  inst->ino = ino;
+  inst->fsid = fsid;
+  mutex_unlock (&instance_lock);
+
+  /*Let the requests which have arrived in the meantime in */
+  condition_broadcast (&instance_cond);
+}				/*instance_attach */
+
+/*---------------------------------------------------------------------------*/
+/*Tells the requests waiting for the file to be attached to `inst` that no
+  file will be, because of `err`, and destroys the control port*/
+void instance_fail (instance_t * inst, error_t err)
+{
+  mutex_lock (&instance_lock);
+  inst->err = err;
+  mutex_unlock (&instance_lock);
+
+  /*Let the requests which have arrived in the meantime go */
+  condition_broadcast (&instance_cond);
+
+  ports_destroy_right (inst);
+}				/*instance_fail */
+
+/*---------------------------------------------------------------------------*/
+/*Finds the root node already serving the file sitting on the inode `ino`
+  of the filesystem `fsid` with the target `target` and adds a reference to
+  it; returns NULL if there is no such node*/
+struct node *instance_find (ino_t ino, dev_t fsid, const char *target)
+{
+  instance_t *inst;
+  struct node *np = NULL;
+
+  mutex_lock (&instance_lock);
+
+  for (inst = instances; inst; inst = inst->next)
+    if (inst->root && (inst->ino == ino) && (inst->fsid == fsid)
+	&& (strcmp (inst->root->nn->target, target) == 0))
+      {
+	np = inst->root;
+	netfs_nref (np);
+	break;
+      }
+
+  mutex_unlock (&instance_lock);
+  return np;
+}				/*instance_find */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the root node of the instance whose control port is `port` with a
+  new reference, waiting for the file to be attached to the port; returns
+  NULL if `port` is not an instance control port or if no file will be
+  attached to it*/
+struct node *instance_root (mach_port_t port)
+{
+  instance_t *inst;
+  struct node *np;
+
+  inst = ports_lookup_port (netfs_port_bucket, port, instance_class);
+  if (!inst)
+    return NULL;
+
+  /*The filesystem the file sits on may ask for the root as soon as it
+     knows the port, before the file has been attached to it */
+  mutex_lock (&instance_lock);
+  while (!inst->root && !inst->err)
+    condition_wait (&instance_cond, &instance_lock);
+  np = inst->root;
+  if (np)
+    netfs_nref (np);
+  mutex_unlock (&instance_lock);
+
+  ports_port_deref (inst);
+  return np;
+}				/*instance_root */
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,89 @@
+/*---------------------------------------------------------------------------*/
+/*instance.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for serving the files handed over to a running filter by
+  other filters (the multiplexed mode)*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __INSTANCE_H__
+#define __INSTANCE_H__
+/*---------------------------------------------------------------------------*/
+#include <error.h>
+#include <sys/types.h>
+#include <hurd/ports.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The control port of a file served by the filter in addition to the one
+  it has been started on*/
+struct instance
+{
+  /*the libports part of the port */
+  struct port_info pi;
+
+  /*the root node serving the file (NULL until the file has been attached
+     to the port; protected by `instance_lock`) */
+  struct node *root;
+
+  /*the reason why no file will be attached to the port (protected by
+     `instance_lock`) */
+  error_t err;
+
+  /*the inode number and the filesystem of the node the file sits on */
+  ino_t ino;
+  dev_t fsid;
+
+  /*the next instance in the list of all instances */
+  struct instance *next;
+};				/*struct instance */
+/*---------------------------------------------------------------------------*/
+typedef struct instance instance_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Creates the class of the instance control ports*/
+error_t instance_start (void);
+/*---------------------------------------------------------------------------*/
+/*Creates a new control port in `inst`; the file is attached to it later
+  with `instance_attach`*/
+error_t instance_create (instance_t ** inst);
+/*---------------------------------------------------------------------------*/
+/*Makes `inst` serve the file sitting on the inode `ino` of the filesystem
+  `fsid` with the node `root` and adds a reference to the node*/
+void instance_attach (instance_t * inst, struct node *root, ino_t ino,
+		      dev_t fsid);
+/*---------------------------------------------------------------------------*/
+/*Tells the requests waiting for the file to be attached to `inst` that no
+  file will be, because of `err`, and destroys the control port*/
+void instance_fail (instance_t * inst, error_t err);
+/*---------------------------------------------------------------------------*/
+/*Finds the root node already serving the file sitting on the inode `ino`
+  of the filesystem `fsid` with the target `target` and adds a reference to
+  it; returns NULL if there is no such node*/
+struct node *instance_find (ino_t ino, dev_t fsid, const char *target);
+/*---------------------------------------------------------------------------*/
+/*Returns the root node of the instance whose control port is `port` with a
+  new reference, waiting for the file to be attached to the port; returns
+  NULL if `port` is not an instance control port or if no file will be
+  attached to it*/
+struct node *instance_root (mach_port_t port);
+/*---------------------------------------------------------------------------*/
+#endif /*__INSTANCE_H__*/
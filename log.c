@@ -0,0 +1,584 @@
+/*---------------------------------------------------------------------------*/
+/*log.c*/
+/*---------------------------------------------------------------------------*/
+/*The binary debug log kept in per-thread rings*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cthreads.h>
+#include <maptime.h>
+#include <sys/time.h>
+/*---------------------------------------------------------------------------*/
+#include "log.h"
+#include "filter.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The size of the buffer in which the records are collected before being
+  written out*/
+#define LOG_BUF_SIZE (64 * 1024)
+/*---------------------------------------------------------------------------*/
+/*The longest format written to the log file*/
+#define LOG_FMT_MAX 1024
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The records logged by a thread and not written out yet*/
+struct log_ring
+{
+  /*the records; the logging thread fills the slot `head` and then moves
+     `head`, the writing thread moves `tail` after having copied a slot */
+  log_record_t records[LOG_RING_SIZE];
+  volatile unsigned long head;
+  volatile unsigned long tail;
+
+  /*the number of messages lost because the ring was full since the
+     writing thread has last reported it */
+  unsigned long lost;
+
+  /*set while a thread uses the ring */
+  int owned;
+
+  /*the number of the ring, printed with its records */
+  unsigned int id;
+
+  /*the next ring in the list of all rings */
+  struct log_ring *next;
+};				/*struct log_ring */
+/*---------------------------------------------------------------------------*/
+typedef struct log_ring log_ring_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The level each category of messages is logged at (nothing is logged by
+  default)*/
+unsigned char log_levels[LOG_CATEGORIES];
+/*---------------------------------------------------------------------------*/
+/*The file the messages are written to*/
+char *log_file = LOG_FILE_DEFAULT;
+/*---------------------------------------------------------------------------*/
+/*The names of the categories and of the levels of the messages*/
+static const char *const log_category_names[LOG_CATEGORIES] =
+  { "general", "read", "trace", "node", "perm" };
+static const char *const log_level_names[] =
+  { "off", "error", "info", "debug" };
+/*---------------------------------------------------------------------------*/
+/*The log file (-1 until it has been opened)*/
+static int log_fd = -1;
+/*---------------------------------------------------------------------------*/
+/*Set once the options have been parsed and the file may be opened*/
+static int log_ready;
+/*---------------------------------------------------------------------------*/
+/*The process the records are logged by*/
+static uint32_t log_pid;
+/*---------------------------------------------------------------------------*/
+/*All the rings ever used; a ring is never freed, so the list may be
+  walked without locking*/
+static log_ring_t *volatile log_rings;
+static unsigned int log_nrings;
+/*---------------------------------------------------------------------------*/
+/*The ring of the calling thread*/
+static __thread log_ring_t *log_ring;
+/*---------------------------------------------------------------------------*/
+/*Protects adding the rings to the list and opening the file*/
+static struct mutex log_lock = MUTEX_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+/*Serializes the writing of the records and protects the buffer they are
+  collected in*/
+static struct mutex log_drain_lock = MUTEX_INITIALIZER;
+static char log_buf[LOG_BUF_SIZE];
+static size_t log_buf_len;
+/*---------------------------------------------------------------------------*/
+/*The site of the records reporting the lost messages*/
+static log_site_t log_lost_site = {"log: Messages lost.", 1, 0 };
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Fills in the number and the types of the arguments of `site` from its
+  format*/
+static void log_parse (log_site_t * site)
+{
+  const char *p = site->fmt;
+  int n = 0, longs;
+
+  while ((p = strchr (p, '%')) && (n < LOG_ARGS_MAX))
+    {
+      /*skip the flags, the width and the precision */
+      p += 1 + strspn (p + 1, "#0123456789.- +'");
+
+      /*a literal percent sign takes no argument */
+      if (*p == '%')
+	{
+	  ++p;
+	  continue;
+	}
+
+      /*count the length modifiers */
+      for (longs = 0; *p && strchr ("hlLqjzt", *p); ++p)
+	if (*p == 'l' || *p == 'z' || *p == 't')
+	  ++longs;
+	else if (*p == 'L' || *p == 'q' || *p == 'j')
+	  longs = 2;
+
+      if (!*p)
+	break;
+
+      switch (*p++)
+	{
+	case 's':
+	  site->types[n++] = LOG_ARG_STR;
+	  break;
+
+	case 'p':
+	  site->types[n++] = LOG_ARG_PTR;
+	  break;
+
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'g':
+	case 'G':
+	case 'a':
+	  site->types[n++] = LOG_ARG_DOUBLE;
+	  break;
+
+	default:
+	  site->types[n++] = (longs == 0) ? LOG_ARG_INT
+	    : ((longs == 1) ? LOG_ARG_LONG : LOG_ARG_LLONG);
+	}
+    }
+
+  /*Make the description visible before the flag saying it is there */
+  site->nargs = n;
+  __sync_synchronize ();
+  site->parsed = 1;
+}				/*log_parse */
+
+/*---------------------------------------------------------------------------*/
+/*Finds a ring no thread uses or creates a new one and gives it to the
+  calling thread*/
+static log_ring_t *log_ring_claim (void)
+{
+  log_ring_t *ring;
+
+  /*Try to reuse the ring of a thread which has exited */
+  for (ring = log_rings; ring; ring = ring->next)
+    if (!ring->owned && !__sync_lock_test_and_set (&ring->owned, 1))
+      return ring;
+
+  /*Create a new ring */
+  ring = calloc (1, sizeof (log_ring_t));
+  if (!ring)
+    return NULL;
+  ring->owned = 1;
+
+  /*publish the ring only once it has been initialized */
+  mutex_lock (&log_lock);
+  ring->id = ++log_nrings;
+  ring->next = log_rings;
+  __sync_synchronize ();
+  log_rings = ring;
+  mutex_unlock (&log_lock);
+
+  return ring;
+}				/*log_ring_claim */
+
+/*---------------------------------------------------------------------------*/
+/*Writes the collected records out. `log_drain_lock` must be held.*/
+static void log_flush (void)
+{
+  size_t done = 0;
+  ssize_t n;
+
+  while (done < log_buf_len)
+    {
+      n = write (log_fd, log_buf + done, log_buf_len - done);
+      if (n <= 0)
+	break;
+      done += n;
+    }
+
+  log_buf_len = 0;
+}				/*log_flush */
+
+/*---------------------------------------------------------------------------*/
+/*Adds `len` bytes from `data` to the buffer of the records being written
+  out. `log_drain_lock` must be held.*/
+static void log_append (const void *data, size_t len)
+{
+  if (log_buf_len + len > LOG_BUF_SIZE)
+    log_flush ();
+
+  memcpy (log_buf + log_buf_len, data, len);
+  log_buf_len += len;
+}				/*log_append */
+
+/*---------------------------------------------------------------------------*/
+/*Adds `rec` to the buffer of the records being written out, preceded by
+  the format of its site if it has not been written yet. `log_drain_lock`
+  must be held.*/
+static void log_append_record (log_record_t * rec)
+{
+  log_site_t *site = (log_site_t *) (uintptr_t) rec->site;
+  log_site_entry_t entry;
+
+  if (!site->written)
+    {
+      entry.kind = LOG_ENTRY_SITE;
+      entry.len = strnlen (site->fmt, LOG_FMT_MAX);
+      entry.site = rec->site;
+      log_append (&entry, sizeof (entry));
+      log_append (site->fmt, entry.len);
+      site->written = 1;
+    }
+
+  log_append (rec, sizeof (log_record_t));
+}				/*log_append_record */
+
+/*---------------------------------------------------------------------------*/
+/*Writes out the records stored in all the rings so far*/
+static void log_drain (void)
+{
+  log_ring_t *ring;
+  log_record_t lost;
+  struct timeval now;
+  unsigned long head;
+
+  mutex_lock (&log_drain_lock);
+
+  for (ring = log_rings; ring; ring = ring->next)
+    {
+      /*the records up to `head` are complete */
+      head = ring->head;
+      __sync_synchronize ();
+
+      for (; ring->tail != head; ++ring->tail)
+	{
+	  log_append_record
+	    (&ring->records[ring->tail & (LOG_RING_SIZE - 1)]);
+
+	  /*the slot may be reused once it has been copied */
+	  __sync_synchronize ();
+	}
+
+      /*tell how many messages have not fit in the ring */
+      memset (&lost, 0, sizeof (lost));
+      lost.lost = __sync_lock_test_and_set (&ring->lost, 0);
+      if (lost.lost)
+	{
+	  gettimeofday (&now, NULL);
+	  lost.kind = LOG_ENTRY_RECORD;
+	  lost.pid = log_pid;
+	  lost.thread = ring->id;
+	  lost.sec = now.tv_sec;
+	  lost.usec = now.tv_usec;
+	  lost.site = (uintptr_t) & log_lost_site;
+	  log_append_record (&lost);
+	}
+    }
+
+  log_flush ();
+
+  mutex_unlock (&log_drain_lock);
+}				/*log_drain */
+
+/*---------------------------------------------------------------------------*/
+/*The thread writing the records out*/
+static any_t log_drain_thread (any_t arg)
+{
+  for (;;)
+    {
+      usleep (LOG_DRAIN_INTERVAL * 1000);
+      log_drain ();
+    }
+
+  return 0;
+}				/*log_drain_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Logs all categories of messages at `level`*/
+void log_init (int level)
+{
+  memset (log_levels, level, sizeof (log_levels));
+}				/*log_init */
+
+/*---------------------------------------------------------------------------*/
+/*Sets the levels of the categories according to `spec`, which looks like
+  CATEGORY[,CATEGORY...][:LEVEL]; the category may be `all` and the level
+  is `debug` if omitted*/
+error_t log_configure (const char *spec)
+{
+  const char *colon = strchr (spec, ':');
+  const char *p, *end;
+  size_t len;
+  int level = LOG_LEVEL_DEBUG, mask = 0, i;
+
+  /*Find the level */
+  if (colon)
+    {
+      for (level = LOG_LEVEL_OFF; level <= LOG_LEVEL_DEBUG; ++level)
+	if (!strcmp (colon + 1, log_level_names[level]))
+	  break;
+      if (level > LOG_LEVEL_DEBUG)
+	return EINVAL;
+    }
+  else
+    colon = spec + strlen (spec);
+
+  /*Find the categories */
+  for (p = spec; p < colon; p = end + 1)
+    {
+      end = memchr (p, ',', colon - p);
+      if (!end)
+	end = colon;
+      len = end - p;
+
+      if ((len == 3) && !strncmp (p, "all", len))
+	mask = (1 << LOG_CATEGORIES) - 1;
+      else
+	{
+	  for (i = 0; i < LOG_CATEGORIES; ++i)
+	    if ((strlen (log_category_names[i]) == len)
+		&& !strncmp (p, log_category_names[i], len))
+	      break;
+	  if (i == LOG_CATEGORIES)
+	    return EINVAL;
+
+	  mask |= 1 << i;
+	}
+    }
+
+  if (!mask)
+    return EINVAL;
+
+  /*Set the levels */
+  for (i = 0; i < LOG_CATEGORIES; ++i)
+    if (mask & (1 << i))
+      log_levels[i] = level;
+
+  /*If the filter is running already, open the file if needed */
+  if (log_ready)
+    log_start ();
+
+  return 0;
+}				/*log_configure */
+
+/*---------------------------------------------------------------------------*/
+/*Opens `log_file` once some messages are logged; the messages logged
+  before are kept in the rings until then (if the file cannot be opened,
+  they are dropped)*/
+void log_start (void)
+{
+  log_header_t header = {.magic = LOG_MAGIC,
+    .record_size = sizeof (log_record_t) };
+  int i, fd;
+
+  mutex_lock (&log_lock);
+  log_ready = 1;
+
+  /*If the file is open or nothing is logged, there is nothing to do */
+  for (i = 0; i < LOG_CATEGORIES; ++i)
+    if (log_levels[i] != LOG_LEVEL_OFF)
+      break;
+  if ((log_fd >= 0) || (i == LOG_CATEGORIES))
+    {
+      mutex_unlock (&log_lock);
+      return;
+    }
+
+  /*Several filters may share the file, so each of them appends to it
+     starting with a header of its own */
+  fd = open (log_file, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if ((fd >= 0) && (write (fd, &header, sizeof (header)) != sizeof (header)))
+    {
+      close (fd);
+      fd = -1;
+    }
+
+  /*Start writing the records out */
+  if (fd >= 0)
+    {
+      log_pid = getpid ();
+      log_fd = fd;
+      cthread_detach (cthread_fork (log_drain_thread, 0));
+    }
+
+  mutex_unlock (&log_lock);
+}				/*log_start */
+
+/*---------------------------------------------------------------------------*/
+/*Writes out the pending records and closes the log file*/
+void log_stop (void)
+{
+  if (log_fd < 0)
+    return;
+
+  log_drain ();
+
+  close (log_fd);
+  log_fd = -1;
+}				/*log_stop */
+
+/*---------------------------------------------------------------------------*/
+/*Starts the thread writing the records out again in a forked child,
+  dropping the records of the parent, which writes them out itself*/
+void log_restart (void)
+{
+  log_ring_t *ring;
+
+  if (log_fd < 0)
+    return;
+
+  /*The threads of the parent might have held the locks at the fork */
+  mutex_init (&log_lock);
+  mutex_init (&log_drain_lock);
+  log_buf_len = 0;
+
+  /*Only the calling thread exists in the child */
+  for (ring = log_rings; ring; ring = ring->next)
+    {
+      ring->tail = ring->head;
+      ring->owned = (ring == log_ring);
+    }
+
+  log_pid = getpid ();
+  cthread_detach (cthread_fork (log_drain_thread, 0));
+}				/*log_restart */
+
+/*---------------------------------------------------------------------------*/
+/*Stores a message of `site` in the ring of the calling thread; never
+  blocks*/
+void log_msg (log_site_t * site, ...)
+{
+  log_ring_t *ring = log_ring;
+  log_record_t *rec;
+  struct timeval now;
+  va_list ap;
+  size_t used = 0, len;
+  const char *s;
+  int i;
+
+  /*Find a ring for the thread when it logs first */
+  if (!ring)
+    {
+      ring = log_ring = log_ring_claim ();
+      if (!ring)
+	return;
+    }
+
+  /*If the writing thread lags behind, drop the message */
+  if (ring->head - ring->tail >= LOG_RING_SIZE)
+    {
+      __sync_fetch_and_add (&ring->lost, 1);
+      return;
+    }
+
+  if (!site->parsed)
+    log_parse (site);
+
+  /*The mapped time is available only once the startup has gone far
+     enough */
+  if (maptime)
+    maptime_read (maptime, &now);
+  else
+    gettimeofday (&now, NULL);
+
+  rec = &ring->records[ring->head & (LOG_RING_SIZE - 1)];
+  rec->kind = LOG_ENTRY_RECORD;
+  rec->pid = log_pid;
+  rec->thread = ring->id;
+  rec->sec = now.tv_sec;
+  rec->usec = now.tv_usec;
+  rec->lost = 0;
+  rec->site = (uintptr_t) site;
+
+  /*Store the arguments, copying the strings, which may be gone by the
+     time the record is written out */
+  va_start (ap, site);
+  for (i = 0; i < site->nargs; ++i)
+    switch (site->types[i])
+      {
+      case LOG_ARG_INT:
+	rec->args[i] = (int64_t) va_arg (ap, int);
+	break;
+
+      case LOG_ARG_LONG:
+	rec->args[i] = (int64_t) va_arg (ap, long);
+	break;
+
+      case LOG_ARG_LLONG:
+	rec->args[i] = va_arg (ap, long long);
+	break;
+
+      case LOG_ARG_PTR:
+	rec->args[i] = (uintptr_t) va_arg (ap, void *);
+	break;
+
+      case LOG_ARG_DOUBLE:
+	{
+	  double d = va_arg (ap, double);
+	  memcpy (&rec->args[i], &d, sizeof (d));
+	  break;
+	}
+
+      case LOG_ARG_STR:
+	s = va_arg (ap, const char *);
+	if (!s)
+	  s = "(null)";
+
+	/*the strings which do not fit are cut */
+	len = (used < LOG_STR_MAX) ? strnlen (s, LOG_STR_MAX - 1 - used) : 0;
+	rec->args[i] = (used < LOG_STR_MAX) ? used : LOG_STR_MAX - 1;
+	memcpy (rec->str + used, s, len);
+	used += len;
+	rec->str[used < LOG_STR_MAX ? used++ : LOG_STR_MAX - 1] = 0;
+	break;
+      }
+  va_end (ap);
+
+  /*Hand the record over to the writing thread */
+  __sync_synchronize ();
+  ++ring->head;
+}				/*log_msg */
+
+/*---------------------------------------------------------------------------*/
+/*Gives the ring of the calling thread, which is about to exit, to the
+  next thread starting to log*/
+void log_release (void)
+{
+  if (!log_ring)
+    return;
+
+  __sync_lock_release (&log_ring->owned);
+  log_ring = NULL;
+}				/*log_release */
+
+/*---------------------------------------------------------------------------*/
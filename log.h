@@ -0,0 +1,200 @@
+/*---------------------------------------------------------------------------*/
+/*log.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for the binary debug log: the messages are stored as
+  fixed-size records in per-thread rings and written out by a background
+  thread. The file is turned back into text by tools/logdecode.*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __LOG_H__
+#define __LOG_H__
+/*---------------------------------------------------------------------------*/
+#include <errno.h>
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The file the messages are written to by default*/
+#define LOG_FILE_DEFAULT "/var/log/filter.dbg"
+/*---------------------------------------------------------------------------*/
+/*The categories of the messages*/
+#define LOG_GENERAL 0		/*the startup and the threads */
+#define LOG_READ 1		/*reading and writing the data */
+#define LOG_TRACE 2		/*tracing the stacks and finding the targets */
+#define LOG_NODE 3		/*the nodes and the directories */
+#define LOG_PERM 4		/*the permissions and the stat information */
+#define LOG_CATEGORIES 5
+/*---------------------------------------------------------------------------*/
+/*The levels of the messages; a category logged at some level gets the
+  messages of that level and of the lower ones*/
+#define LOG_LEVEL_OFF 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+/*---------------------------------------------------------------------------*/
+/*The first word of a log file ("FLOG")*/
+#define LOG_MAGIC 0x474f4c46
+/*---------------------------------------------------------------------------*/
+/*The number of records a thread may have waiting to be written out; the
+  messages logged while its ring is full are lost (a power of two)*/
+#define LOG_RING_SIZE 512
+/*---------------------------------------------------------------------------*/
+/*The maximal number of the arguments of a message and the room for the
+  strings among them*/
+#define LOG_ARGS_MAX 8
+#define LOG_STR_MAX 64
+/*---------------------------------------------------------------------------*/
+/*The time (in milliseconds) between two passes of the thread writing the
+  records out*/
+#define LOG_DRAIN_INTERVAL 100
+/*---------------------------------------------------------------------------*/
+/*The kinds of the entries of a log file*/
+#define LOG_ENTRY_SITE 1	/*the format of a message, followed by it */
+#define LOG_ENTRY_RECORD 2	/*a logged message */
+/*---------------------------------------------------------------------------*/
+/*The types of the arguments of a message*/
+#define LOG_ARG_INT 1
+#define LOG_ARG_LONG 2
+#define LOG_ARG_LLONG 3
+#define LOG_ARG_PTR 4
+#define LOG_ARG_STR 5
+#define LOG_ARG_DOUBLE 6
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A place in the code logging a message (one static instance per LOG_MSG)*/
+struct log_site
+{
+  /*the format of the message */
+  const char *fmt;
+
+  /*set once the fields below have been filled in from `fmt` */
+  int parsed;
+
+  /*the number and the types of the arguments of the message */
+  int nargs;
+  char types[LOG_ARGS_MAX];
+
+  /*set once `fmt` has been written to the log file */
+  int written;
+};				/*struct log_site */
+/*---------------------------------------------------------------------------*/
+typedef struct log_site log_site_t;
+/*---------------------------------------------------------------------------*/
+/*The header of a log file*/
+struct log_header
+{
+  /*always LOG_MAGIC */
+  uint32_t magic;
+
+  /*the size of a record, so that the decoder can check the layout */
+  uint32_t record_size;
+};				/*struct log_header */
+/*---------------------------------------------------------------------------*/
+typedef struct log_header log_header_t;
+/*---------------------------------------------------------------------------*/
+/*The entry preceding the format of a message in a log file*/
+struct log_site_entry
+{
+  /*always LOG_ENTRY_SITE */
+  uint32_t kind;
+
+  /*the length of the format following the entry */
+  uint32_t len;
+
+  /*the identifier of the site, referred to by the records */
+  uint64_t site;
+};				/*struct log_site_entry */
+/*---------------------------------------------------------------------------*/
+typedef struct log_site_entry log_site_entry_t;
+/*---------------------------------------------------------------------------*/
+/*A logged message, as stored both in the rings and in the log file (the
+  fields have fixed sizes, so the file may be decoded on any machine with
+  the same byte order)*/
+struct log_record
+{
+  /*always LOG_ENTRY_RECORD */
+  uint32_t kind;
+
+  /*the process and the ring of the thread which has logged the message */
+  uint32_t pid;
+  uint32_t thread;
+
+  /*the time the message has been logged at */
+  uint32_t sec;
+  uint32_t usec;
+
+  /*the number of messages of the same thread lost before this record
+     (set only in the records added by the writing thread) */
+  uint32_t lost;
+
+  /*the site which has logged the message */
+  uint64_t site;
+
+  /*the arguments; a string is copied into `str` and its argument is its
+     offset there */
+  uint64_t args[LOG_ARGS_MAX];
+  char str[LOG_STR_MAX];
+};				/*struct log_record */
+/*---------------------------------------------------------------------------*/
+typedef struct log_record log_record_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The level each category of messages is logged at*/
+extern unsigned char log_levels[LOG_CATEGORIES];
+/*---------------------------------------------------------------------------*/
+/*The file the messages are written to*/
+extern char *log_file;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Logs all categories of messages at `level`*/
+void log_init (int level);
+/*---------------------------------------------------------------------------*/
+/*Sets the levels of the categories according to `spec`, which looks like
+  CATEGORY[,CATEGORY...][:LEVEL]; the category may be `all` and the level
+  is `debug` if omitted*/
+error_t log_configure (const char *spec);
+/*---------------------------------------------------------------------------*/
+/*Opens `log_file` once some messages are logged; the messages logged
+  before are kept in the rings until then (if the file cannot be opened,
+  they are dropped)*/
+void log_start (void);
+/*---------------------------------------------------------------------------*/
+/*Writes out the pending records and closes the log file*/
+void log_stop (void);
+/*---------------------------------------------------------------------------*/
+/*Starts the thread writing the records out again in a forked child,
+  dropping the records of the parent, which writes them out itself*/
+void log_restart (void);
+/*---------------------------------------------------------------------------*/
+/*Stores a message of `site` in the ring of the calling thread; never
+  blocks*/
+void log_msg (log_site_t * site, ...);
+/*---------------------------------------------------------------------------*/
+/*Gives the ring of the calling thread, which is about to exit, to the
+  next thread starting to log*/
+void log_release (void);
+/*---------------------------------------------------------------------------*/
+#endif /*__LOG_H__*/
@@ -36,12 +36,25 @@
 #include "debug.h"
 #include "node.h"
 #include "filter.h"
+#include "stats.h"
 /*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*--------Global Variables---------------------------------------------------*/
-/*The lock protecting the underlying filesystem*/
-struct mutex ulfs_lock = MUTEX_INITIALIZER;
+/*The time (in milliseconds) the stat information of a node is cached for
+  (not cached by default)*/
+int stat_ttl = 0;
+/*---------------------------------------------------------------------------*/
+/*Set if the stat information should be cached until it is explicitly
+  invalidated*/
+int stat_hold = 0;
+/*---------------------------------------------------------------------------*/
+/*Incremented to invalidate the stat information cached in all nodes*/
+unsigned long stat_generation;
+/*---------------------------------------------------------------------------*/
+/*The nodes keyed by the inode numbers of their targets (protected by
+  `netfs_node_refcnt_lock`)*/
+struct hurd_ihash node_cache = HURD_IHASH_INITIALIZER (HURD_IHASH_NO_LOCP);
 /*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
@@ -75,6 +88,26 @@ error_t node_create (node_t ** node)
 	  return err;
 	}
 
+      /*initialize the netnode */
+      netnode_new->flags = 0;
+      netnode_new->port = MACH_PORT_NULL;
+      netnode_new->openmodes = 0;
+      netnode_new->underlying = MACH_PORT_NULL;
+      netnode_new->target = NULL;
+      netnode_new->stat_valid = 0;
+      netnode_new->notify = NULL;
+      netnode_new->changes = 0;
+      mutex_init (&netnode_new->stat_lock);
+      netnode_new->retracing = 0;
+      netnode_new->dirport = MACH_PORT_NULL;
+      netnode_new->name = NULL;
+      netnode_new->ino = 0;
+      netnode_new->cached = 0;
+      dircache_init (&netnode_new->names);
+      cache_init (&netnode_new->cache);
+      readahead_init (&netnode_new->ra);
+      writeback_init (&netnode_new->wb);
+
       /*store the result of creation in the second parameter */
       *node = node_new;
     }
@@ -89,13 +122,46 @@ error_t node_create (node_t ** node)
 void node_destroy (node_t * np)
 {
   /*Destroy the port to the underlying filesystem allocated to the node */
-  PORT_DEALLOC (np->nn->port);
+  if (np->nn->port != np->nn->underlying)
+    PORT_DEALLOC (np->nn->port);
+
+  /*Stop listening to the target */
+  notify_destroy (np);
+
+  /*Release the node the file served by this root node sits on */
+  if (MACH_PORT_VALID (np->nn->underlying))
+    PORT_DEALLOC (np->nn->underlying);
+  free (np->nn->target);
+
+  /*Forget where the node has been looked up */
+  if (MACH_PORT_VALID (np->nn->dirport))
+    PORT_DEALLOC (np->nn->dirport);
+  free (np->nn->name);
+
+  /*Drop the cached data */
+  cache_destroy (&np->nn->cache);
+  writeback_destroy (&np->nn->wb);
+  dircache_destroy (&np->nn->names);
 
   /*Free the netnode and the node itself */
   free (np->nn);
   free (np);
 }				/*node_destroy */
 
+/*---------------------------------------------------------------------------*/
+/*Makes `np`, whose last reference has been dropped, unreachable: removes
+  it from the node cache and detaches it from its notification port
+  (`netfs_node_refcnt_lock` must be held)*/
+void node_forget (node_t * np)
+{
+  if (np->nn->cached
+      && (hurd_ihash_find (&node_cache, (hurd_ihash_key_t) np->nn->ino) ==
+	  np))
+    hurd_ihash_remove (&node_cache, (hurd_ihash_key_t) np->nn->ino);
+
+  notify_detach (np);
+}				/*node_forget */
+
 /*---------------------------------------------------------------------------*/
 /*Creates the root node and the corresponding lnode*/
 error_t node_create_root (node_t ** root_node)
@@ -124,33 +190,174 @@ error_t node_init_root (mach_port_t underlying,	/*the port to the
 {
   error_t err = 0;
 
-  /*Acquire a lock for operations on the underlying filesystem */
-  mutex_lock (&ulfs_lock);
+  /*Operations on the target of a node are serialized by the lock of the
+     node only */
+  mutex_lock (&node->lock);
 
   /*Store the specified port in the node */
   node->nn->port = underlying;
 
-  LOG_MSG ("node_init_root: Port: 0x%ld", (unsigned long) node->nn->port);
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "node_init_root: Port: 0x%ld",
+	  (unsigned long) node->nn->port);
 
   /*Stat the root node */
-  err = io_stat (node->nn->port, &node->nn_stat);
+  err = STATS_RPC (STATS_RPC_IO_STAT,
+		   io_stat (node->nn->port, &node->nn_stat));
   if (err)
     {
       /*deallocate the port */
       PORT_DEALLOC (node->nn->port);
 
-      LOG_MSG ("node_init_root: Could not stat the root node.");
+      LOG_AT (LOG_NODE, LOG_LEVEL_ERROR,
+	      "node_init_root: Could not stat the root node.");
 
-      /*unlock the mutex and exit */
-      mutex_unlock (&ulfs_lock);
+      /*unlock the node and exit */
+      mutex_unlock (&node->lock);
       return err;
     }
 
-  /*Release the lock for operations on the undelying filesystem */
-  mutex_unlock (&ulfs_lock);
+  /*Release the lock of the node */
+  mutex_unlock (&node->lock);
 
   /*Return the result of operations */
   return err;
 }				/*node_init_root */
 
 /*---------------------------------------------------------------------------*/
+/*Returns in `port` a new reference to the port to the underlying
+  filesystem of `np`; the node must be locked*/
+error_t node_get_port (node_t * np, mach_port_t * port)
+{
+  error_t err = 0;
+
+  /*Add a user reference to the send right held by the node */
+  err = mach_port_mod_refs
+    (mach_task_self (), np->nn->port, MACH_PORT_RIGHT_SEND, 1);
+  if (err)
+    return err;
+
+  /*Return the port */
+  *port = np->nn->port;
+  return 0;
+}				/*node_get_port */
+
+/*---------------------------------------------------------------------------*/
+/*Checks whether the stat information cached in `np` may be used*/
+int node_stat_fresh (node_t * np)
+{
+  struct timeval now;
+  long age;
+
+  /*If the information has been invalidated, it must be fetched again */
+  if (!np->nn->stat_valid || (np->nn->stat_gen != stat_generation))
+    return 0;
+
+  /*In the hold mode or if the target tells us about its changes, only an
+     invalidation makes it stale */
+  if (stat_hold || (np->nn->notify && np->nn->notify->subscribed))
+    return 1;
+
+  /*If caching is disabled, stop */
+  if (!stat_ttl)
+    return 0;
+
+  /*Check the age of the information */
+  maptime_read (maptime, &now);
+  age = (now.tv_sec - np->nn->stat_time.tv_sec) * 1000
+    + (now.tv_usec - np->nn->stat_time.tv_usec) / 1000;
+
+  return (age >= 0) && (age < stat_ttl);
+}				/*node_stat_fresh */
+
+/*---------------------------------------------------------------------------*/
+/*Marks the stat information of `np` as having just been fetched, unless
+  the target has reported a change since `changes` changes had been
+  reported*/
+void node_stat_update (node_t * np, unsigned long changes)
+{
+  /*The check and the update must not let a change notified in between
+     slip, or the stale information would be trusted until the next one */
+  mutex_lock (&np->nn->stat_lock);
+  if (changes == np->nn->changes)
+    {
+      maptime_read (maptime, &np->nn->stat_time);
+      np->nn->stat_gen = stat_generation;
+      np->nn->stat_valid = 1;
+    }
+  mutex_unlock (&np->nn->stat_lock);
+}				/*node_stat_update */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the number of changes of the target of `np` reported so far*/
+unsigned long node_stat_changes (node_t * np)
+{
+  unsigned long changes;
+
+  mutex_lock (&np->nn->stat_lock);
+  changes = np->nn->changes;
+  mutex_unlock (&np->nn->stat_lock);
+
+  return changes;
+}				/*node_stat_changes */
+
+/*---------------------------------------------------------------------------*/
+/*Records that the target of `np` has changed (may be used without holding
+  the lock of the node)*/
+void node_stat_changed (node_t * np)
+{
+  mutex_lock (&np->nn->stat_lock);
+  ++np->nn->changes;
+  NODE_STAT_INVALIDATE (np);
+  mutex_unlock (&np->nn->stat_lock);
+}				/*node_stat_changed */
+
+/*---------------------------------------------------------------------------*/
+/*Finds the node of the inode `ino` in the filesystem `fsid` in the node
+  cache and adds a reference to it; returns NULL if there is no such node*/
+node_t *node_cache_find (ino_t ino, dev_t fsid)
+{
+  node_t *np;
+
+  spin_lock (&netfs_node_refcnt_lock);
+
+  /*Inode numbers are unique only within a filesystem */
+  np = hurd_ihash_find (&node_cache, (hurd_ihash_key_t) ino);
+  if (np && (np->nn_stat.st_fsid == fsid))
+    ++np->references;
+  else
+    np = NULL;
+
+  spin_unlock (&netfs_node_refcnt_lock);
+  return np;
+}				/*node_cache_find */
+
+/*---------------------------------------------------------------------------*/
+/*Stores `np` in the node cache under the inode number of its target*/
+error_t node_cache_add (node_t * np)
+{
+  error_t err = 0;
+
+  spin_lock (&netfs_node_refcnt_lock);
+
+  /*If another node has already been stored for the inode, keep it */
+  if (np->nn->cached)
+    err = 0;
+  else if (hurd_ihash_find
+	   (&node_cache, (hurd_ihash_key_t) np->nn_stat.st_ino))
+    err = EEXIST;
+  else
+    {
+      err = hurd_ihash_add
+	(&node_cache, (hurd_ihash_key_t) np->nn_stat.st_ino, np);
+      if (!err)
+	{
+	  np->nn->ino = np->nn_stat.st_ino;
+	  np->nn->cached = 1;
+	}
+    }
+
+  spin_unlock (&netfs_node_refcnt_lock);
+  return err;
+}				/*node_cache_add */
+
+/*---------------------------------------------------------------------------*/
@@ -31,6 +31,12 @@
 #include <sys/stat.h>
 #include <hurd/netfs.h>
 /*---------------------------------------------------------------------------*/
+#include "cache.h"
+#include "readahead.h"
+#include "writeback.h"
+#include "notify.h"
+#include "dircache.h"
+/*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*--------Macros-------------------------------------------------------------*/
@@ -41,6 +47,7 @@
 #define FLAG_NODE_ULFS_FIXED    0x00000001 /*this node should not be updated */
 #define FLAG_NODE_INVALIDATE    0x00000002 /*this node must be updated */
 #define FLAG_NODE_ULFS_UPTODATE	0x00000004 /*this node has just been updated */
+#define FLAG_NODE_RESOLVING	0x00000008 /*the target is being looked up */
 /*---------------------------------------------------------------------------*/
 /*The type of offset corresponding to the current platform*/
 #ifdef __USE_FILE_OFFSET64
@@ -52,6 +59,9 @@
 /*Deallocates the specified port*/
 #define PORT_DEALLOC(p) (mach_port_deallocate(mach_task_self(), (p)))
 /*---------------------------------------------------------------------------*/
+/*Drops the stat information cached in the node*/
+#define NODE_STAT_INVALIDATE(np) ((np)->nn->stat_valid = 0)
+/*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*The user-defined node for libnetfs*/
@@ -62,6 +72,56 @@ struct netnode
 
   /*a port to the underlying filesystem */
   file_t port;
+
+  /*the flags `port` has been opened with */
+  int openmodes;
+
+  /*the node the filter sits on and the name of the translator whose
+     stack is traced on it (set for the root nodes only) */
+  mach_port_t underlying;
+  char *target;
+
+  /*set if the stat information of the node may be used without asking
+     the target */
+  int stat_valid;
+
+  /*the time the stat information has been fetched at and the value of
+     `stat_generation` at that moment */
+  struct timeval stat_time;
+  unsigned long stat_gen;
+
+  /*the port on which we are notified of the changes and of the death of
+     the target and the number of changes notified so far (protected by
+     `stat_lock`, which the notifications take instead of the lock of the
+     node) */
+  notify_t *notify;
+  unsigned long changes;
+  struct mutex stat_lock;
+
+  /*set while a new target is being looked up in the background */
+  int retracing;
+
+  /*the target of the directory this node has been looked up in and the
+     name it has been looked up with (both unset for the root node) */
+  mach_port_t dirport;
+  char *name;
+
+  /*the names looked up in this node, if it is a directory */
+  dircache_t names;
+
+  /*the inode number the node is stored under in the node cache and
+     whether it is stored there */
+  ino_t ino;
+  int cached;
+
+  /*the blocks of data recently read from `port` */
+  cache_t cache;
+
+  /*the state of the sequential reads of this node */
+  readahead_t ra;
+
+  /*the data written to this node, but not to `port` yet */
+  writeback_t wb;
 };				/*struct netnode */
 /*---------------------------------------------------------------------------*/
 typedef struct netnode netnode_t;
@@ -71,8 +131,19 @@ typedef struct node node_t;
 
 /*---------------------------------------------------------------------------*/
 /*--------Global Variables---------------------------------------------------*/
-/*The lock protecting the underlying filesystem*/
-extern struct mutex ulfs_lock;
+/*The time (in milliseconds) the stat information of a node is cached for*/
+extern int stat_ttl;
+/*---------------------------------------------------------------------------*/
+/*Set if the stat information should be cached until it is explicitly
+  invalidated*/
+extern int stat_hold;
+/*---------------------------------------------------------------------------*/
+/*Incremented to invalidate the stat information cached in all nodes*/
+extern unsigned long stat_generation;
+/*---------------------------------------------------------------------------*/
+/*The nodes keyed by the inode numbers of their targets (protected by
+  `netfs_node_refcnt_lock`)*/
+extern struct hurd_ihash node_cache;
 /*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
@@ -84,6 +155,11 @@ error_t node_create (node_t ** node);
   associated light node*/
 void node_destroy (node_t * np);
 /*---------------------------------------------------------------------------*/
+/*Makes `np`, whose last reference has been dropped, unreachable: removes
+  it from the node cache and detaches it from its notification port
+  (`netfs_node_refcnt_lock` must be held)*/
+void node_forget (node_t * np);
+/*---------------------------------------------------------------------------*/
 /*Creates the root node and the corresponding lnode*/
 error_t node_create_root (node_t ** root_node);
 /*---------------------------------------------------------------------------*/
@@ -93,4 +169,30 @@ error_t node_init_root (mach_port_t underlying,	/*the port to the
 			node_t * node	/*the root node */
 			);
 /*---------------------------------------------------------------------------*/
+/*Returns in `port` a new reference to the port to the underlying
+  filesystem of `np`; the node must be locked*/
+error_t node_get_port (node_t * np, mach_port_t * port);
+/*---------------------------------------------------------------------------*/
+/*Checks whether the stat information cached in `np` may be used*/
+int node_stat_fresh (node_t * np);
+/*---------------------------------------------------------------------------*/
+/*Marks the stat information of `np` as having just been fetched, unless
+  the target has reported a change since `changes` changes had been
+  reported*/
+void node_stat_update (node_t * np, unsigned long changes);
+/*---------------------------------------------------------------------------*/
+/*Returns the number of changes of the target of `np` reported so far*/
+unsigned long node_stat_changes (node_t * np);
+/*---------------------------------------------------------------------------*/
+/*Records that the target of `np` has changed (may be used without holding
+  the lock of the node)*/
+void node_stat_changed (node_t * np);
+/*---------------------------------------------------------------------------*/
+/*Finds the node of the inode `ino` in the filesystem `fsid` in the node
+  cache and adds a reference to it; returns NULL if there is no such node*/
+node_t *node_cache_find (ino_t ino, dev_t fsid);
+/*---------------------------------------------------------------------------*/
+/*Stores `np` in the node cache under the inode number of its target*/
+error_t node_cache_add (node_t * np);
+/*---------------------------------------------------------------------------*/
 #endif /*__NODE_H__*/
@@ -0,0 +1,357 @@
+/*---------------------------------------------------------------------------*/
+/*notify.c*/
+/*---------------------------------------------------------------------------*/
+/*Reception of the change notifications of the targets and invalidation of
+  the state cached for them*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <cthreads.h>
+#include <mach/notify.h>
+#include <mach/mig_errors.h>
+#include <hurd/fs.h>
+#include <hurd/ports.h>
+/*---------------------------------------------------------------------------*/
+#include "debug.h"
+#include "filter.h"
+#include "node.h"
+#include "notify.h"
+#include "fs_notify_S.h"
+#include "stats.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The bucket and the class of the notification ports*/
+static struct port_bucket *notify_bucket;
+static struct port_class *notify_class;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Finds the node the notification port `port` belongs to and adds a
+  reference to it*/
+static struct node *notify_lookup (mach_port_t port)
+{
+  notify_t *notify;
+  struct node *np = NULL;
+
+  notify = ports_lookup_port (notify_bucket, port, notify_class);
+  if (!notify)
+    return NULL;
+
+  /*The node may be being destroyed, so look at it under the lock which
+     is held while nodes are destroyed */
+  spin_lock (&netfs_node_refcnt_lock);
+  np = notify->np;
+  if (np)
+    ++np->references;
+  spin_unlock (&netfs_node_refcnt_lock);
+
+  ports_port_deref (notify);
+  return np;
+}				/*notify_lookup */
+
+/*---------------------------------------------------------------------------*/
+/*Destroys the notification port `notify`*/
+static void notify_release (notify_t * notify)
+{
+  /*The target will see a dead name and stop sending notifications */
+  ports_destroy_right (notify);
+  ports_port_deref (notify);
+}				/*notify_release */
+
+/*---------------------------------------------------------------------------*/
+/*Handles the notification about a change of the contents or of the
+  attributes of a target*/
+kern_return_t
+  S_file_changed
+  (fs_notify_t notify_port, natural_t ticketno, file_changed_type_t change,
+   loff_t start, loff_t end)
+{
+  struct node *np = notify_lookup (notify_port);
+  if (!np)
+    return EOPNOTSUPP;
+
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG,
+	  "S_file_changed: Change %d from %ld to %ld.", (int) change,
+	  (long) start, (long) end);
+
+  /*The node is not locked here: the target may send the notification
+     while a thread holding the lock waits for it to reply; the block cache
+     has a lock of its own and the stat information is only marked stale */
+  switch (change)
+    {
+    case FILE_CHANGED_NULL:
+      {
+	/*this is the confirmation of the subscription */
+	break;
+      }
+    case FILE_CHANGED_WRITE:
+      {
+	/*drop only the blocks which have been written to */
+	if (end > start)
+	  cache_invalidate_range (&np->nn->cache, start, end - start);
+	else
+	  cache_invalidate (&np->nn->cache);
+	node_stat_changed (np);
+	break;
+      }
+    case FILE_CHANGED_EXTEND:
+    case FILE_CHANGED_TRUNCATE:
+      {
+	/*the block containing the old end of file is not valid any more */
+	cache_invalidate (&np->nn->cache);
+	node_stat_changed (np);
+	break;
+      }
+    default:
+      {
+	/*only the attributes have changed */
+	node_stat_changed (np);
+	break;
+      }
+    }
+
+  netfs_nrele (np);
+  return 0;
+}				/*S_file_changed */
+
+/*---------------------------------------------------------------------------*/
+/*Handles the notification about a change of the entries of a directory*/
+kern_return_t
+  S_dir_changed
+  (fs_notify_t notify_port, natural_t ticketno, dir_changed_type_t change,
+   string_t name)
+{
+  struct node *np = notify_lookup (notify_port);
+  if (!np)
+    return EOPNOTSUPP;
+
+  LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG, "S_dir_changed: Change %d of '%s'.",
+	  (int) change, name);
+
+  /*The node is not locked here for the same reason as in `S_file_changed`;
+     the names and entries of the directory have a lock of their own */
+  switch (change)
+    {
+    case DIR_CHANGED_NULL:
+      {
+	/*this is the confirmation of the subscription */
+	break;
+      }
+    case DIR_CHANGED_NEW:
+    case DIR_CHANGED_UNLINK:
+      {
+	/*only what is known about this name and the listing are stale */
+	dircache_forget (&np->nn->names, name);
+	node_stat_changed (np);
+	break;
+      }
+    default:
+      {
+	/*the listing is stale as a whole, as is the modification time of the
+	   directory */
+	dircache_invalidate (&np->nn->names);
+	node_stat_changed (np);
+	break;
+      }
+    }
+
+  netfs_nrele (np);
+  return 0;
+}				/*S_dir_changed */
+
+/*---------------------------------------------------------------------------*/
+/*Handles the notification about the death of the target (its port has
+  turned into the dead name `dead`)*/
+static void notify_dead_name (mach_port_t notify_port, mach_port_t dead)
+{
+  struct node *np = notify_lookup (notify_port);
+
+  /*The notification carries a reference to the dead name */
+  if (MACH_PORT_VALID (dead))
+    PORT_DEALLOC (dead);
+
+  if (!np)
+    return;
+
+  LOG_AT (LOG_TRACE, LOG_LEVEL_INFO, "notify_dead_name: The target has died.");
+
+  /*Find the new target in the background */
+  retrace_target (np);
+
+  netfs_nrele (np);
+}				/*notify_dead_name */
+
+/*---------------------------------------------------------------------------*/
+/*The demuxer of the messages arriving on the notification ports*/
+static int notify_demuxer (mach_msg_header_t * inp, mach_msg_header_t * outp)
+{
+  /*The kernel tells us that the target has died */
+  if (inp->msgh_id == MACH_NOTIFY_DEAD_NAME)
+    {
+      mach_dead_name_notification_t *n = (void *) inp;
+
+      notify_dead_name (inp->msgh_local_port, n->not_port);
+
+      ((mig_reply_header_t *) outp)->RetCode = MIG_NO_REPLY;
+      return 1;
+    }
+
+  return fs_notify_server (inp, outp);
+}				/*notify_demuxer */
+
+/*---------------------------------------------------------------------------*/
+/*The thread receiving the change notifications*/
+static any_t notify_thread (any_t arg)
+{
+  /*Serve the notifications forever */
+  for (;;)
+    ports_manage_port_operations_one_thread (notify_bucket, notify_demuxer,
+					     0);
+
+  return 0;
+}				/*notify_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Starts the thread receiving the change notifications*/
+error_t notify_start (void)
+{
+  /*Keep the notification ports apart from the ports of the clients */
+  notify_bucket = ports_create_bucket ();
+  if (!notify_bucket)
+    return ENOMEM;
+
+  notify_class = ports_create_class (0, 0);
+  if (!notify_class)
+    return ENOMEM;
+
+  /*Start the thread, we will never wait for it */
+  cthread_detach (cthread_fork (notify_thread, 0));
+  return 0;
+}				/*notify_start */
+
+/*---------------------------------------------------------------------------*/
+/*Asks the target of `np` to notify the filter of the changes of the file
+  and of its death. The node must be locked.*/
+error_t notify_subscribe (struct node *np)
+{
+  error_t err = 0;
+  notify_t *notify;
+
+  /*The notifications of the previous target are of no interest now */
+  notify_unsubscribe (np);
+
+  if (!notify_bucket)
+    return EOPNOTSUPP;
+
+  /*Create the port to receive the notifications on */
+  err = ports_create_port (notify_class, notify_bucket, sizeof (notify_t),
+			   &notify);
+  if (err)
+    return err;
+
+  notify->np = np;
+  notify->subscribed = 0;
+
+  /*Ask the kernel to tell us when the target dies */
+  mach_port_t prev;
+  err = mach_port_request_notification
+    (mach_task_self (), np->nn->port, MACH_NOTIFY_DEAD_NAME, 1,
+     ports_get_right (notify), MACH_MSG_TYPE_MAKE_SEND_ONCE, &prev);
+  if (!err && MACH_PORT_VALID (prev))
+    PORT_DEALLOC (prev);
+
+  /*Subscribe to the changes of the target; the changes of a directory
+     which matter are those of its entries */
+  if (S_ISDIR (np->nn_stat.st_mode))
+    err = STATS_RPC (STATS_RPC_NOTICE_CHANGES,
+		     dir_notice_changes (np->nn->port,
+					 ports_get_right (notify),
+					 MACH_MSG_TYPE_MAKE_SEND));
+  else
+    err = STATS_RPC (STATS_RPC_NOTICE_CHANGES,
+		     file_notice_changes (np->nn->port,
+					  ports_get_right (notify),
+					  MACH_MSG_TYPE_MAKE_SEND));
+  if (!err)
+    notify->subscribed = 1;
+  else
+    {
+      /*the target cannot notify us, so the cached state will have to be
+         checked by asking it */
+      LOG_AT (LOG_NODE, LOG_LEVEL_DEBUG,
+	      "notify_subscribe: The target does not send notifications.");
+    }
+
+  np->nn->notify = notify;
+  return err;
+}				/*notify_subscribe */
+
+/*---------------------------------------------------------------------------*/
+/*Stops receiving the change notifications for `np`. The node must be
+  locked.*/
+void notify_unsubscribe (struct node *np)
+{
+  notify_t *notify = np->nn->notify;
+
+  if (!notify)
+    return;
+
+  /*Detach the port from the node, so that the notifications which are
+     already on their way are ignored */
+  spin_lock (&netfs_node_refcnt_lock);
+  notify->np = NULL;
+  spin_unlock (&netfs_node_refcnt_lock);
+
+  np->nn->notify = NULL;
+  notify_release (notify);
+}				/*notify_unsubscribe */
+
+/*---------------------------------------------------------------------------*/
+/*Detaches `np`, which is being destroyed, from its notification port, so
+  that the notifications arriving from now on are ignored
+  (`netfs_node_refcnt_lock` must be held)*/
+void notify_detach (struct node *np)
+{
+  if (np->nn->notify)
+    np->nn->notify->np = NULL;
+}				/*notify_detach */
+
+/*---------------------------------------------------------------------------*/
+/*Stops receiving the change notifications for `np`, which is being
+  destroyed and has been detached from its notification port*/
+void notify_destroy (struct node *np)
+{
+  notify_t *notify = np->nn->notify;
+
+  if (!notify)
+    return;
+
+  np->nn->notify = NULL;
+  notify_release (notify);
+}				/*notify_destroy */
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,74 @@
+/*---------------------------------------------------------------------------*/
+/*notify.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for receiving the change notifications of the targets
+  and invalidating the state cached for them*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __NOTIFY_H__
+#define __NOTIFY_H__
+/*---------------------------------------------------------------------------*/
+#include <error.h>
+#include <hurd/ports.h>
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The port on which the change notifications of a target are received*/
+struct notify
+{
+  /*the libports part of the port */
+  struct port_info pi;
+
+  /*the node whose target sends the notifications (NULL once the node has
+     been destroyed; protected by `netfs_node_refcnt_lock`) */
+  struct node *np;
+
+  /*set if the target sends the change notifications to this port (the
+     port also receives the dead-name notification for the target) */
+  int subscribed;
+};				/*struct notify */
+/*---------------------------------------------------------------------------*/
+typedef struct notify notify_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Starts the thread receiving the change notifications*/
+error_t notify_start (void);
+/*---------------------------------------------------------------------------*/
+/*Asks the target of `np` to notify the filter of the changes of the file
+  and of its death. The node must be locked.*/
+error_t notify_subscribe (struct node *np);
+/*---------------------------------------------------------------------------*/
+/*Stops receiving the change notifications for `np`. The node must be
+  locked.*/
+void notify_unsubscribe (struct node *np);
+/*---------------------------------------------------------------------------*/
+/*Detaches `np`, which is being destroyed, from its notification port, so
+  that the notifications arriving from now on are ignored
+  (`netfs_node_refcnt_lock` must be held)*/
+void notify_detach (struct node *np);
+/*---------------------------------------------------------------------------*/
+/*Stops receiving the change notifications for `np`, which is being
+  destroyed and has been detached from its notification port*/
+void notify_destroy (struct node *np);
+/*---------------------------------------------------------------------------*/
+#endif /*__NOTIFY_H__*/
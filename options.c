@@ -28,11 +28,14 @@
 #define _GNU_SOURCE 1
 /*---------------------------------------------------------------------------*/
 #include <argp.h>
+#include <stdlib.h>
 #include <error.h>
 /*---------------------------------------------------------------------------*/
 #include "debug.h"
 #include "options.h"
 #include "node.h"
+#include "stats.h"
+#include "span.h"
 /*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
@@ -55,6 +58,11 @@ static
   error_t
   argp_parse_startup_options (int key, char *arg, struct argp_state *state);
 /*---------------------------------------------------------------------------*/
+/*Argp parser function for the runtime options*/
+static
+  error_t
+  argp_parse_runtime_options (int key, char *arg, struct argp_state *state);
+/*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*--------Global Variables---------------------------------------------------*/
@@ -64,12 +72,96 @@ static int parsing_startup_options_finished;
 /*---------------------------------------------------------------------------*/
 /*Argp options common to both the runtime and the startup parser*/
 static const struct argp_option argp_common_options[] = {
+  {OPT_LONG_CACHE_SIZE, OPT_CACHE_SIZE, "SIZE", 0,
+   "Cache at most SIZE kilobytes of the data read from each node "
+   "(0, the default, disables caching); the reads of at least 64 "
+   "kilobytes which the cache cannot serve completely are passed "
+   "through to the target without caching their data"},
+  {OPT_LONG_READAHEAD_MIN, OPT_READAHEAD_MIN, "SIZE", 0,
+   "Start reading SIZE kilobytes ahead of the clients once their reads "
+   "are seen to be sequential (0 disables read-ahead, which is also "
+   "disabled when the block cache is)"},
+  {OPT_LONG_READAHEAD_MAX, OPT_READAHEAD_MAX, "SIZE", 0,
+   "Never read more than SIZE kilobytes ahead of the clients"},
+  {OPT_LONG_WRITEBACK_AGE, OPT_WRITEBACK_AGE, "MSEC", 0,
+   "In write-back mode, write out the data which has stayed in the filter "
+   "for MSEC milliseconds"},
+  {OPT_LONG_WRITEBACK_SIZE, OPT_WRITEBACK_SIZE, "SIZE", 0,
+   "In write-back mode, write out the data of a node as soon as SIZE "
+   "kilobytes of it have been buffered; larger writes are not buffered"},
+  {OPT_LONG_STAT_TTL, OPT_STAT_TTL, "MSEC", 0,
+   "Use the stat information of a node for MSEC milliseconds before "
+   "asking the target again (0, the default, disables caching)"},
+  {OPT_LONG_STAT_HOLD, OPT_STAT_HOLD, 0, 0,
+   "Use the stat information of a node until the node is written to, "
+   "truncated or the information is invalidated with --"
+   OPT_LONG_INVALIDATE},
+  {OPT_LONG_NEGATIVE_TTL, OPT_NEGATIVE_TTL, "MSEC", 0,
+   "Remember for MSEC milliseconds that a name does not exist in a "
+   "directory (0 disables remembering)"},
+  {OPT_LONG_NO_STAT_HOLD, OPT_NO_STAT_HOLD, 0, 0,
+   "Go back to caching the stat information according to --"
+   OPT_LONG_STAT_TTL},
+  {OPT_LONG_LOG, OPT_LOG, "CATEGORY[,...][:LEVEL]", 0,
+   "Log the messages of the categories (general, read, trace, node, perm "
+   "or all) up to LEVEL (off, error, info or debug, the default)"},
+  {OPT_LONG_SPANS, OPT_SPANS, "N", 0,
+   "Record the time spans of one in N callbacks and of the requests they "
+   "send (0, the default, disables this)"},
   {0}
 };
 
 /*---------------------------------------------------------------------------*/
 /*Argp options only meaningful for startupp parsing*/
 static const struct argp_option argp_startup_options[] = {
+  {OPT_LONG_CACHE_BLOCK_SIZE, OPT_CACHE_BLOCK_SIZE, "SIZE", 0,
+   "Read the data into the cache in blocks of SIZE kilobytes"},
+  {OPT_LONG_WRITEBACK, OPT_WRITEBACK, 0, 0,
+   "Acknowledge the writes as soon as the data is buffered in the filter "
+   "and write it to the target later"},
+  {OPT_LONG_LAZY, OPT_LAZY, 0, 0,
+   "Do not trace the translator stack until the filtered node is accessed "
+   "for the first time"},
+  {OPT_LONG_DIRECTORY, OPT_DIRECTORY, 0, 0,
+   "The target is a directory: filter all the files below it"},
+  {OPT_LONG_SERVER, OPT_SERVER, "FILE", 0,
+   "Let the filter sitting on FILE serve this file instead of starting a "
+   "new filter process (if that fails, start as usual)"},
+  {OPT_LONG_ZYGOTE, OPT_ZYGOTE, 0, 0,
+   "Do not serve this file: initialize once and fork a new filter for "
+   "each node handed over to us with --" OPT_LONG_SERVER},
+  {OPT_LONG_TRACE_TABLE, OPT_TRACE_TABLE, "FILE", 0,
+   "Share the levels at which the translators have been found in the "
+   "stacks with the other filters using the table in FILE"},
+  {OPT_LONG_MAX_THREADS, OPT_MAX_THREADS, "NUM", 0,
+   "Serve the requests in at most NUM threads (0, the default, means no "
+   "limit; a small limit may make the filter wait for itself while it "
+   "traces the stack)"},
+  {OPT_LONG_THREAD_TIMEOUT, OPT_THREAD_TIMEOUT, "MSEC", 0,
+   "Let a server thread exit after it has been idle for MSEC milliseconds "
+   "(0 keeps the idle threads)"},
+  {OPT_LONG_PIPELINE, OPT_PIPELINE, "NUM", 0,
+   "Split the large reads not served from the block cache into chunks and "
+   "send the requests for NUM chunks to the target at once (0, the "
+   "default, disables this)"},
+  {OPT_LONG_PIPELINE_CHUNK, OPT_PIPELINE_CHUNK, "SIZE", 0,
+   "Read the chunks of the large reads in SIZE kilobytes"},
+  {OPT_LONG_LOG_FILE, OPT_LOG_FILE, "FILE", 0,
+   "Write the log to FILE (the default is " LOG_FILE_DEFAULT ")"},
+  {0}
+};
+
+/*---------------------------------------------------------------------------*/
+/*Argp options only meaningful for runtime parsing*/
+static const struct argp_option argp_runtime_options[] = {
+  {OPT_LONG_INVALIDATE, OPT_INVALIDATE, 0, 0,
+   "Drop the stat information cached in all nodes"},
+  {OPT_LONG_RESET_STATS, OPT_RESET_STATS, 0, 0,
+   "Set the counters which fsysopts prints as the --stats-* entries to "
+   "zero"},
+  {OPT_LONG_DUMP_SPANS, OPT_DUMP_SPANS, "FILE", 0,
+   "Write the time spans recorded so far to FILE (an absolute path) in the "
+   "trace format of Chrome"},
   {0}
 };
 
@@ -82,8 +174,13 @@ static const struct argp argp_parser_common_options =
 static const struct argp argp_parser_startup_options =
   { argp_startup_options, argp_parse_startup_options, 0, 0, 0 };
 /*---------------------------------------------------------------------------*/
+/*Argp parser for only the runtime options*/
+static const struct argp argp_parser_runtime_options =
+  { argp_runtime_options, argp_parse_runtime_options, 0, 0, 0 };
+/*---------------------------------------------------------------------------*/
 /*The list of children parsers for runtime arguments*/
 static const struct argp_child argp_children_runtime[] = {
+  {&argp_parser_runtime_options},
   {&argp_parser_common_options},
   {&netfs_std_runtime_argp},
   {0}
@@ -105,6 +202,10 @@ const char *argp_program_version = "0.0";
 /*The arpg parser for runtime arguments*/
 struct argp argp_runtime = { 0, 0, 0, 0, argp_children_runtime };
 
+/*---------------------------------------------------------------------------*/
+/*The argp parser libnetfs uses for runtime arguments (fsysopts)*/
+struct argp *netfs_runtime_argp = &argp_runtime;
+
 /*---------------------------------------------------------------------------*/
 /*The argp parser for startup arguments*/
 struct argp argp_startup = { 0, 0, ARGS_DOC, DOC, argp_children_startup };
@@ -146,6 +247,77 @@ static
 
 	break;
       }
+    case OPT_CACHE_SIZE:
+      {
+	/*set the limit of the block cache of each node */
+	cache_size = strtoul (arg, NULL, 10) * 1024;
+	break;
+      }
+    case OPT_READAHEAD_MIN:
+      {
+	/*set the initial size of the read-ahead window */
+	readahead_min = strtoul (arg, NULL, 10) * 1024;
+	break;
+      }
+    case OPT_READAHEAD_MAX:
+      {
+	/*set the maximal size of the read-ahead window */
+	readahead_max = strtoul (arg, NULL, 10) * 1024;
+	break;
+      }
+    case OPT_WRITEBACK_AGE:
+      {
+	/*set the age after which the dirty data is flushed */
+	writeback_age = strtol (arg, NULL, 10);
+	break;
+      }
+    case OPT_WRITEBACK_SIZE:
+      {
+	/*set the amount of dirty data which causes a flush */
+	writeback_size = strtoul (arg, NULL, 10) * 1024;
+	break;
+      }
+    case OPT_STAT_TTL:
+      {
+	/*set the time the stat information is cached for */
+	stat_ttl = strtol (arg, NULL, 10);
+	break;
+      }
+    case OPT_NEGATIVE_TTL:
+      {
+	/*set the time the missing names are remembered for */
+	negative_ttl = strtol (arg, NULL, 10);
+	break;
+      }
+    case OPT_STAT_HOLD:
+      {
+	/*keep the stat information until it is invalidated */
+	stat_hold = 1;
+	break;
+      }
+    case OPT_NO_STAT_HOLD:
+      {
+	/*keep the stat information only for `stat_ttl` milliseconds */
+	stat_hold = 0;
+	break;
+      }
+    case OPT_LOG:
+      {
+	/*change the levels of the categories of messages */
+	if (log_configure (arg))
+	  argp_error (state, "Invalid log specification: %s.", arg);
+
+	break;
+      }
+    case OPT_SPANS:
+      {
+	/*record one in so many callbacks */
+	err = span_enable (atoi (arg));
+	if (err == EINVAL)
+	  argp_error (state, "The sampling rate cannot be negative.");
+
+	break;
+      }
       /*If the option could not be recognized */
     default:
       {
@@ -169,6 +341,99 @@ static
 
   switch (key)
     {
+    case OPT_CACHE_BLOCK_SIZE:
+      {
+	/*set the size of the cached blocks, which cannot be zero */
+	cache_block_size = strtoul (arg, NULL, 10) * 1024;
+	if (!cache_block_size)
+	  argp_error (state, "The size of a cached block cannot be zero.");
+
+	break;
+      }
+    case OPT_WRITEBACK:
+      {
+	/*buffer the written data */
+	writeback = 1;
+	break;
+      }
+    case OPT_LAZY:
+      {
+	/*defer tracing the stack */
+	lazy = 1;
+	break;
+      }
+    case OPT_DIRECTORY:
+      {
+	/*serve the directory tree */
+	directory = 1;
+	break;
+      }
+    case OPT_ZYGOTE:
+      {
+	/*fork the filters for the other nodes */
+	zygote = 1;
+	break;
+      }
+    case OPT_MAX_THREADS:
+      {
+	/*bound the number of server threads */
+	max_threads = strtol (arg, NULL, 10);
+	if (max_threads < 0)
+	  argp_error (state, "The number of threads cannot be negative.");
+
+	break;
+      }
+    case OPT_THREAD_TIMEOUT:
+      {
+	/*set the time after which idle server threads exit */
+	thread_timeout = strtol (arg, NULL, 10);
+	break;
+      }
+    case OPT_PIPELINE:
+      {
+	/*set the number of chunks read at once */
+	pipeline_depth = strtol (arg, NULL, 10);
+	break;
+      }
+    case OPT_PIPELINE_CHUNK:
+      {
+	/*set the size of the chunks, which cannot be zero */
+	pipeline_chunk = strtoul (arg, NULL, 10) * 1024;
+	if (!pipeline_chunk)
+	  argp_error (state, "The size of a chunk cannot be zero.");
+
+	break;
+      }
+    case OPT_TRACE_TABLE:
+      {
+	/*share the traced stacks through the file */
+	tracetab_file = strdup (arg);
+	if (!tracetab_file)
+	  error (EXIT_FAILURE, ENOMEM, "argp_parse_startup_options: "
+		 "Could not strdup the trace table file name");
+
+	break;
+      }
+    case OPT_LOG_FILE:
+      {
+	/*write the log elsewhere */
+	log_file = strdup (arg);
+	if (!log_file)
+	  error (EXIT_FAILURE, ENOMEM, "argp_parse_startup_options: "
+		 "Could not strdup the log file name");
+
+	break;
+      }
+    case OPT_SERVER:
+      {
+	/*hand the node over to another filter */
+	server_file = strdup (arg);
+	if (!server_file)
+	  error (EXIT_FAILURE, ENOMEM, "argp_parse_startup_options: "
+		 "Could not strdup the server file name");
+
+	break;
+      }
     default:
       {
 	err = ARGP_ERR_UNKNOWN;
@@ -181,3 +446,42 @@ static
 }				/*argp_parse_startup_options */
 
 /*---------------------------------------------------------------------------*/
+/*Argp parser function for the runtime options*/
+static
+  error_t
+  argp_parse_runtime_options (int key, char *arg, struct argp_state *state)
+{
+  error_t err = 0;
+
+  switch (key)
+    {
+    case OPT_INVALIDATE:
+      {
+	/*make the stat information of all nodes stale */
+	++stat_generation;
+	break;
+      }
+    case OPT_RESET_STATS:
+      {
+	/*start counting anew */
+	stats_reset ();
+	break;
+      }
+    case OPT_DUMP_SPANS:
+      {
+	/*let the spans be looked at */
+	err = span_dump (arg);
+	break;
+      }
+    default:
+      {
+	err = ARGP_ERR_UNKNOWN;
+
+	break;
+      }
+    }
+
+  return err;
+}				/*argp_parse_runtime_options */
+
+/*---------------------------------------------------------------------------*/
@@ -31,6 +31,62 @@
 /*Makes a long option out of option name*/
 #define OPT_LONG(o) "--"o
 /*---------------------------------------------------------------------------*/
+/*The options recognized by the filter*/
+#define OPT_CACHE_SIZE       'c'
+#define OPT_CACHE_BLOCK_SIZE 'b'
+#define OPT_READAHEAD_MIN    256
+#define OPT_READAHEAD_MAX    257
+#define OPT_WRITEBACK        'w'
+#define OPT_WRITEBACK_AGE    258
+#define OPT_WRITEBACK_SIZE   259
+#define OPT_STAT_TTL         260
+#define OPT_STAT_HOLD        261
+#define OPT_NO_STAT_HOLD     262
+#define OPT_INVALIDATE       263
+#define OPT_LAZY             'l'
+#define OPT_DIRECTORY        'd'
+#define OPT_NEGATIVE_TTL     264
+#define OPT_SERVER           265
+#define OPT_ZYGOTE           266
+#define OPT_TRACE_TABLE      267
+#define OPT_MAX_THREADS      268
+#define OPT_THREAD_TIMEOUT   269
+#define OPT_PIPELINE         270
+#define OPT_PIPELINE_CHUNK   271
+#define OPT_LOG              272
+#define OPT_LOG_FILE         273
+#define OPT_RESET_STATS      274
+#define OPT_SPANS            275
+#define OPT_DUMP_SPANS       276
+/*---------------------------------------------------------------------------*/
+/*The long names of the options*/
+#define OPT_LONG_CACHE_SIZE       "cache-size"
+#define OPT_LONG_CACHE_BLOCK_SIZE "cache-block-size"
+#define OPT_LONG_READAHEAD_MIN    "readahead-min"
+#define OPT_LONG_READAHEAD_MAX    "readahead-max"
+#define OPT_LONG_WRITEBACK        "writeback"
+#define OPT_LONG_WRITEBACK_AGE    "writeback-age"
+#define OPT_LONG_WRITEBACK_SIZE   "writeback-size"
+#define OPT_LONG_STAT_TTL         "stat-ttl"
+#define OPT_LONG_STAT_HOLD        "stat-hold"
+#define OPT_LONG_NO_STAT_HOLD     "no-stat-hold"
+#define OPT_LONG_INVALIDATE       "invalidate"
+#define OPT_LONG_LAZY             "lazy"
+#define OPT_LONG_DIRECTORY        "directory"
+#define OPT_LONG_NEGATIVE_TTL     "negative-ttl"
+#define OPT_LONG_SERVER           "server"
+#define OPT_LONG_ZYGOTE           "zygote"
+#define OPT_LONG_TRACE_TABLE      "trace-table"
+#define OPT_LONG_MAX_THREADS      "max-threads"
+#define OPT_LONG_THREAD_TIMEOUT   "thread-timeout"
+#define OPT_LONG_PIPELINE         "pipeline"
+#define OPT_LONG_PIPELINE_CHUNK   "pipeline-chunk"
+#define OPT_LONG_LOG              "log"
+#define OPT_LONG_LOG_FILE         "log-file"
+#define OPT_LONG_RESET_STATS      "reset-stats"
+#define OPT_LONG_SPANS            "spans"
+#define OPT_LONG_DUMP_SPANS       "dump-spans"
+/*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
 /*--------Global Variables---------------------------------------------------*/
@@ -43,4 +99,70 @@ extern struct argp argp_runtime;
 /*The name of the translator to filter out*/
 extern char *target_name;
 /*---------------------------------------------------------------------------*/
+/*Set if the target should be found only when it is accessed first*/
+extern int lazy;
+/*---------------------------------------------------------------------------*/
+/*Set if the filter should serve the whole directory tree of the target*/
+extern int directory;
+/*---------------------------------------------------------------------------*/
+/*The file on which the filter serving the files of other filters sits*/
+extern char *server_file;
+/*---------------------------------------------------------------------------*/
+/*Set if the filter should only fork new filters for the nodes handed over
+  to it*/
+extern int zygote;
+/*---------------------------------------------------------------------------*/
+/*The file the table of the traced stacks shared by the filters is mapped
+  from*/
+extern char *tracetab_file;
+/*---------------------------------------------------------------------------*/
+/*The maximal number of threads serving the requests (0 means no limit)*/
+extern int max_threads;
+/*---------------------------------------------------------------------------*/
+/*The time (in milliseconds) after which an idle server thread exits*/
+extern int thread_timeout;
+/*---------------------------------------------------------------------------*/
+/*The number of requests sent to the target at once for a large read*/
+extern int pipeline_depth;
+/*---------------------------------------------------------------------------*/
+/*The size of a chunk read by a single request to the target*/
+extern size_t pipeline_chunk;
+/*---------------------------------------------------------------------------*/
+/*The file the messages are written to*/
+extern char *log_file;
+/*---------------------------------------------------------------------------*/
+/*The time (in milliseconds) a missing name is remembered for*/
+extern int negative_ttl;
+/*---------------------------------------------------------------------------*/
+/*The maximal number of bytes cached for a single node*/
+extern size_t cache_size;
+/*---------------------------------------------------------------------------*/
+/*The size of a cached block*/
+extern size_t cache_block_size;
+/*---------------------------------------------------------------------------*/
+/*The initial size of the read-ahead window*/
+extern size_t readahead_min;
+/*---------------------------------------------------------------------------*/
+/*The maximal size of the read-ahead window*/
+extern size_t readahead_max;
+/*---------------------------------------------------------------------------*/
+/*Set if the written data should be buffered*/
+extern int writeback;
+/*---------------------------------------------------------------------------*/
+/*The age (in milliseconds) after which dirty data is flushed*/
+extern int writeback_age;
+/*---------------------------------------------------------------------------*/
+/*The amount of dirty data of a node which causes a flush*/
+extern size_t writeback_size;
+/*---------------------------------------------------------------------------*/
+/*The time (in milliseconds) the stat information of a node is cached for*/
+extern int stat_ttl;
+/*---------------------------------------------------------------------------*/
+/*Set if the stat information should be cached until it is explicitly
+  invalidated*/
+extern int stat_hold;
+/*---------------------------------------------------------------------------*/
+/*Incremented to invalidate the stat information cached in all nodes*/
+extern unsigned long stat_generation;
+/*---------------------------------------------------------------------------*/
 #endif /*__OPTIONS_H__*/
@@ -0,0 +1,235 @@
+/*---------------------------------------------------------------------------*/
+/*pipeline.c*/
+/*---------------------------------------------------------------------------*/
+/*Reading large requests from the target in several chunks at once*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include <cthreads.h>
+#include <sys/mman.h>
+#include <hurd/io.h>
+/*---------------------------------------------------------------------------*/
+#include "debug.h"
+#include "pipeline.h"
+#include "stats.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The number of requests sent to the target at once for a large read (0 or
+  1 disables splitting the reads)*/
+int pipeline_depth = 0;
+/*---------------------------------------------------------------------------*/
+/*The size of a chunk read by a single request to the target*/
+size_t pipeline_chunk = PIPELINE_CHUNK_DEFAULT;
+/*---------------------------------------------------------------------------*/
+/*The requests with chunks nobody has taken yet*/
+static pipeline_request_t *pipeline_queue;
+/*---------------------------------------------------------------------------*/
+/*The lock protecting the queue and the state of the requests*/
+static struct mutex pipeline_lock = MUTEX_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+/*Signalled when a request is queued and when the last chunk of a request
+  has been read*/
+static struct condition pipeline_queued = CONDITION_INITIALIZER;
+static struct condition pipeline_done = CONDITION_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Takes the next chunk of `req` and removes the request from the queue if
+  this was the last one; the lock must be held*/
+static int pipeline_take (pipeline_request_t * req)
+{
+  pipeline_request_t **prevp;
+  int i = req->next++;
+
+  if (req->next == req->nchunks)
+    for (prevp = &pipeline_queue; *prevp; prevp = &(*prevp)->next_request)
+      if (*prevp == req)
+	{
+	  *prevp = req->next_request;
+	  break;
+	}
+
+  return i;
+}				/*pipeline_take */
+
+/*---------------------------------------------------------------------------*/
+/*Reads the chunk `i` of `req` into its place in the buffer and records the
+  result (the lock must not be held)*/
+static void pipeline_chunk_read (pipeline_request_t * req, int i)
+{
+  error_t err = 0;
+
+  /*The part of the buffer the chunk goes to and the part filled so far */
+  char *start = req->data + i * req->chunk;
+  size_t want = req->chunk, got = 0, copied = 0;
+
+  if ((i + 1) * req->chunk > req->len)
+    want = req->len - i * req->chunk;
+
+  /*The target may return less than asked for, so ask again until the
+     chunk is full or the end of the file is reached */
+  while (!err && (got < want))
+    {
+      char *buf = start + got;
+      mach_msg_type_number_t len = want - got;
+      loff_t at = req->offset + i * req->chunk + got;
+
+      err = STATS_RPC (STATS_RPC_IO_READ,
+		       io_read (req->port, &buf, &len, at, want - got));
+      if (err)
+	break;
+
+      /*if the target has returned the data out of line, move it in place */
+      if (buf != start + got)
+	{
+	  memcpy (start + got, buf, len);
+	  munmap (buf, len);
+	  copied += len;
+	}
+
+      if (!len)
+	break;
+      got += len;
+    }
+
+  mutex_lock (&pipeline_lock);
+
+  req->got[i] = got;
+  req->errs[i] = err;
+  req->copied += copied;
+
+  if (--req->pending == 0)
+    condition_broadcast (&pipeline_done);
+
+  mutex_unlock (&pipeline_lock);
+}				/*pipeline_chunk_read */
+
+/*---------------------------------------------------------------------------*/
+/*The body of a thread reading the chunks of the queued requests*/
+static any_t pipeline_thread (any_t arg)
+{
+  pipeline_request_t *req;
+  int i;
+
+  for (;;)
+    {
+      mutex_lock (&pipeline_lock);
+      while (!pipeline_queue)
+	condition_wait (&pipeline_queued, &pipeline_lock);
+
+      req = pipeline_queue;
+      i = pipeline_take (req);
+      mutex_unlock (&pipeline_lock);
+
+      pipeline_chunk_read (req, i);
+    }
+
+  return 0;
+}				/*pipeline_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Starts the threads reading the chunks*/
+error_t pipeline_start (void)
+{
+  int i;
+
+  /*The thread serving the client reads chunks, too */
+  for (i = 1; i < pipeline_depth; ++i)
+    cthread_detach (cthread_fork (pipeline_thread, 0));
+
+  return 0;
+}				/*pipeline_start */
+
+/*---------------------------------------------------------------------------*/
+/*Reads up to `len` bytes from `offset` of `port` into `data`, sending the
+  requests for up to `pipeline_depth` chunks at once, and reports the
+  number of bytes which had to be copied to do so*/
+error_t
+  pipeline_read
+  (mach_port_t port, loff_t offset, size_t * len, char *data,
+   size_t * copied)
+{
+  error_t err = 0;
+  pipeline_request_t req;
+  int i;
+
+  req.port = port;
+  req.offset = offset;
+  req.data = data;
+  req.len = *len;
+  req.chunk = pipeline_chunk;
+  req.nchunks = (req.len + req.chunk - 1) / req.chunk;
+  req.next = 0;
+  req.pending = req.nchunks;
+  req.copied = 0;
+
+  req.got = alloca (req.nchunks * sizeof (size_t));
+  req.errs = alloca (req.nchunks * sizeof (error_t));
+
+  /*Let the reading threads help */
+  mutex_lock (&pipeline_lock);
+  req.next_request = pipeline_queue;
+  pipeline_queue = &req;
+  condition_broadcast (&pipeline_queued);
+
+  /*Read the chunks nobody has taken, then wait for the others */
+  while (req.next < req.nchunks)
+    {
+      i = pipeline_take (&req);
+      mutex_unlock (&pipeline_lock);
+
+      pipeline_chunk_read (&req, i);
+
+      mutex_lock (&pipeline_lock);
+    }
+  while (req.pending)
+    condition_wait (&pipeline_done, &pipeline_lock);
+  mutex_unlock (&pipeline_lock);
+
+  /*The data read is the chunks up to the first one which is not full */
+  *len = 0;
+  for (i = 0; i < req.nchunks; ++i)
+    {
+      *len += req.got[i];
+      if (req.errs[i] || (req.got[i] < req.chunk))
+	break;
+    }
+
+  /*An error is reported only if no data precedes it */
+  if ((i < req.nchunks) && req.errs[i] && !*len)
+    err = req.errs[i];
+
+  LOG_AT (LOG_READ, LOG_LEVEL_DEBUG,
+	  "pipeline_read: %d chunks, %lu bytes read.", req.nchunks,
+	  (unsigned long) *len);
+
+  *copied = req.copied;
+  return err;
+}				/*pipeline_read */
+
+/*---------------------------------------------------------------------------*/
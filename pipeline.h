@@ -0,0 +1,101 @@
+/*---------------------------------------------------------------------------*/
+/*pipeline.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for reading large requests from the target in several
+  chunks at once*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+/*---------------------------------------------------------------------------*/
+#include <error.h>
+#include <sys/types.h>
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The default size of a chunk read by a single request to the target*/
+#define PIPELINE_CHUNK_DEFAULT (64 * 1024)
+/*---------------------------------------------------------------------------*/
+/*Checks whether a read of `len` bytes should be split into chunks*/
+#define PIPELINE_READ(len) \
+  ((pipeline_depth > 1) && ((len) >= 2 * pipeline_chunk))
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A large read split into chunks read concurrently*/
+struct pipeline_request
+{
+  /*the port to read from, the offset to start at and the buffer to
+     fill */
+  mach_port_t port;
+  loff_t offset;
+  char *data;
+
+  /*the number of bytes requested and the size of a chunk */
+  size_t len;
+  size_t chunk;
+
+  /*the number of chunks, the number of the next chunk nobody has taken
+     yet and the number of chunks not read yet */
+  int nchunks;
+  int next;
+  int pending;
+
+  /*the number of bytes read into each chunk and the error of each chunk */
+  size_t *got;
+  error_t *errs;
+
+  /*the number of bytes copied because the target has returned the data
+     in its own buffer */
+  size_t copied;
+
+  /*the next request with chunks nobody has taken yet */
+  struct pipeline_request *next_request;
+};				/*struct pipeline_request */
+/*---------------------------------------------------------------------------*/
+typedef struct pipeline_request pipeline_request_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The number of requests sent to the target at once for a large read (0 or
+  1 disables splitting the reads)*/
+extern int pipeline_depth;
+/*---------------------------------------------------------------------------*/
+/*The size of a chunk read by a single request to the target*/
+extern size_t pipeline_chunk;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Starts the threads reading the chunks*/
+error_t pipeline_start (void);
+/*---------------------------------------------------------------------------*/
+/*Reads up to `len` bytes from `offset` of `port` into `data`, sending the
+  requests for up to `pipeline_depth` chunks at once, and reports the
+  number of bytes which had to be copied to do so*/
+error_t
+  pipeline_read
+  (mach_port_t port, loff_t offset, size_t * len, char *data,
+   size_t * copied);
+/*---------------------------------------------------------------------------*/
+#endif /*__PIPELINE_H__*/
@@ -0,0 +1,268 @@
+/*---------------------------------------------------------------------------*/
+/*readahead.c*/
+/*---------------------------------------------------------------------------*/
+/*Detection of sequential reads and prefetching of the data the clients
+  are about to ask for*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include <cthreads.h>
+/*---------------------------------------------------------------------------*/
+#include "debug.h"
+#include "node.h"
+#include "readahead.h"
+#include "stats.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A region of a node waiting to be prefetched*/
+struct readahead_request
+{
+  /*the node to read from (a reference is held) */
+  struct node *np;
+
+  /*the region to read */
+  loff_t offset;
+  size_t len;
+
+  /*the next request in the queue */
+  struct readahead_request *next;
+};				/*struct readahead_request */
+/*---------------------------------------------------------------------------*/
+typedef struct readahead_request readahead_request_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The initial size of the read-ahead window (0 disables read-ahead)*/
+size_t readahead_min = READAHEAD_MIN_DEFAULT;
+/*---------------------------------------------------------------------------*/
+/*The maximal size of the read-ahead window*/
+size_t readahead_max = READAHEAD_MAX_DEFAULT;
+/*---------------------------------------------------------------------------*/
+/*The queue of the prefetch requests and its length*/
+static readahead_request_t *queue_head, *queue_tail;
+static int queue_len;
+/*---------------------------------------------------------------------------*/
+/*The lock protecting the queue*/
+static struct mutex queue_lock = MUTEX_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+/*Signalled when a request is added to the queue*/
+static struct condition queue_cond = CONDITION_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Adds a request to prefetch `len` bytes from `offset` of `np` to the
+  queue; the request is dropped if the queue is full*/
+static void readahead_queue (struct node *np, loff_t offset, size_t len)
+{
+  readahead_request_t *req;
+
+  mutex_lock (&queue_lock);
+
+  /*If the prefetch thread is too far behind, do not make things worse */
+  if (queue_len >= READAHEAD_QUEUE_MAX)
+    {
+      mutex_unlock (&queue_lock);
+      return;
+    }
+
+  req = malloc (sizeof (readahead_request_t));
+  if (!req)
+    {
+      mutex_unlock (&queue_lock);
+      return;
+    }
+
+  /*The node must live until the request is served */
+  netfs_nref (np);
+
+  req->np = np;
+  req->offset = offset;
+  req->len = len;
+  req->next = NULL;
+
+  /*Append the request to the queue */
+  if (queue_tail)
+    queue_tail->next = req;
+  else
+    queue_head = req;
+  queue_tail = req;
+  ++queue_len;
+
+  /*Wake up the prefetch thread */
+  condition_signal (&queue_cond);
+  mutex_unlock (&queue_lock);
+}				/*readahead_queue */
+
+/*---------------------------------------------------------------------------*/
+/*The prefetch thread: reads the queued regions into the block caches*/
+static any_t readahead_thread (any_t arg)
+{
+  readahead_request_t *req;
+
+  for (;;)
+    {
+      /*wait for a request */
+      mutex_lock (&queue_lock);
+      while (!queue_head)
+	condition_wait (&queue_cond, &queue_lock);
+
+      req = queue_head;
+      queue_head = req->next;
+      if (!queue_head)
+	queue_tail = NULL;
+      --queue_len;
+      mutex_unlock (&queue_lock);
+
+      /*read the blocks covering the region, stopping at the end of file */
+      loff_t index = req->offset / cache_block_size;
+      loff_t last = (req->offset + req->len - 1) / cache_block_size;
+      int eof = 0;
+
+      /*the port may be replaced while we are reading, so use our own
+         reference to it */
+      mach_port_t port = MACH_PORT_NULL;
+      mutex_lock (&req->np->lock);
+      error_t err = node_get_port (req->np, &port);
+      mutex_unlock (&req->np->lock);
+
+      for (; !err && !eof && (index <= last); ++index)
+	{
+	  err = cache_prefetch (&req->np->nn->cache, port, index, &eof);
+	  if (!err)
+	    STATS_ADD (stats_readahead_blocks, 1);
+	}
+
+      if (MACH_PORT_VALID (port))
+	PORT_DEALLOC (port);
+
+      LOG_AT (LOG_READ, LOG_LEVEL_DEBUG,
+	      "readahead_thread: Prefetched %lu bytes from %lu.",
+	      (unsigned long) req->len, (unsigned long) req->offset);
+
+      /*drop the reference to the node */
+      netfs_nrele (req->np);
+      free (req);
+    }
+
+  return 0;
+}				/*readahead_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Initializes the read-ahead state of a node*/
+void readahead_init (readahead_t * ra)
+{
+  memset (ra, 0, sizeof (readahead_t));
+}				/*readahead_init */
+
+/*---------------------------------------------------------------------------*/
+/*Starts the prefetch thread*/
+error_t readahead_start (void)
+{
+  /*Start the thread, we will never wait for it */
+  cthread_detach (cthread_fork (readahead_thread, 0));
+  return 0;
+}				/*readahead_start */
+
+/*---------------------------------------------------------------------------*/
+/*Records that `len` bytes have been read from `offset` of node `np`
+  through the open `po` and queues prefetching if the reads of this open
+  are sequential. The node must be locked.*/
+void readahead_note (struct node *np, void *po, loff_t offset, size_t len)
+{
+  readahead_t *ra = &np->nn->ra;
+  readahead_stream_t *stream = NULL;
+  int i;
+
+  if (!READAHEAD_ENABLED)
+    return;
+
+  ++ra->uses;
+
+  /*Find the stream of this open or the least recently used one */
+  for (i = 0; i < READAHEAD_STREAMS; ++i)
+    {
+      if (ra->streams[i].po == po)
+	{
+	  stream = &ra->streams[i];
+	  break;
+	}
+
+      if (!stream || (ra->streams[i].last_use < stream->last_use))
+	stream = &ra->streams[i];
+    }
+
+  /*If this read continues the previous one of the same open */
+  if ((stream->po == po) && (offset == stream->next))
+    {
+      /*grow the window */
+      stream->window = stream->window ? stream->window * 2 : readahead_min;
+      if (stream->window > readahead_max)
+	stream->window = readahead_max;
+    }
+  else
+    {
+      /*start tracking this open anew without reading ahead */
+      stream->po = po;
+      stream->window = 0;
+      stream->queued = 0;
+    }
+
+  stream->next = offset + len;
+  stream->last_use = ra->uses;
+
+  /*If the reads are sequential, queue the part of the window which has
+     not been queued yet */
+  if (stream->window)
+    {
+      loff_t start = (stream->queued > stream->next)
+	? stream->queued : stream->next;
+      loff_t end = stream->next + stream->window;
+
+      if (end > start)
+	{
+	  readahead_queue (np, start, end - start);
+	  stream->queued = end;
+	}
+    }
+}				/*readahead_note */
+
+/*---------------------------------------------------------------------------*/
+/*Forgets the stream of the open `po` of node `np`, so that an open which
+  later gets the same address does not inherit it. The node must be
+  locked.*/
+void readahead_forget (struct node *np, void *po)
+{
+  readahead_t *ra = &np->nn->ra;
+  int i;
+
+  for (i = 0; i < READAHEAD_STREAMS; ++i)
+    if (ra->streams[i].po == po)
+      memset (&ra->streams[i], 0, sizeof (readahead_stream_t));
+}				/*readahead_forget */
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,112 @@
+/*---------------------------------------------------------------------------*/
+/*readahead.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for detecting sequential reads and prefetching the data
+  the clients are about to ask for*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __READAHEAD_H__
+#define __READAHEAD_H__
+/*---------------------------------------------------------------------------*/
+#include <error.h>
+#include <sys/types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The number of streams tracked for a single node*/
+#define READAHEAD_STREAMS 4
+/*---------------------------------------------------------------------------*/
+/*The maximal number of prefetch requests waiting for the prefetch thread*/
+#define READAHEAD_QUEUE_MAX 64
+/*---------------------------------------------------------------------------*/
+/*The default limits of the read-ahead window*/
+#define READAHEAD_MIN_DEFAULT (64 * 1024)
+#define READAHEAD_MAX_DEFAULT (1024 * 1024)
+/*---------------------------------------------------------------------------*/
+/*Checks whether read-ahead should be done at all*/
+#define READAHEAD_ENABLED (readahead_min && CACHE_ENABLED)
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The state of a sequence of reads through one open of a node*/
+struct readahead_stream
+{
+  /*the open this stream belongs to (used only as a key; cleared when the
+     open is released) */
+  void *po;
+
+  /*the offset at which the next sequential read will start */
+  loff_t next;
+
+  /*the current size of the read-ahead window (0 until the reads are seen
+     to be sequential) */
+  size_t window;
+
+  /*the end of the region already queued for prefetching */
+  loff_t queued;
+
+  /*the value of the access counter of the node at the last read */
+  unsigned long last_use;
+};				/*struct readahead_stream */
+/*---------------------------------------------------------------------------*/
+typedef struct readahead_stream readahead_stream_t;
+/*---------------------------------------------------------------------------*/
+/*The read-ahead state of a node (protected by the lock of the node)*/
+struct readahead
+{
+  /*the streams reading the node */
+  readahead_stream_t streams[READAHEAD_STREAMS];
+
+  /*incremented on each read of the node */
+  unsigned long uses;
+};				/*struct readahead */
+/*---------------------------------------------------------------------------*/
+typedef struct readahead readahead_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The initial size of the read-ahead window (0 disables read-ahead)*/
+extern size_t readahead_min;
+/*---------------------------------------------------------------------------*/
+/*The maximal size of the read-ahead window*/
+extern size_t readahead_max;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Initializes the read-ahead state of a node*/
+void readahead_init (readahead_t * ra);
+/*---------------------------------------------------------------------------*/
+/*Starts the prefetch thread*/
+error_t readahead_start (void);
+/*---------------------------------------------------------------------------*/
+/*Records that `len` bytes have been read from `offset` of node `np`
+  through the open `po` and queues prefetching if the reads of this open
+  are sequential. The node must be locked.*/
+void readahead_note (struct node *np, void *po, loff_t offset, size_t len);
+/*---------------------------------------------------------------------------*/
+/*Forgets the stream of the open `po` of node `np`, so that an open which
+  later gets the same address does not inherit it. The node must be
+  locked.*/
+void readahead_forget (struct node *np, void *po);
+/*---------------------------------------------------------------------------*/
+#endif /*__READAHEAD_H__*/
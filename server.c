@@ -0,0 +1,155 @@
+/*---------------------------------------------------------------------------*/
+/*server.c*/
+/*---------------------------------------------------------------------------*/
+/*The pool of threads serving the requests of the clients*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <cthreads.h>
+#include <hurd/ports.h>
+#include <hurd/netfs.h>
+/*---------------------------------------------------------------------------*/
+#include "debug.h"
+#include "server.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The maximal number of threads serving the requests (0 means no limit)*/
+int max_threads = 0;
+/*---------------------------------------------------------------------------*/
+/*The time (in milliseconds) after which an idle server thread exits*/
+int thread_timeout = THREAD_TIMEOUT_DEFAULT;
+/*---------------------------------------------------------------------------*/
+/*The number of server threads and the number of those waiting for a
+  request*/
+static int server_threads;
+static int server_idle;
+/*---------------------------------------------------------------------------*/
+/*The number of requests served so far (protected by `server_lock`)*/
+static unsigned long server_requests;
+/*---------------------------------------------------------------------------*/
+/*The lock protecting the numbers of threads*/
+static struct mutex server_lock = MUTEX_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Forward Declarations-----------------------------------------------*/
+/*The body of a server thread*/
+static any_t server_thread (any_t arg);
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Serves a single request, starting another server thread if this one was
+  the last waiting for requests and the limit allows it*/
+static int server_demuxer (mach_msg_header_t * in, mach_msg_header_t * out)
+{
+  int spawn, ret;
+
+  mutex_lock (&server_lock);
+  ++server_requests;
+  spawn = (--server_idle == 0)
+    && (!max_threads || (server_threads < max_threads));
+  if (spawn)
+    {
+      ++server_threads;
+      ++server_idle;
+    }
+  mutex_unlock (&server_lock);
+
+  if (spawn)
+    cthread_detach (cthread_fork (server_thread, 0));
+
+  ret = netfs_demuxer (in, out);
+
+  mutex_lock (&server_lock);
+  ++server_idle;
+  mutex_unlock (&server_lock);
+
+  return ret;
+}				/*server_demuxer */
+
+/*---------------------------------------------------------------------------*/
+/*The body of a server thread*/
+static any_t server_thread (any_t arg)
+{
+  /*The time the filter has been idle for, as seen by the last thread, and
+     the number of requests at the moment it has last checked it */
+  int idle = 0;
+  unsigned long requests = 0;
+
+  for (;;)
+    {
+      /*serve the requests until none has come for `thread_timeout` */
+      ports_manage_port_operations_one_thread
+	(netfs_port_bucket, server_demuxer, thread_timeout);
+
+      /*an idle thread exits, unless it is the only one */
+      mutex_lock (&server_lock);
+      if (server_threads > 1)
+	{
+	  --server_threads;
+	  --server_idle;
+	  mutex_unlock (&server_lock);
+
+	  EXIT_LOG ();
+	  return 0;
+	}
+
+      /*the last thread counts the time without requests */
+      idle = (server_requests == requests) ? idle + thread_timeout
+	: thread_timeout;
+      requests = server_requests;
+      mutex_unlock (&server_lock);
+
+      /*if nobody has used the filter for long, go away if possible */
+      if (idle >= SERVER_TIMEOUT)
+	{
+	  if (!netfs_shutdown (0))
+	    exit (0);
+	  idle = 0;
+	}
+    }
+}				/*server_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Serves the requests to the ports of libnetfs in the calling thread and in
+  as many threads as needed, but no more than `max_threads`; never returns*/
+void server_loop (void)
+{
+  /*The calling thread may have been forked off a process with a pool of
+     its own, so start counting afresh */
+  mutex_init (&server_lock);
+  server_threads = 1;
+  server_idle = 1;
+
+  LOG_AT (LOG_GENERAL, LOG_LEVEL_INFO,
+	  "server_loop: At most %d threads, idle timeout %d ms.", max_threads,
+	  thread_timeout);
+
+  server_thread (0);
+}				/*server_loop */
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,55 @@
+/*---------------------------------------------------------------------------*/
+/*server.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for the pool of threads serving the requests of the
+  clients*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __SERVER_H__
+#define __SERVER_H__
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The time (in milliseconds) after which an idle server thread exits by
+  default (the same as in libnetfs)*/
+#define THREAD_TIMEOUT_DEFAULT (2 * 60 * 1000)
+/*---------------------------------------------------------------------------*/
+/*The time (in milliseconds) without requests after which the filter tries
+  to go away (the same as in libnetfs)*/
+#define SERVER_TIMEOUT (10 * 60 * 1000)
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The maximal number of threads serving the requests (0 means no limit)*/
+extern int max_threads;
+/*---------------------------------------------------------------------------*/
+/*The time (in milliseconds) after which an idle server thread exits*/
+extern int thread_timeout;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Serves the requests to the ports of libnetfs in the calling thread and in
+  as many threads as needed, but no more than `max_threads`; never returns*/
+void server_loop (void);
+/*---------------------------------------------------------------------------*/
+#endif /*__SERVER_H__*/
@@ -0,0 +1,193 @@
+/*---------------------------------------------------------------------------*/
+/*span.c*/
+/*---------------------------------------------------------------------------*/
+/*The recorder of the time spans of sampled requests*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+/*---------------------------------------------------------------------------*/
+#include "span.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*One in this many callbacks is recorded with the requests it sends
+  (nothing is recorded if 0)*/
+int span_sample = 0;
+/*---------------------------------------------------------------------------*/
+/*The most recent spans (allocated when recording is first enabled and
+  kept afterwards) and the number of spans recorded so far*/
+static span_t *span_ring;
+static unsigned long span_next;
+/*---------------------------------------------------------------------------*/
+/*The number of callbacks considered for recording so far*/
+static unsigned long span_calls;
+/*---------------------------------------------------------------------------*/
+/*The number of threads which have recorded spans*/
+static uint32_t span_ntids;
+/*---------------------------------------------------------------------------*/
+/*Set while the calling thread records its spans and the number it is
+  shown under*/
+static __thread int span_recording;
+static __thread uint32_t span_tid;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Records one in `sample` callbacks from now on (none if 0)*/
+error_t span_enable (int sample)
+{
+  span_t *ring;
+
+  if (sample < 0)
+    return EINVAL;
+
+  /*The ring is never freed, since other threads may be recording */
+  if (sample && !span_ring)
+    {
+      ring = calloc (SPAN_RING_SIZE, sizeof (span_t));
+      if (!ring)
+	return ENOMEM;
+
+      if (!__sync_bool_compare_and_swap (&span_ring, NULL, ring))
+	free (ring);
+    }
+
+  span_sample = sample;
+  return 0;
+}				/*span_enable */
+
+/*---------------------------------------------------------------------------*/
+/*Decides whether the callback the calling thread is entering should be
+  recorded; if it should, returns 1 and records the spans of the thread
+  until span_end is called*/
+int span_begin (void)
+{
+  /*the option may be changed meanwhile */
+  int sample = span_sample;
+
+  /*The callbacks called by a recorded one are recorded as its parts */
+  if (!sample || span_recording)
+    return 0;
+
+  if (__sync_fetch_and_add (&span_calls, 1) % sample)
+    return 0;
+
+  span_recording = 1;
+  return 1;
+}				/*span_begin */
+
+/*---------------------------------------------------------------------------*/
+/*Stops recording the spans of the calling thread*/
+void span_end (void)
+{
+  span_recording = 0;
+}				/*span_end */
+
+/*---------------------------------------------------------------------------*/
+/*Checks whether the calling thread is recording its spans*/
+int span_active (void)
+{
+  return span_recording;
+}				/*span_active */
+
+/*---------------------------------------------------------------------------*/
+/*Records the span `name` of the category `cat` from `start` to `end`
+  (in microseconds)*/
+void span_record (const char *name, const char *cat, uint64_t start,
+		  uint64_t end)
+{
+  span_t *slot;
+
+  if (!span_ring)
+    return;
+
+  if (!span_tid)
+    span_tid = __sync_add_and_fetch (&span_ntids, 1);
+
+  /*Take the oldest slot; the name is cleared while the slot is filled in,
+     so that a dump running meanwhile skips it */
+  slot =
+    &span_ring[__sync_fetch_and_add (&span_next, 1) & (SPAN_RING_SIZE - 1)];
+  slot->name = NULL;
+  __sync_synchronize ();
+
+  slot->cat = cat;
+  slot->start = start;
+  slot->dur = end - start;
+  slot->tid = span_tid;
+
+  __sync_synchronize ();
+  slot->name = name;
+}				/*span_record */
+
+/*---------------------------------------------------------------------------*/
+/*Writes the spans recorded so far to `file` as a JSON trace*/
+error_t span_dump (const char *file)
+{
+  error_t err = 0;
+  unsigned long i, next;
+  const char *sep = "";
+  span_t span;
+  FILE *f;
+
+  f = fopen (file, "w");
+  if (!f)
+    return errno;
+
+  /*The names and the categories are the ones of the filter, so they need
+     no escaping */
+  fprintf (f, "{\"traceEvents\":[");
+
+  if (span_ring)
+    {
+      /*go from the oldest span kept to the newest one */
+      next = span_next;
+      i = (next > SPAN_RING_SIZE) ? next - SPAN_RING_SIZE : 0;
+      for (; i < next; ++i)
+	{
+	  span = span_ring[i & (SPAN_RING_SIZE - 1)];
+	  if (!span.name)
+	    continue;
+
+	  fprintf (f,
+		   "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+		   "\"ts\":%llu,\"dur\":%u,\"pid\":%d,\"tid\":%u}", sep,
+		   span.name, span.cat, (unsigned long long) span.start,
+		   (unsigned) span.dur, (int) getpid (), (unsigned) span.tid);
+	  sep = ",";
+	}
+    }
+
+  fprintf (f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  if (fclose (f) != 0)
+    err = errno;
+
+  return err;
+}				/*span_dump */
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,89 @@
+/*---------------------------------------------------------------------------*/
+/*span.h*/
+/*---------------------------------------------------------------------------*/
+/*The recorder of the time spans of sampled requests, which are dumped in
+  the trace event format of Chrome (about:tracing)*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __SPAN_H__
+#define __SPAN_H__
+/*---------------------------------------------------------------------------*/
+#include <errno.h>
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The number of the most recent spans kept (a power of two)*/
+#define SPAN_RING_SIZE 16384
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A recorded span*/
+struct span
+{
+  /*the name and the category of the span, as shown by the viewer; the
+     name is set last, so a slot without it is being filled in */
+  const char *volatile name;
+  const char *cat;
+
+  /*the time (in microseconds) the span has started at and its length */
+  uint64_t start;
+  uint32_t dur;
+
+  /*the thread the span has been recorded by */
+  uint32_t tid;
+};				/*struct span */
+/*---------------------------------------------------------------------------*/
+typedef struct span span_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*One in this many callbacks is recorded with the requests it sends
+  (nothing is recorded if 0)*/
+extern int span_sample;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Records one in `sample` callbacks from now on (none if 0)*/
+error_t span_enable (int sample);
+/*---------------------------------------------------------------------------*/
+/*Decides whether the callback the calling thread is entering should be
+  recorded; if it should, returns 1 and records the spans of the thread
+  until span_end is called*/
+int span_begin (void);
+/*---------------------------------------------------------------------------*/
+/*Stops recording the spans of the calling thread*/
+void span_end (void);
+/*---------------------------------------------------------------------------*/
+/*Checks whether the calling thread is recording its spans*/
+int span_active (void);
+/*---------------------------------------------------------------------------*/
+/*Records the span `name` of the category `cat` from `start` to `end`
+  (in microseconds)*/
+void span_record (const char *name, const char *cat, uint64_t start,
+		  uint64_t end);
+/*---------------------------------------------------------------------------*/
+/*Writes the spans recorded so far to `file` as a JSON trace*/
+error_t span_dump (const char *file);
+/*---------------------------------------------------------------------------*/
+#endif /*__SPAN_H__*/
@@ -0,0 +1,377 @@
+/*---------------------------------------------------------------------------*/
+/*stats.c*/
+/*---------------------------------------------------------------------------*/
+/*The counters describing the work done by the filter*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <argz.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+/*---------------------------------------------------------------------------*/
+#include "stats.h"
+#include "span.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The counters of the callbacks*/
+stats_op_t stats_ops[STATS_OPS];
+/*---------------------------------------------------------------------------*/
+/*The counters of the requests sent to the translators below*/
+stats_op_t stats_rpcs[STATS_RPCS];
+/*---------------------------------------------------------------------------*/
+/*The time taken by each level of the translator stacks traced*/
+stats_hist_t stats_trace_levels[STATS_TRACE_LEVELS];
+/*---------------------------------------------------------------------------*/
+/*The number of read requests served*/
+unsigned long stats_reads;
+/*---------------------------------------------------------------------------*/
+/*The number of bytes returned to the clients by read requests*/
+unsigned long long stats_read_bytes;
+/*---------------------------------------------------------------------------*/
+/*The number of bytes copied by the filter while serving read requests*/
+unsigned long long stats_read_copied;
+/*---------------------------------------------------------------------------*/
+/*The number of bytes written by the clients*/
+unsigned long long stats_write_bytes;
+/*---------------------------------------------------------------------------*/
+/*The number of blocks read ahead of the clients*/
+unsigned long stats_readahead_blocks;
+/*---------------------------------------------------------------------------*/
+/*The number of blocks which were not requested from the target because
+  another reader was already fetching them*/
+unsigned long stats_coalesced;
+/*---------------------------------------------------------------------------*/
+/*The names the callbacks are reported under*/
+static const char *stats_op_names[STATS_OPS] = {
+  "create_file", "check_open_permissions", "utimes", "report_access",
+  "validate_stat", "sync", "get_dirents", "lookup", "unlink", "rename",
+  "mkdir", "rmdir", "chown", "chauthor", "chmod", "mksymlink", "mkdev",
+  "set_translator", "chflags", "set_size", "statfs", "syncfs", "link",
+  "mkfile", "readlink", "read", "write", "node_norefs",
+  "file_get_translator_cntl", "io_read", "io_map", "fsys_forward",
+  "fsys_getroot"
+};
+/*---------------------------------------------------------------------------*/
+/*The names the requests to the translators below are reported under*/
+static const char *stats_rpc_names[STATS_RPCS] = {
+  "io_read", "io_write", "io_stat", "io_map", "dir_lookup", "dir_readdir",
+  "dir_mkdir", "dir_link", "file_sync", "file_syncfs", "file_set_size",
+  "file_get_fs_options", "file_get_translator_cntl", "fsys_getroot",
+  "notice_changes"
+};
+/*---------------------------------------------------------------------------*/
+/*The names the levels of the translator stacks are reported under*/
+static const char *stats_level_names[STATS_TRACE_LEVELS] = {
+  "level0", "level1", "level2", "level3", "level4", "level5", "level6",
+  "level7"
+};
+/*---------------------------------------------------------------------------*/
+/*The percentiles of the latencies reported, in tenths of a percent, and
+  the names they are reported under*/
+static const int stats_percentiles[] = { 500, 990, 999 };
+static const char *stats_percentile_names[] = { "p50", "p99", "p999" };
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Appends to `argz` the option --stats-`name` listing the nonzero values
+  among the `n` counters `values` (`stride` bytes apart) as NAME:VALUE; if
+  all of them are zero, nothing is appended*/
+static
+  error_t
+  stats_append_list
+  (char **argz, size_t * argz_len, const char *name,
+   const char **names, const unsigned long *values, size_t stride, int n)
+{
+  error_t err = 0;
+  char *opt = NULL;
+  size_t len = 0;
+  const char *sep = "";
+  unsigned long value;
+  int i;
+
+  FILE *f = open_memstream (&opt, &len);
+  if (!f)
+    return ENOMEM;
+
+  fprintf (f, "--stats-%s=", name);
+  for (i = 0; i < n; ++i)
+    {
+      value = *(const unsigned long *) ((const char *) values + i * stride);
+      if (value)
+	{
+	  fprintf (f, "%s%s:%lu", sep, names[i], value);
+	  sep = ",";
+	}
+    }
+
+  if (fclose (f) != 0)
+    err = ENOMEM;
+  if (!err && *sep)
+    err = argz_add (argz, argz_len, opt);
+
+  free (opt);
+  return err;
+}				/*stats_append_list */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the latency (in microseconds) under which `permille` tenths of a
+  percent of the latencies counted in `hist` fall, as the upper bound of
+  the bucket it is found in (0 if nothing has been counted)*/
+static unsigned long stats_hist_percentile (stats_hist_t * hist,
+					    int permille)
+{
+  unsigned long total = 0, seen = 0, want;
+  int i;
+
+  for (i = 0; i < STATS_HIST_BUCKETS; ++i)
+    total += hist->buckets[i];
+  if (!total)
+    return 0;
+
+  /*the rank of the latency sought, rounded up */
+  want = (total * permille + 999) / 1000;
+
+  for (i = 0; i < STATS_HIST_BUCKETS - 1; ++i)
+    {
+      seen += hist->buckets[i];
+      if (seen >= want)
+	break;
+    }
+
+  return 1UL << i;
+}				/*stats_hist_percentile */
+
+/*---------------------------------------------------------------------------*/
+/*Appends to `argz` the options --stats-`name`-PERCENTILE listing the
+  percentiles of the `n` histograms `hists` (`stride` bytes apart)*/
+static
+  error_t
+  stats_append_latency
+  (char **argz, size_t * argz_len, const char *name,
+   const char **names, stats_hist_t * hists, size_t stride, int n)
+{
+  error_t err = 0;
+  unsigned long values[STATS_OPS];
+  char *opt;
+  int i, p;
+
+  for (p = 0; !err && (p < sizeof (stats_percentiles) / sizeof (int)); ++p)
+    {
+      for (i = 0; i < n; ++i)
+	values[i] = stats_hist_percentile
+	  ((stats_hist_t *) ((char *) hists + i * stride),
+	   stats_percentiles[p]);
+
+      if (asprintf (&opt, "%s-%s", name, stats_percentile_names[p]) < 0)
+	return ENOMEM;
+      err = stats_append_list
+	(argz, argz_len, opt, names, values, sizeof (unsigned long), n);
+      free (opt);
+    }
+
+  return err;
+}				/*stats_append_latency */
+
+/*---------------------------------------------------------------------------*/
+/*Appends the values of the counters to `argz` as options of the form
+  --stats-NAME=VALUE (the way fsysopts prints them)*/
+error_t stats_append (char **argz, size_t * argz_len)
+{
+  error_t err = 0;
+  char *opt;
+
+  /*The calls and the failures of the callbacks */
+  err = stats_append_list
+    (argz, argz_len, "calls", stats_op_names, &stats_ops[0].calls,
+     sizeof (stats_op_t), STATS_OPS);
+  if (!err)
+    err = stats_append_list
+      (argz, argz_len, "errors", stats_op_names, &stats_ops[0].errors,
+       sizeof (stats_op_t), STATS_OPS);
+
+  /*The requests sent to the translators below */
+  if (!err)
+    err = stats_append_list
+      (argz, argz_len, "rpcs", stats_rpc_names, &stats_rpcs[0].calls,
+       sizeof (stats_op_t), STATS_RPCS);
+  if (!err)
+    err = stats_append_list
+      (argz, argz_len, "rpc-errors", stats_rpc_names, &stats_rpcs[0].errors,
+       sizeof (stats_op_t), STATS_RPCS);
+
+  /*The time taken by the callbacks, by the requests and by the levels of
+     the translator stacks (in microseconds) */
+  if (!err)
+    err = stats_append_latency
+      (argz, argz_len, "latency", stats_op_names, &stats_ops[0].latency,
+       sizeof (stats_op_t), STATS_OPS);
+  if (!err)
+    err = stats_append_latency
+      (argz, argz_len, "rpc-latency", stats_rpc_names,
+       &stats_rpcs[0].latency, sizeof (stats_op_t), STATS_RPCS);
+  if (!err)
+    err = stats_append_latency
+      (argz, argz_len, "trace-latency", stats_level_names,
+       stats_trace_levels, sizeof (stats_hist_t), STATS_TRACE_LEVELS);
+
+  /*The data passed through the filter */
+  if (!err)
+    {
+      if (asprintf
+	  (&opt, "--stats-bytes=read:%llu,written:%llu,copied:%llu",
+	   stats_read_bytes, stats_write_bytes, stats_read_copied) < 0)
+	return ENOMEM;
+      err = argz_add (argz, argz_len, opt);
+      free (opt);
+    }
+
+  /*The work of the block cache */
+  if (!err)
+    {
+      if (asprintf
+	  (&opt, "--stats-cache=readahead:%lu,coalesced:%lu",
+	   stats_readahead_blocks, stats_coalesced) < 0)
+	return ENOMEM;
+      err = argz_add (argz, argz_len, opt);
+      free (opt);
+    }
+
+  return err;
+}				/*stats_append */
+
+/*---------------------------------------------------------------------------*/
+/*Sets all counters to zero*/
+void stats_reset (void)
+{
+  /*The callbacks running meanwhile may still add to the old values; this
+     is only a matter of a few counts */
+  memset (stats_ops, 0, sizeof (stats_ops));
+  memset (stats_rpcs, 0, sizeof (stats_rpcs));
+  memset (stats_trace_levels, 0, sizeof (stats_trace_levels));
+  stats_reads = 0;
+  stats_read_bytes = 0;
+  stats_read_copied = 0;
+  stats_write_bytes = 0;
+  stats_readahead_blocks = 0;
+  stats_coalesced = 0;
+}				/*stats_reset */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the current time in microseconds (from an arbitrary point)*/
+uint64_t stats_now (void)
+{
+  struct timespec ts;
+  struct timeval tv;
+
+  /*Prefer the clock which does not jump, if the system has it */
+  if (clock_gettime (CLOCK_MONOTONIC, &ts) == 0)
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+  gettimeofday (&tv, NULL);
+  return (uint64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+}				/*stats_now */
+
+/*---------------------------------------------------------------------------*/
+/*Counts `us` microseconds in `hist`*/
+void stats_hist_add (stats_hist_t * hist, uint64_t us)
+{
+  int i = us ? 64 - __builtin_clzll (us) : 0;
+
+  if (i >= STATS_HIST_BUCKETS)
+    i = STATS_HIST_BUCKETS - 1;
+
+  STATS_ADD (hist->buckets[i], 1);
+}				/*stats_hist_add */
+
+/*---------------------------------------------------------------------------*/
+/*Counts a call of the callback `op` and starts timing it*/
+stats_timer_t stats_call (int op)
+{
+  stats_timer_t timer;
+
+  STATS_ADD (stats_ops[op].calls, 1);
+
+  timer.hist = &stats_ops[op].latency;
+  timer.name = stats_op_names[op];
+  timer.cat = "callback";
+  timer.sampled = span_begin ();
+  timer.start = stats_now ();
+
+  return timer;
+}				/*stats_call */
+
+/*---------------------------------------------------------------------------*/
+/*Starts timing the level `level` of the translator stack being traced*/
+stats_timer_t stats_trace_level (int level)
+{
+  stats_timer_t timer;
+
+  if (level >= STATS_TRACE_LEVELS)
+    level = STATS_TRACE_LEVELS - 1;
+
+  timer.hist = &stats_trace_levels[level];
+  timer.name = stats_level_names[level];
+  timer.cat = "trace";
+  timer.sampled = 0;
+  timer.start = stats_now ();
+
+  return timer;
+}				/*stats_trace_level */
+
+/*---------------------------------------------------------------------------*/
+/*Stops timing the operation of `timer` and records its span, if the
+  thread is recording them*/
+void stats_timer_stop (stats_timer_t * timer)
+{
+  uint64_t end = stats_now ();
+
+  stats_hist_add (timer->hist, end - timer->start);
+
+  if (span_active ())
+    span_record (timer->name, timer->cat, timer->start, end);
+  if (timer->sampled)
+    span_end ();
+}				/*stats_timer_stop */
+
+/*---------------------------------------------------------------------------*/
+/*Counts the request `rpc` sent at `start` which has returned `err`*/
+void stats_rpc_done (int rpc, uint64_t start, int err)
+{
+  uint64_t end = stats_now ();
+
+  STATS_ADD (stats_rpcs[rpc].calls, 1);
+  if (err)
+    STATS_ADD (stats_rpcs[rpc].errors, 1);
+  stats_hist_add (&stats_rpcs[rpc].latency, end - start);
+
+  if (span_active ())
+    span_record (stats_rpc_names[rpc], "rpc", start, end);
+}				/*stats_rpc_done */
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,241 @@
+/*---------------------------------------------------------------------------*/
+/*stats.h*/
+/*---------------------------------------------------------------------------*/
+/*The counters describing the work done by the filter*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __STATS_H__
+#define __STATS_H__
+/*---------------------------------------------------------------------------*/
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*Atomically adds `n` to the counter `c`*/
+#define STATS_ADD(c, n) ((void) __sync_fetch_and_add (&(c), (n)))
+/*---------------------------------------------------------------------------*/
+/*The callbacks counted in `stats_ops`*/
+#define STATS_OP_CREATE_FILE              0
+#define STATS_OP_CHECK_OPEN_PERMISSIONS   1
+#define STATS_OP_UTIMES                   2
+#define STATS_OP_REPORT_ACCESS            3
+#define STATS_OP_VALIDATE_STAT            4
+#define STATS_OP_SYNC                     5
+#define STATS_OP_GET_DIRENTS              6
+#define STATS_OP_LOOKUP                   7
+#define STATS_OP_UNLINK                   8
+#define STATS_OP_RENAME                   9
+#define STATS_OP_MKDIR                    10
+#define STATS_OP_RMDIR                    11
+#define STATS_OP_CHOWN                    12
+#define STATS_OP_CHAUTHOR                 13
+#define STATS_OP_CHMOD                    14
+#define STATS_OP_MKSYMLINK                15
+#define STATS_OP_MKDEV                    16
+#define STATS_OP_SET_TRANSLATOR           17
+#define STATS_OP_CHFLAGS                  18
+#define STATS_OP_SET_SIZE                 19
+#define STATS_OP_STATFS                   20
+#define STATS_OP_SYNCFS                   21
+#define STATS_OP_LINK                     22
+#define STATS_OP_MKFILE                   23
+#define STATS_OP_READLINK                 24
+#define STATS_OP_READ                     25
+#define STATS_OP_WRITE                    26
+#define STATS_OP_NODE_NOREFS              27
+#define STATS_OP_FILE_GET_TRANSLATOR_CNTL 28
+#define STATS_OP_IO_READ                  29
+#define STATS_OP_IO_MAP                   30
+#define STATS_OP_FSYS_FORWARD             31
+#define STATS_OP_FSYS_GETROOT             32
+#define STATS_OPS                         33
+/*---------------------------------------------------------------------------*/
+/*The requests sent to the translators below the filter, counted in
+  `stats_rpcs`*/
+#define STATS_RPC_IO_READ                  0
+#define STATS_RPC_IO_WRITE                 1
+#define STATS_RPC_IO_STAT                  2
+#define STATS_RPC_IO_MAP                   3
+#define STATS_RPC_DIR_LOOKUP               4
+#define STATS_RPC_DIR_READDIR              5
+#define STATS_RPC_DIR_MKDIR                6
+#define STATS_RPC_DIR_LINK                 7
+#define STATS_RPC_FILE_SYNC                8
+#define STATS_RPC_FILE_SYNCFS              9
+#define STATS_RPC_FILE_SET_SIZE            10
+#define STATS_RPC_FILE_GET_FS_OPTIONS      11
+#define STATS_RPC_FILE_GET_TRANSLATOR_CNTL 12
+#define STATS_RPC_FSYS_GETROOT             13
+#define STATS_RPC_NOTICE_CHANGES           14
+#define STATS_RPCS                         15
+/*---------------------------------------------------------------------------*/
+/*The number of buckets of a latency histogram: the bucket 0 counts the
+  latencies under a microsecond and the bucket `i` those from 2^(i-1) up to
+  2^i microseconds (the last one also counts all longer ones)*/
+#define STATS_HIST_BUCKETS 32
+/*---------------------------------------------------------------------------*/
+/*The number of levels of the translator stacks timed separately (the
+  deeper levels are counted with the last one)*/
+#define STATS_TRACE_LEVELS 8
+/*---------------------------------------------------------------------------*/
+/*Counts a call of the callback `op` and times it until the function
+  returns (declares the timer, so it must be used in the outermost block
+  of the function)*/
+#define STATS_CALL(op) \
+  stats_timer_t stats_timer __attribute__ ((cleanup (stats_timer_stop))) \
+    = stats_call (op)
+/*---------------------------------------------------------------------------*/
+/*Times the rest of the block as the level `level` of the translator stack
+  being traced*/
+#define STATS_TRACE_LEVEL(level) \
+  stats_timer_t stats_level_timer \
+    __attribute__ ((cleanup (stats_timer_stop))) = stats_trace_level (level)
+/*---------------------------------------------------------------------------*/
+/*Counts a failure of the callback `op` if `err` is an error and evaluates
+  to `err`*/
+#define STATS_RESULT(op, err) \
+  ({ \
+    int stats_err = (err); \
+    if (stats_err) \
+      STATS_ADD (stats_ops[op].errors, 1); \
+    stats_err; \
+  })
+/*---------------------------------------------------------------------------*/
+/*Counts and times the request `rpc` and evaluates to the result of
+  `call`, which sends it*/
+#define STATS_RPC(rpc, call) \
+  ({ \
+    uint64_t stats_rpc_start = stats_now (); \
+    __typeof__ (call) stats_rpc_err = (call); \
+    stats_rpc_done ((rpc), stats_rpc_start, stats_rpc_err); \
+    stats_rpc_err; \
+  })
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The latencies of an operation, counted in buckets growing by powers of
+  two*/
+struct stats_hist
+{
+  unsigned long buckets[STATS_HIST_BUCKETS];
+};				/*struct stats_hist */
+/*---------------------------------------------------------------------------*/
+typedef struct stats_hist stats_hist_t;
+/*---------------------------------------------------------------------------*/
+/*The counters of a callback or of a request sent to the translators
+  below*/
+struct stats_op
+{
+  /*the number of times the operation has been done */
+  unsigned long calls;
+
+  /*the number of times it has failed */
+  unsigned long errors;
+
+  /*the time it has taken */
+  stats_hist_t latency;
+};				/*struct stats_op */
+/*---------------------------------------------------------------------------*/
+typedef struct stats_op stats_op_t;
+/*---------------------------------------------------------------------------*/
+/*The timing of an operation in progress*/
+struct stats_timer
+{
+  /*the histogram the time goes to */
+  stats_hist_t *hist;
+
+  /*the name and the category the operation is recorded under as a span */
+  const char *name;
+  const char *cat;
+
+  /*the time (in microseconds) the operation has started at */
+  uint64_t start;
+
+  /*set if the operation has started the recording of the spans of the
+     thread */
+  int sampled;
+};				/*struct stats_timer */
+/*---------------------------------------------------------------------------*/
+typedef struct stats_timer stats_timer_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The counters of the callbacks*/
+extern stats_op_t stats_ops[STATS_OPS];
+/*---------------------------------------------------------------------------*/
+/*The counters of the requests sent to the translators below*/
+extern stats_op_t stats_rpcs[STATS_RPCS];
+/*---------------------------------------------------------------------------*/
+/*The time taken by each level of the translator stacks traced*/
+extern stats_hist_t stats_trace_levels[STATS_TRACE_LEVELS];
+/*---------------------------------------------------------------------------*/
+/*The number of read requests served*/
+extern unsigned long stats_reads;
+/*---------------------------------------------------------------------------*/
+/*The number of bytes returned to the clients by read requests*/
+extern unsigned long long stats_read_bytes;
+/*---------------------------------------------------------------------------*/
+/*The number of bytes copied by the filter while serving read requests*/
+extern unsigned long long stats_read_copied;
+/*---------------------------------------------------------------------------*/
+/*The number of bytes written by the clients*/
+extern unsigned long long stats_write_bytes;
+/*---------------------------------------------------------------------------*/
+/*The number of blocks read ahead of the clients*/
+extern unsigned long stats_readahead_blocks;
+/*---------------------------------------------------------------------------*/
+/*The number of blocks which were not requested from the target because
+  another reader was already fetching them*/
+extern unsigned long stats_coalesced;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Appends the values of the counters to `argz` as options of the form
+  --stats-NAME=VALUE (the way fsysopts prints them)*/
+error_t stats_append (char **argz, size_t * argz_len);
+/*---------------------------------------------------------------------------*/
+/*Sets all counters to zero*/
+void stats_reset (void);
+/*---------------------------------------------------------------------------*/
+/*Returns the current time in microseconds (from an arbitrary point)*/
+uint64_t stats_now (void);
+/*---------------------------------------------------------------------------*/
+/*Counts `us` microseconds in `hist`*/
+void stats_hist_add (stats_hist_t * hist, uint64_t us);
+/*---------------------------------------------------------------------------*/
+/*Counts a call of the callback `op` and starts timing it*/
+stats_timer_t stats_call (int op);
+/*---------------------------------------------------------------------------*/
+/*Starts timing the level `level` of the translator stack being traced*/
+stats_timer_t stats_trace_level (int level);
+/*---------------------------------------------------------------------------*/
+/*Stops timing the operation of `timer` and records its span, if the
+  thread is recording them*/
+void stats_timer_stop (stats_timer_t * timer);
+/*---------------------------------------------------------------------------*/
+/*Counts the request `rpc` sent at `start` which has returned `err`*/
+void stats_rpc_done (int rpc, uint64_t start, int err);
+/*---------------------------------------------------------------------------*/
+#endif /*__STATS_H__*/
@@ -0,0 +1,598 @@
+/*---------------------------------------------------------------------------*/
+/*bench.c*/
+/*---------------------------------------------------------------------------*/
+/*Measures the callbacks of the filter on the read path against stand-in
+  translators, on any POSIX host.
+
+  Usage: filterbench [-b BENCH,...] [-k BACKEND,...] [-s SIZE,...]
+                     [-p PATTERN,...] [-c THREADS,...] [-t MSEC]
+                     [-L USEC] [-B MB/S] [-f SIZE] [-d DEPTH] [-S]
+                     [-- FILTER-OPTION... [TARGET-NAME]]
+
+  The callbacks are linked with stand-ins for the libraries of the Hurd
+  (hurd.c) and for the translators below the filter (target.c): every
+  file carries a stack of DEPTH translators (-d, 2 by default) topped by
+  the target, which serves the data from memory (backend `mem`), after
+  USEC microseconds (`latency`, -L, 100 by default) or at the rate of a
+  link of MB/S megabytes per second shared by all requests (`bandwidth`,
+  -B, 100 by default). Every file is SIZE bytes long (-f, 64m by
+  default).
+
+  The benchmarks are:
+    read   netfs_attempt_read of SIZE bytes (-s, 4k,64k,1m by default) at
+           sequential or random offsets (-p, seq,random by default);
+    stat   netfs_validate_stat;
+    trace  trace_find over the whole stack, either missing the cache of
+           traced stacks (pattern `cold`) or hitting it (`cached`).
+  Each one runs for MSEC milliseconds (-t, 1000 by default) with each
+  number of threads (-c, 1,2,4,8 by default) calling the callback in a
+  loop, each on a node of its own, or all on the same node with -S. The
+  options after -- are the options of the filter, e.g. --cache-size.
+
+  One line is printed per run, as comma-separated values: the benchmark,
+  the backend, the size of the reads, the pattern, the number of threads,
+  the depth of the stacks, the number of calls and of failed calls, the
+  calls and the megabytes per second and the 50th, 99th and 99.9th
+  percentiles of the time of a call in microseconds.
+
+  Build (in the top directory):
+    gcc -O2 -Itools/bench/include -I. -o filterbench tools/bench/bench.c \
+      tools/bench/hurd.c tools/bench/target.c cache.c dircache.c \
+      instance.c log.c node.c notify.c options.c pipeline.c readahead.c \
+      server.c span.c stats.c trace.c tracetab.c writeback.c -lpthread*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+/*The callbacks, including the static functions setting up the root nodes;
+  the entry point of the filter is renamed*/
+#define main filter_main
+#include "../../filter.c"
+#undef main
+/*---------------------------------------------------------------------------*/
+#include <time.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+/*---------------------------------------------------------------------------*/
+#include "target.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The benchmarks*/
+#define BENCH_READ  0
+#define BENCH_STAT  1
+#define BENCH_TRACE 2
+/*---------------------------------------------------------------------------*/
+/*The patterns of the offsets of the reads and of the traces*/
+#define PATTERN_SEQ    0
+#define PATTERN_RANDOM 1
+#define PATTERN_COLD   2
+#define PATTERN_CACHED 3
+#define PATTERN_NONE   4
+/*---------------------------------------------------------------------------*/
+/*The latencies are counted in buckets of 1/64 of a power of two of
+  nanoseconds; the times under 64 nanoseconds are counted exactly*/
+#define HIST_SUB 64
+#define HIST_BUCKETS (59 * HIST_SUB)
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A thread calling a callback*/
+struct client
+{
+  /*the number of the thread */
+  int n;
+
+  /*the node it calls the callback on (unused by the traces) */
+  struct node *np;
+
+  /*the calls, the failed calls and the bytes read */
+  unsigned long long ops, errors, bytes;
+
+  /*the number of times each latency (in nanoseconds) has been seen */
+  unsigned long long *hist;
+
+  pthread_t thread;
+};				/*struct client */
+/*---------------------------------------------------------------------------*/
+typedef struct client client_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The names of the benchmarks and of the patterns*/
+static const char *bench_names[] = { "read", "stat", "trace" };
+static const char *pattern_names[] =
+  { "seq", "random", "cold", "cached", "-" };
+/*---------------------------------------------------------------------------*/
+/*The benchmark being run, the size of its reads and its pattern*/
+static int bench;
+static size_t bench_size;
+static int bench_pattern;
+/*---------------------------------------------------------------------------*/
+/*Set when the threads should stop calling*/
+static volatile int stop;
+/*---------------------------------------------------------------------------*/
+/*The alias of the underlying nodes traced last, so that every cold trace
+  misses the cache*/
+static unsigned int trace_alias;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Returns the current time in nanoseconds*/
+static uint64_t bench_now (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}				/*bench_now */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the bucket counting the latency of `ns` nanoseconds*/
+static int hist_bucket (uint64_t ns)
+{
+  int bits;
+
+  if (ns < HIST_SUB)
+    return ns;
+
+  /*the 6 bits under the highest one select the bucket within its power */
+  bits = 63 - __builtin_clzll (ns);
+  return (bits - 5) * HIST_SUB + ((ns >> (bits - 6)) & (HIST_SUB - 1));
+}				/*hist_bucket */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the middle of the bucket `i` in microseconds*/
+static double hist_value (int i)
+{
+  uint64_t width;
+
+  if (i < HIST_SUB)
+    return i / 1000.0;
+
+  /*the bucket starts at its 6 bits shifted to its power of two */
+  width = 1ULL << (i / HIST_SUB - 1);
+  return ((HIST_SUB + i % HIST_SUB) * width + width / 2) / 1000.0;
+}				/*hist_value */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the latency under which `permille` of the `total` calls counted
+  in `hist` have completed*/
+static double
+  hist_percentile
+  (unsigned long long *hist, unsigned long long total, int permille)
+{
+  unsigned long long seen = 0;
+  int i;
+
+  for (i = 0; i < HIST_BUCKETS; ++i)
+    {
+      seen += hist[i];
+      if (seen * 1000 >= total * permille)
+	return hist_value (i);
+    }
+
+  return 0;
+}				/*hist_percentile */
+
+/*---------------------------------------------------------------------------*/
+/*Parses a size with an optional suffix k, m or g*/
+static size_t parse_size (const char *arg)
+{
+  char *end;
+  size_t size = strtoul (arg, &end, 10);
+
+  switch (*end)
+    {
+    case 'g':
+    case 'G':
+      size <<= 10;
+    case 'm':
+    case 'M':
+      size <<= 10;
+    case 'k':
+    case 'K':
+      size <<= 10;
+      ++end;
+    }
+
+  if ((end == arg) || *end || !size)
+    error (EXIT_FAILURE, 0, "Invalid size: %s", arg);
+  return size;
+}				/*parse_size */
+
+/*---------------------------------------------------------------------------*/
+/*Finds `name` among the `n` names in `names`*/
+static int find_name (const char *name, const char **names, int n)
+{
+  int i;
+
+  for (i = 0; i < n; ++i)
+    if (strcmp (name, names[i]) == 0)
+      return i;
+
+  error (EXIT_FAILURE, 0, "Unknown name: %s", name);
+  return -1;
+}				/*find_name */
+
+/*---------------------------------------------------------------------------*/
+/*Creates a root node on the file `file` with its target already found*/
+static struct node *make_root (int file)
+{
+  error_t err = 0;
+  mach_port_t underlying = TARGET_PORT (0, file, 0, 0);
+  io_statbuf_t stat;
+  struct node *np;
+  char *path;
+
+  err = node_create_root (&np);
+  if (!err)
+    err = io_stat (underlying, &stat);
+  if (err)
+    error (EXIT_FAILURE, err, "Could not create a node");
+
+  path = target_path (target_name);
+  if (!path)
+    error (EXIT_FAILURE, ENOMEM, "Could not allocate the target name");
+  setup_root (np, underlying, &stat, path);
+
+  /*Trace the stack now, so that the runs do not count it */
+  mutex_lock (&np->lock);
+  err = resolve_target (np);
+  mutex_unlock (&np->lock);
+  if (err)
+    error (EXIT_FAILURE, err, "Could not trace the stack of a node");
+
+  return np;
+}				/*make_root */
+
+/*---------------------------------------------------------------------------*/
+/*Calls the callback of the benchmark once, reading from `offset` into
+  `buf`*/
+static error_t call (client_t * client, loff_t offset, char *buf)
+{
+  error_t err = 0;
+  size_t len = bench_size;
+  mach_port_t port;
+  unsigned int alias;
+
+  switch (bench)
+    {
+    case BENCH_READ:
+      /*libnetfs calls the callbacks with the node locked */
+      mutex_lock (&client->np->lock);
+      err = netfs_attempt_read (NULL, client->np, offset, &len, buf);
+      mutex_unlock (&client->np->lock);
+
+      /*the stand-in files contain a known pattern */
+      if (!err
+	  && ((len != bench_size) || (buf[0] != TARGET_BYTE (offset))
+	      || (buf[len - 1] != TARGET_BYTE (offset + len - 1))))
+	error (EXIT_FAILURE, 0, "Wrong data read at %lld",
+	       (long long) offset);
+      if (!err)
+	client->bytes += len;
+      break;
+
+    case BENCH_STAT:
+      mutex_lock (&client->np->lock);
+      err = netfs_validate_stat (client->np, NULL);
+      mutex_unlock (&client->np->lock);
+      break;
+
+    case BENCH_TRACE:
+      /*a fresh port to the underlying node is not in the cache */
+      alias = 0;
+      if (bench_pattern == PATTERN_COLD)
+	alias = 2 + __sync_fetch_and_add (&trace_alias, 1)
+	  % (TARGET_ALIASES - 2);
+
+      err = trace_find (TARGET_PORT (alias, client->n + 1, 0, 0),
+			target_translator, O_READ, &port);
+      if (!err)
+	PORT_DEALLOC (port);
+      break;
+    }
+
+  return err;
+}				/*call */
+
+/*---------------------------------------------------------------------------*/
+/*The body of a thread: calls the callback until `stop` is set*/
+static void *client_thread (void *arg)
+{
+  client_t *client = arg;
+  unsigned int seed = client->n + 1;
+  loff_t offset = 0, blocks = target_size / bench_size;
+  uint64_t start;
+  char *buf;
+
+  buf = malloc (bench_size);
+  if (!buf)
+    error (EXIT_FAILURE, ENOMEM, "Could not allocate the buffer");
+
+  while (!stop)
+    {
+      if (bench_pattern == PATTERN_RANDOM)
+	offset = (rand_r (&seed) % blocks) * bench_size;
+
+      start = bench_now ();
+      if (call (client, offset, buf))
+	++client->errors;
+      ++client->hist[hist_bucket (bench_now () - start)];
+      ++client->ops;
+
+      /*start over at the end of the file */
+      if (bench_pattern == PATTERN_SEQ)
+	offset = (offset + 2 * bench_size <= target_size)
+	  ? offset + bench_size : 0;
+    }
+
+  free (buf);
+  return NULL;
+}				/*client_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Runs the benchmark with `n` threads for `msec` milliseconds and prints
+  its line*/
+static void run (int n, int msec, int shared)
+{
+  client_t *clients;
+  unsigned long long *hist, ops = 0, errors = 0, bytes = 0;
+  struct timespec pause = { msec / 1000, (msec % 1000) * 1000000L };
+  uint64_t start;
+  double secs;
+  int i, j;
+
+  clients = calloc (n, sizeof (client_t));
+  hist = calloc (HIST_BUCKETS, sizeof (unsigned long long));
+  if (!clients || !hist)
+    error (EXIT_FAILURE, ENOMEM, "Could not allocate the threads");
+
+  /*Every thread reads a file of its own, unless they should share one */
+  for (i = 0; i < n; ++i)
+    {
+      clients[i].n = i;
+      clients[i].hist = calloc (HIST_BUCKETS, sizeof (unsigned long long));
+      if (!clients[i].hist)
+	error (EXIT_FAILURE, ENOMEM, "Could not allocate the threads");
+
+      if (bench == BENCH_TRACE)
+	continue;
+
+      if (shared && i)
+	{
+	  clients[i].np = clients[0].np;
+	  netfs_nref (clients[i].np);
+	}
+      else
+	clients[i].np = make_root (i + 1);
+    }
+
+  stop = 0;
+  start = bench_now ();
+
+  for (i = 0; i < n; ++i)
+    if (pthread_create (&clients[i].thread, NULL, client_thread, &clients[i]))
+      error (EXIT_FAILURE, errno, "Could not start a thread");
+
+  nanosleep (&pause, NULL);
+  stop = 1;
+
+  for (i = 0; i < n; ++i)
+    {
+      pthread_join (clients[i].thread, NULL);
+
+      ops += clients[i].ops;
+      errors += clients[i].errors;
+      bytes += clients[i].bytes;
+      for (j = 0; j < HIST_BUCKETS; ++j)
+	hist[j] += clients[i].hist[j];
+
+      if (clients[i].np)
+	netfs_nrele (clients[i].np);
+      free (clients[i].hist);
+    }
+
+  secs = (bench_now () - start) / 1e9;
+
+  printf ("%s,%s,%lu,%s,%d,%d,%llu,%llu,%.1f,%.2f,%.3f,%.3f,%.3f\n",
+	  bench_names[bench], target_backend_name (target_backend),
+	  (bench == BENCH_READ) ? (unsigned long) bench_size : 0UL,
+	  pattern_names[bench_pattern], n, target_depth, ops, errors,
+	  ops / secs, bytes / secs / (1024 * 1024),
+	  hist_percentile (hist, ops, 500), hist_percentile (hist, ops, 990),
+	  hist_percentile (hist, ops, 999));
+  fflush (stdout);
+
+  free (clients);
+  free (hist);
+}				/*run */
+
+/*---------------------------------------------------------------------------*/
+/*Runs the benchmark for every number of threads in `threads`*/
+static void run_threads (char *threads, int msec, int shared)
+{
+  char *list = strdupa (threads), *n, *save;
+
+  for (n = strtok_r (list, ",", &save); n; n = strtok_r (NULL, ",", &save))
+    {
+      if (atoi (n) < 1)
+	error (EXIT_FAILURE, 0, "Invalid number of threads: %s", n);
+      run (atoi (n), msec, shared);
+    }
+}				/*run_threads */
+
+/*---------------------------------------------------------------------------*/
+/*Entry point*/
+int main (int argc, char **argv)
+{
+  char *benches = "read,stat,trace", *backends = "mem,latency,bandwidth";
+  char *sizes = "4k,64k,1m", *patterns = "seq,random";
+  char *threads = "1,2,4,8";
+  char *b, *k, *s, *p, *save_b, *save_k, *save_s, *save_p;
+  int msec = 1000, shared = 0, opt;
+  error_t err = 0;
+
+  INIT_LOG ();
+
+  /*The delays of the backends should not be stretched by the timer slack
+     of the threads (inherited by the threads started later) */
+#ifdef PR_SET_TIMERSLACK
+  prctl (PR_SET_TIMERSLACK, 1);
+#endif
+
+  while ((opt = getopt (argc, argv, "b:k:s:p:c:t:L:B:f:d:S")) != -1)
+    switch (opt)
+      {
+      case 'b':
+	benches = optarg;
+	break;
+      case 'k':
+	backends = optarg;
+	break;
+      case 's':
+	sizes = optarg;
+	break;
+      case 'p':
+	patterns = optarg;
+	break;
+      case 'c':
+	threads = optarg;
+	break;
+      case 't':
+	msec = atoi (optarg);
+	break;
+      case 'L':
+	target_latency = atol (optarg);
+	break;
+      case 'B':
+	target_bandwidth = atoll (optarg) << 20;
+	break;
+      case 'f':
+	target_size = parse_size (optarg);
+	break;
+      case 'd':
+	target_depth = atoi (optarg);
+	break;
+      case 'S':
+	shared = 1;
+	break;
+      default:
+	error (EXIT_FAILURE, 0, "Usage: %s [-b BENCH,...] [-k BACKEND,...] "
+	       "[-s SIZE,...] [-p PATTERN,...] [-c THREADS,...] [-t MSEC] "
+	       "[-L USEC] [-B MB/S] [-f SIZE] [-d DEPTH] [-S] "
+	       "[-- FILTER-OPTION...]", argv[0]);
+      }
+
+  if ((msec < 1) || (target_latency < 0) || (target_bandwidth <= 0)
+      || (target_depth < 1) || (target_depth >= TARGET_LEVELS))
+    error (EXIT_FAILURE, 0, "Invalid arguments");
+
+  /*The options of the filter follow the options of the benchmark */
+  argv[optind - 1] = argv[0];
+  argp_parse (&argp_startup, argc - optind + 1, argv + optind - 1,
+	      ARGP_IN_ORDER, 0, 0);
+  if (!target_name)
+    target_name = "target";
+  target_translator = target_path (target_name);
+  if (!target_translator)
+    error (EXIT_FAILURE, ENOMEM, "Could not allocate the target name");
+
+  /*Start the filter the way it starts on its node */
+  log_start ();
+  netfs_init ();
+  fsid = getpid ();
+
+  err = trace_init ();
+  if (err)
+    error (EXIT_FAILURE, err, "Failed to fetch the identity of the filter");
+
+  if (tracetab_file)
+    {
+      err = tracetab_open ();
+      if (err)
+	error (EXIT_FAILURE, err, "Could not map the trace table %s",
+	       tracetab_file);
+    }
+
+  err = readahead_start ();
+  if (!err)
+    err = pipeline_start ();
+  if (!err && WRITEBACK_ENABLED)
+    err = writeback_start ();
+  if (err)
+    error (EXIT_FAILURE, err, "Failed to start the helper threads");
+
+  printf ("bench,backend,size,pattern,threads,depth,ops,errors,ops_per_sec,"
+	  "mb_per_sec,p50_us,p99_us,p999_us\n");
+
+  /*Run every benchmark with every backend */
+  for (k = strtok_r (strdupa (backends), ",", &save_k); k;
+       k = strtok_r (NULL, ",", &save_k))
+    {
+      target_backend = target_backend_find (k);
+      if (target_backend < 0)
+	error (EXIT_FAILURE, 0, "Unknown backend: %s", k);
+
+      for (b = strtok_r (strdupa (benches), ",", &save_b); b;
+	   b = strtok_r (NULL, ",", &save_b))
+	{
+	  bench = find_name (b, bench_names, BENCH_TRACE + 1);
+	  bench_size = 1;
+
+	  if (bench == BENCH_STAT)
+	    {
+	      bench_pattern = PATTERN_NONE;
+	      run_threads (threads, msec, shared);
+	    }
+	  else if (bench == BENCH_TRACE)
+	    for (bench_pattern = PATTERN_COLD;
+		 bench_pattern <= PATTERN_CACHED; ++bench_pattern)
+	      run_threads (threads, msec, shared);
+	  else
+	    for (s = strtok_r (strdupa (sizes), ",", &save_s); s;
+		 s = strtok_r (NULL, ",", &save_s))
+	      {
+		bench_size = parse_size (s);
+		if (bench_size > target_size)
+		  error (EXIT_FAILURE, 0, "Reads larger than the files: %s",
+			 s);
+
+		for (p = strtok_r (strdupa (patterns), ",", &save_p); p;
+		     p = strtok_r (NULL, ",", &save_p))
+		  {
+		    bench_pattern = find_name (p, pattern_names,
+					       PATTERN_RANDOM + 1);
+		    run_threads (threads, msec, shared);
+		  }
+	      }
+	}
+    }
+
+  return 0;
+}				/*main */
+
+/*---------------------------------------------------------------------------*/
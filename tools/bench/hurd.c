@@ -0,0 +1,527 @@
+/*---------------------------------------------------------------------------*/
+/*hurd.c*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the libraries of the Hurd and the calls to Mach used by
+  the filter, enough to run its callbacks on a POSIX host*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <cthreads.h>
+#include <maptime.h>
+#include <hurd/ihash.h>
+#include <hurd/netfs.h>
+#include <hurd/ports.h>
+#include <fs_notify_S.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The number of slots a hash table starts with*/
+#define IHASH_MIN_SIZE 64
+/*---------------------------------------------------------------------------*/
+/*Finds the location pointer of `value` in the table `ht`*/
+#define IHASH_LOCP(ht, value) \
+  ((hurd_ihash_locp_t *) ((char *) (value) + (ht)->locp_offset))
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The size of a page*/
+vm_size_t vm_page_size = 4096;
+/*---------------------------------------------------------------------------*/
+/*The root node of the filter (unused: the benchmark makes its own)*/
+struct node *netfs_root_node;
+/*---------------------------------------------------------------------------*/
+/*The bucket of the ports of the filter*/
+struct port_bucket *netfs_port_bucket;
+/*---------------------------------------------------------------------------*/
+/*The class of the control port of the filter*/
+struct port_class *netfs_control_class;
+/*---------------------------------------------------------------------------*/
+/*The lock protecting the references to the nodes*/
+spin_lock_t netfs_node_refcnt_lock = SPIN_LOCK_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+/*The standard options of libnetfs (none on the host)*/
+const struct argp netfs_std_runtime_argp;
+const struct argp netfs_std_startup_argp;
+/*---------------------------------------------------------------------------*/
+/*The bucket and the class handed out by `ports_create_*`*/
+static int dummy_bucket, dummy_class;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*The stand-in ports hold no references and never die*/
+mach_port_t mach_task_self (void)
+{
+  return 1;
+}				/*mach_task_self */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t mach_port_deallocate (task_t task, mach_port_t name)
+{
+  return 0;
+}				/*mach_port_deallocate */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t
+  mach_port_mod_refs
+  (task_t task, mach_port_t name, mach_port_right_t right,
+   mach_port_delta_t delta)
+{
+  return 0;
+}				/*mach_port_mod_refs */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t
+  mach_port_type (task_t task, mach_port_t name, mach_port_type_t * type)
+{
+  *type = MACH_PORT_TYPE_SEND;
+  return 0;
+}				/*mach_port_type */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t
+  mach_port_request_notification
+  (task_t task, mach_port_t name, mach_msg_id_t id, unsigned int sync,
+   mach_port_t notify, mach_msg_type_name_t type, mach_port_t * previous)
+{
+  return EOPNOTSUPP;
+}				/*mach_port_request_notification */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t task_get_bootstrap_port (task_t task, mach_port_t * port)
+{
+  *port = MACH_PORT_NULL;
+  return 0;
+}				/*task_get_bootstrap_port */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t
+  vm_deallocate (task_t task, vm_address_t address, vm_size_t size)
+{
+  return 0;
+}				/*vm_deallocate */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the effective user ID of the process*/
+int geteuids (int n, uid_t * uids)
+{
+  if (n > 0)
+    uids[0] = geteuid ();
+  return 1;
+}				/*geteuids */
+
+/*---------------------------------------------------------------------------*/
+/*Starts a thread running `fn` on `arg`*/
+cthread_t cthread_fork (cthread_fn_t fn, any_t arg)
+{
+  pthread_t thread;
+
+  if (pthread_create (&thread, NULL, fn, arg))
+    abort ();
+  return (cthread_t) thread;
+}				/*cthread_fork */
+
+/*---------------------------------------------------------------------------*/
+/*Lets the thread `t` go away on its own when it exits*/
+void cthread_detach (cthread_t t)
+{
+  pthread_detach ((pthread_t) t);
+}				/*cthread_detach */
+
+/*---------------------------------------------------------------------------*/
+/*The time is read from the host, so there is nothing to map*/
+error_t
+  maptime_map
+  (int use_mach_dev, char *dev_name,
+   volatile struct mapped_time_value **mtime)
+{
+  *mtime = NULL;
+  return 0;
+}				/*maptime_map */
+
+/*---------------------------------------------------------------------------*/
+/*Initializes the hash table `ht`*/
+void hurd_ihash_init (hurd_ihash_t ht, intptr_t locp_offset)
+{
+  ht->nr_items = 0;
+  ht->size = 0;
+  ht->items = NULL;
+  ht->locp_offset = locp_offset;
+}				/*hurd_ihash_init */
+
+/*---------------------------------------------------------------------------*/
+/*Frees the slots of the hash table `ht`*/
+void hurd_ihash_destroy (hurd_ihash_t ht)
+{
+  free (ht->items);
+  ht->items = NULL;
+  ht->size = ht->nr_items = 0;
+}				/*hurd_ihash_destroy */
+
+/*---------------------------------------------------------------------------*/
+/*Finds the slot of `key` in `ht`, or the free slot it would take*/
+static struct hurd_ihash_item *ihash_slot (hurd_ihash_t ht,
+					   hurd_ihash_key_t key)
+{
+  struct hurd_ihash_item *free_slot = NULL, *item;
+  size_t i;
+
+  for (i = key & (ht->size - 1);; i = (i + 1) & (ht->size - 1))
+    {
+      item = &ht->items[i];
+      if (item->value && (item->key == key))
+	return item;
+
+      /*a removed slot may be reused, but the key may still follow it */
+      if (!item->value && !free_slot)
+	free_slot = item;
+      if (!item->value && !item->removed)
+	return free_slot;
+    }
+}				/*ihash_slot */
+
+/*---------------------------------------------------------------------------*/
+/*Stores `value` under `key` in the free slot `item` of `ht`*/
+static void
+  ihash_store
+  (hurd_ihash_t ht, struct hurd_ihash_item *item, hurd_ihash_key_t key,
+   hurd_ihash_value_t value)
+{
+  item->key = key;
+  item->value = value;
+  item->removed = 0;
+
+  if (ht->locp_offset != HURD_IHASH_NO_LOCP)
+    *IHASH_LOCP (ht, value) = &item->value;
+}				/*ihash_store */
+
+/*---------------------------------------------------------------------------*/
+/*Adds `value` under `key` to `ht`, replacing the value stored there*/
+error_t
+  hurd_ihash_add
+  (hurd_ihash_t ht, hurd_ihash_key_t key, hurd_ihash_value_t value)
+{
+  struct hurd_ihash_item *old = ht->items, *item;
+  size_t old_size = ht->size, i;
+
+  /*Keep the table at most half full, counting the removed slots */
+  if (2 * (ht->nr_items + 1) > ht->size)
+    {
+      ht->size = old_size ? 2 * old_size : IHASH_MIN_SIZE;
+      ht->items = calloc (ht->size, sizeof (struct hurd_ihash_item));
+      if (!ht->items)
+	{
+	  ht->items = old;
+	  ht->size = old_size;
+	  return ENOMEM;
+	}
+
+      ht->nr_items = 0;
+      for (i = 0; i < old_size; ++i)
+	if (old[i].value)
+	  {
+	    ihash_store (ht, ihash_slot (ht, old[i].key), old[i].key,
+			 old[i].value);
+	    ++ht->nr_items;
+	  }
+      free (old);
+    }
+
+  item = ihash_slot (ht, key);
+  if (!item->value && !item->removed)
+    ++ht->nr_items;
+  ihash_store (ht, item, key, value);
+  return 0;
+}				/*hurd_ihash_add */
+
+/*---------------------------------------------------------------------------*/
+/*Finds the value stored under `key` in `ht`*/
+hurd_ihash_value_t hurd_ihash_find (hurd_ihash_t ht, hurd_ihash_key_t key)
+{
+  return ht->size ? ihash_slot (ht, key)->value : NULL;
+}				/*hurd_ihash_find */
+
+/*---------------------------------------------------------------------------*/
+/*Removes the value stored under `key` from `ht`*/
+int hurd_ihash_remove (hurd_ihash_t ht, hurd_ihash_key_t key)
+{
+  struct hurd_ihash_item *item;
+
+  if (!ht->size || !(item = ihash_slot (ht, key))->value)
+    return 0;
+
+  hurd_ihash_locp_remove (ht, &item->value);
+  return 1;
+}				/*hurd_ihash_remove */
+
+/*---------------------------------------------------------------------------*/
+/*Removes the value stored at `locp` from `ht` (the slot stays counted in
+  `nr_items` until the table grows)*/
+void hurd_ihash_locp_remove (hurd_ihash_t ht, hurd_ihash_locp_t locp)
+{
+  struct hurd_ihash_item *item = (struct hurd_ihash_item *)
+    ((char *) locp - offsetof (struct hurd_ihash_item, value));
+
+  item->value = NULL;
+  item->removed = 1;
+}				/*hurd_ihash_locp_remove */
+
+/*---------------------------------------------------------------------------*/
+/*The stand-in users may do everything*/
+error_t fshelp_access (struct stat *st, int op, struct iouser *user)
+{
+  return 0;
+}				/*fshelp_access */
+
+/*---------------------------------------------------------------------------*/
+error_t fshelp_isowner (struct stat *st, struct iouser *user)
+{
+  return 0;
+}				/*fshelp_isowner */
+
+/*---------------------------------------------------------------------------*/
+/*Sets the times `what` of `st` to the current time*/
+void
+  fshelp_touch
+  (struct stat *st, unsigned what, volatile struct mapped_time_value *maptime)
+{
+  struct timespec now;
+
+  clock_gettime (CLOCK_REALTIME, &now);
+  if (what & TOUCH_ATIME)
+    st->st_atim = now;
+  if (what & TOUCH_MTIME)
+    st->st_mtim = now;
+  if (what & TOUCH_CTIME)
+    st->st_ctim = now;
+}				/*fshelp_touch */
+
+/*---------------------------------------------------------------------------*/
+/*No translators are started on the nodes of the filter*/
+error_t fshelp_fetch_control (struct transbox *box, mach_port_t * control)
+{
+  *control = MACH_PORT_NULL;
+  return 0;
+}				/*fshelp_fetch_control */
+
+/*---------------------------------------------------------------------------*/
+/*No clients lock files on the host*/
+error_t fshelp_acquire_lock (struct lock_box *box, int *user,
+			     struct mutex *mut, int flags)
+{
+  *user = flags;
+  return 0;
+}				/*fshelp_acquire_lock */
+
+/*---------------------------------------------------------------------------*/
+/*Creates the identity of a user*/
+error_t
+  iohelp_create_complex_iouser
+  (struct iouser **user, uid_t * uids, int nuids, gid_t * gids, int ngids)
+{
+  *user = calloc (1, sizeof (struct iouser));
+  return *user ? 0 : ENOMEM;
+}				/*iohelp_create_complex_iouser */
+
+/*---------------------------------------------------------------------------*/
+void iohelp_free_iouser (struct iouser *user)
+{
+  free (user);
+}				/*iohelp_free_iouser */
+
+/*---------------------------------------------------------------------------*/
+/*No ports are served on the host: the buckets and the classes exist only
+  to be passed around*/
+struct port_class *ports_create_class (void (*clean_routine) (void *),
+				       void (*dropweak_routine) (void *))
+{
+  return (struct port_class *) &dummy_class;
+}				/*ports_create_class */
+
+/*---------------------------------------------------------------------------*/
+struct port_bucket *ports_create_bucket (void)
+{
+  return (struct port_bucket *) &dummy_bucket;
+}				/*ports_create_bucket */
+
+/*---------------------------------------------------------------------------*/
+error_t
+  ports_create_port
+  (struct port_class *class, struct port_bucket *bucket, size_t size,
+   void *result)
+{
+  return EOPNOTSUPP;
+}				/*ports_create_port */
+
+/*---------------------------------------------------------------------------*/
+void *ports_lookup_port (struct port_bucket *bucket, mach_port_t port,
+			 struct port_class *class)
+{
+  return NULL;
+}				/*ports_lookup_port */
+
+/*---------------------------------------------------------------------------*/
+mach_port_t ports_get_right (void *port)
+{
+  return MACH_PORT_NULL;
+}				/*ports_get_right */
+
+/*---------------------------------------------------------------------------*/
+void ports_port_deref (void *port)
+{
+}				/*ports_port_deref */
+
+/*---------------------------------------------------------------------------*/
+error_t ports_destroy_right (void *port)
+{
+  return 0;
+}				/*ports_destroy_right */
+
+/*---------------------------------------------------------------------------*/
+error_t ports_inhibit_bucket_rpcs (struct port_bucket *bucket)
+{
+  return 0;
+}				/*ports_inhibit_bucket_rpcs */
+
+/*---------------------------------------------------------------------------*/
+void ports_resume_bucket_rpcs (struct port_bucket *bucket)
+{
+}				/*ports_resume_bucket_rpcs */
+
+/*---------------------------------------------------------------------------*/
+error_t
+  ports_class_iterate
+  (struct port_class *class, error_t (*fun) (void *port))
+{
+  return 0;
+}				/*ports_class_iterate */
+
+/*---------------------------------------------------------------------------*/
+void
+  ports_manage_port_operations_one_thread
+  (struct port_bucket *bucket, ports_demuxer_type demuxer, int timeout)
+{
+}				/*ports_manage_port_operations_one_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Creates a node with one reference to it*/
+struct node *netfs_make_node (struct netnode *nn)
+{
+  struct node *np = calloc (1, sizeof (struct node));
+
+  if (!np)
+    return NULL;
+
+  np->nn = nn;
+  np->references = 1;
+  mutex_init (&np->lock);
+  return np;
+}				/*netfs_make_node */
+
+/*---------------------------------------------------------------------------*/
+/*Adds a reference to `np`*/
+void netfs_nref (struct node *np)
+{
+  spin_lock (&netfs_node_refcnt_lock);
+  ++np->references;
+  spin_unlock (&netfs_node_refcnt_lock);
+}				/*netfs_nref */
+
+/*---------------------------------------------------------------------------*/
+/*Drops a reference to `np`, destroying it with the last one*/
+void netfs_nrele (struct node *np)
+{
+  spin_lock (&netfs_node_refcnt_lock);
+  if (--np->references == 0)
+    {
+      mutex_lock (&np->lock);
+      netfs_node_norefs (np);
+    }
+  spin_unlock (&netfs_node_refcnt_lock);
+}				/*netfs_nrele */
+
+/*---------------------------------------------------------------------------*/
+/*Unlocks `np` and drops a reference to it*/
+void netfs_nput (struct node *np)
+{
+  mutex_unlock (&np->lock);
+  netfs_nrele (np);
+}				/*netfs_nput */
+
+/*---------------------------------------------------------------------------*/
+/*No clients connect on the host*/
+struct peropen *netfs_make_peropen (struct node *np, int flags,
+				    struct peropen *context)
+{
+  return NULL;
+}				/*netfs_make_peropen */
+
+/*---------------------------------------------------------------------------*/
+struct protid *netfs_make_protid (struct peropen *po, struct iouser *user)
+{
+  return NULL;
+}				/*netfs_make_protid */
+
+/*---------------------------------------------------------------------------*/
+void netfs_init (void)
+{
+  netfs_port_bucket = ports_create_bucket ();
+  netfs_control_class = ports_create_class (NULL, NULL);
+}				/*netfs_init */
+
+/*---------------------------------------------------------------------------*/
+mach_port_t netfs_startup (mach_port_t bootstrap, int flags)
+{
+  return MACH_PORT_NULL;
+}				/*netfs_startup */
+
+/*---------------------------------------------------------------------------*/
+error_t netfs_shutdown (int flags)
+{
+  return 0;
+}				/*netfs_shutdown */
+
+/*---------------------------------------------------------------------------*/
+int netfs_demuxer (mach_msg_header_t * inp, mach_msg_header_t * outp)
+{
+  return 0;
+}				/*netfs_demuxer */
+
+/*---------------------------------------------------------------------------*/
+error_t netfs_append_std_options (char **argz, size_t * argz_len)
+{
+  return 0;
+}				/*netfs_append_std_options */
+
+/*---------------------------------------------------------------------------*/
+int fs_notify_server (mach_msg_header_t * inp, mach_msg_header_t * outp)
+{
+  return 0;
+}				/*fs_notify_server */
+
+/*---------------------------------------------------------------------------*/
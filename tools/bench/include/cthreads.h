@@ -0,0 +1,94 @@
+/*---------------------------------------------------------------------------*/
+/*cthreads.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the C threads of the Hurd, built on POSIX threads*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __CTHREADS_H__
+#define __CTHREADS_H__
+/*---------------------------------------------------------------------------*/
+#include <pthread.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The mutexes*/
+#define MUTEX_INITIALIZER { PTHREAD_MUTEX_INITIALIZER }
+#define mutex_init(x) pthread_mutex_init (&(x)->m, NULL)
+#define mutex_lock(x) pthread_mutex_lock (&(x)->m)
+#define mutex_unlock(x) pthread_mutex_unlock (&(x)->m)
+#define mutex_try_lock(x) (pthread_mutex_trylock (&(x)->m) == 0)
+#define mutex_clear(x) pthread_mutex_destroy (&(x)->m)
+/*---------------------------------------------------------------------------*/
+/*The condition variables*/
+#define CONDITION_INITIALIZER { PTHREAD_COND_INITIALIZER }
+#define condition_init(x) pthread_cond_init (&(x)->c, NULL)
+#define condition_wait(cv, mx) pthread_cond_wait (&(cv)->c, &(mx)->m)
+#define condition_signal(x) pthread_cond_signal (&(x)->c)
+#define condition_broadcast(x) pthread_cond_broadcast (&(x)->c)
+#define condition_clear(x) pthread_cond_destroy (&(x)->c)
+/*---------------------------------------------------------------------------*/
+/*The spin locks (zero when unlocked, as in the Hurd, unlike the POSIX
+  ones)*/
+#define SPIN_LOCK_INITIALIZER 0
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+struct mutex
+{
+  pthread_mutex_t m;
+};
+/*---------------------------------------------------------------------------*/
+struct condition
+{
+  pthread_cond_t c;
+};
+/*---------------------------------------------------------------------------*/
+typedef volatile int spin_lock_t;
+typedef void *any_t;
+typedef struct cthread *cthread_t;
+typedef any_t (*cthread_fn_t) (any_t arg);
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Starts a thread running `fn` on `arg`*/
+cthread_t cthread_fork (cthread_fn_t fn, any_t arg);
+/*---------------------------------------------------------------------------*/
+/*Lets the thread `t` go away on its own when it exits*/
+void cthread_detach (cthread_t t);
+/*---------------------------------------------------------------------------*/
+/*Takes the spin lock `l`*/
+static inline void spin_lock (spin_lock_t * l)
+{
+  while (__sync_lock_test_and_set (l, 1))
+    while (*l)
+      ;
+}				/*spin_lock */
+
+/*---------------------------------------------------------------------------*/
+/*Releases the spin lock `l`*/
+static inline void spin_unlock (spin_lock_t * l)
+{
+  __sync_lock_release (l);
+}				/*spin_unlock */
+
+/*---------------------------------------------------------------------------*/
+#endif /*__CTHREADS_H__*/
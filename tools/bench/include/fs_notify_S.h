@@ -0,0 +1,42 @@
+/*---------------------------------------------------------------------------*/
+/*fs_notify_S.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the server side of the fs_notify interface*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __FS_NOTIFY_S_H__
+#define __FS_NOTIFY_S_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*The routines of the filter serving the notifications*/
+kern_return_t S_file_changed (fs_notify_t notify, natural_t ticketno,
+			      file_changed_type_t change, loff_t start,
+			      loff_t end);
+kern_return_t S_dir_changed (fs_notify_t notify, natural_t ticketno,
+			     dir_changed_type_t change, string_t name);
+/*---------------------------------------------------------------------------*/
+/*Demultiplexes the notifications (none arrive on the host)*/
+int fs_notify_server (mach_msg_header_t * inp, mach_msg_header_t * outp);
+/*---------------------------------------------------------------------------*/
+#endif /*__FS_NOTIFY_S_H__*/
@@ -0,0 +1,54 @@
+/*---------------------------------------------------------------------------*/
+/*fs.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the fs interface, served by the stand-in translators*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __HURD_FS_H__
+#define __HURD_FS_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+kern_return_t file_get_fs_options (file_t file, data_t * options,
+				   mach_msg_type_number_t * options_len);
+kern_return_t file_get_translator_cntl (file_t file, fsys_t * cntl);
+kern_return_t file_set_size (file_t file, loff_t size);
+kern_return_t file_sync (file_t file, int wait, int omit_metadata);
+kern_return_t file_syncfs (file_t file, int wait, int do_children);
+kern_return_t file_notice_changes (file_t file, mach_port_t port,
+				   mach_msg_type_name_t type);
+kern_return_t dir_notice_changes (file_t dir, mach_port_t port,
+				  mach_msg_type_name_t type);
+kern_return_t dir_lookup (file_t dir, char *name, int flags, mode_t mode,
+			  retry_type * retry, string_t retry_name,
+			  mach_port_t * port);
+kern_return_t dir_readdir (file_t dir, data_t * data,
+			   mach_msg_type_number_t * datalen, int entry,
+			   int nentries, vm_size_t bufsize, int *amount);
+kern_return_t dir_mkdir (file_t dir, char *name, mode_t mode);
+kern_return_t dir_link (file_t dir, file_t file, char *name, int excl);
+/*---------------------------------------------------------------------------*/
+/*Opens the file `name`*/
+file_t file_name_lookup (const char *name, int flags, mode_t mode);
+/*---------------------------------------------------------------------------*/
+#endif /*__HURD_FS_H__*/
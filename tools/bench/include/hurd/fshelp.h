@@ -0,0 +1,69 @@
+/*---------------------------------------------------------------------------*/
+/*fshelp.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the filesystem server helpers of the Hurd*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __HURD_FSHELP_H__
+#define __HURD_FSHELP_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+#include <hurd/iohelp.h>
+#include <maptime.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The times fshelp_touch updates*/
+#define TOUCH_ATIME 1
+#define TOUCH_MTIME 2
+#define TOUCH_CTIME 4
+/*---------------------------------------------------------------------------*/
+/*The state of an unlocked file*/
+#define LOCK_UN 8
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The active translator of a node*/
+struct transbox
+{
+  mach_port_t active;
+};
+/*---------------------------------------------------------------------------*/
+/*The lock clients may take on a node with file_lock*/
+struct lock_box
+{
+  int type;
+};
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*The stand-in users may do everything*/
+error_t fshelp_access (struct stat *st, int op, struct iouser *user);
+error_t fshelp_isowner (struct stat *st, struct iouser *user);
+/*---------------------------------------------------------------------------*/
+void fshelp_touch (struct stat *st, unsigned what,
+		   volatile struct mapped_time_value *maptime);
+error_t fshelp_fetch_control (struct transbox *box, mach_port_t * control);
+error_t fshelp_acquire_lock (struct lock_box *box, int *user,
+			     struct mutex *mut, int flags);
+/*---------------------------------------------------------------------------*/
+#endif /*__HURD_FSHELP_H__*/
@@ -0,0 +1,46 @@
+/*---------------------------------------------------------------------------*/
+/*fsys.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the fsys interface, served by the stand-in translators*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __HURD_FSYS_H__
+#define __HURD_FSYS_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+kern_return_t fsys_getroot (fsys_t fsys, mach_port_t dotdot,
+			    mach_msg_type_name_t dotdot_type, uid_t * uids,
+			    mach_msg_type_number_t nuids, gid_t * gids,
+			    mach_msg_type_number_t ngids, int flags,
+			    retry_type * retry, string_t retry_name,
+			    file_t * file);
+kern_return_t fsys_startup (mach_port_t bootstrap, int flags,
+			    mach_port_t control,
+			    mach_msg_type_name_t control_type,
+			    mach_port_t * realnode);
+kern_return_t fsys_forward (mach_port_t server, mach_port_t requestor,
+			    mach_msg_type_name_t requestor_type, data_t argv,
+			    mach_msg_type_number_t argv_len);
+/*---------------------------------------------------------------------------*/
+#endif /*__HURD_FSYS_H__*/
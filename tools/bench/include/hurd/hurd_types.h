@@ -0,0 +1,188 @@
+/*---------------------------------------------------------------------------*/
+/*hurd_types.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the types and the kernel calls of the Hurd and of Mach
+  used by the filter, for building it on a POSIX host*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __HURD_HURD_TYPES_H__
+#define __HURD_HURD_TYPES_H__
+/*---------------------------------------------------------------------------*/
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/time.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The special port names*/
+#define MACH_PORT_NULL ((mach_port_t) 0)
+#define MACH_PORT_DEAD ((mach_port_t) ~0)
+#define MACH_PORT_VALID(n) (((n) != MACH_PORT_NULL) && ((n) != MACH_PORT_DEAD))
+/*---------------------------------------------------------------------------*/
+/*The ways of passing a port right in a message*/
+#define MACH_MSG_TYPE_MOVE_SEND      17
+#define MACH_MSG_TYPE_MOVE_SEND_ONCE 18
+#define MACH_MSG_TYPE_COPY_SEND      19
+#define MACH_MSG_TYPE_MAKE_SEND      20
+#define MACH_MSG_TYPE_MAKE_SEND_ONCE 21
+/*---------------------------------------------------------------------------*/
+/*The kinds of port rights*/
+#define MACH_PORT_RIGHT_SEND    0
+#define MACH_PORT_RIGHT_RECEIVE 1
+#define MACH_PORT_TYPE_SEND      (1 << 16)
+#define MACH_PORT_TYPE_DEAD_NAME (1 << 20)
+/*---------------------------------------------------------------------------*/
+/*The errors of sending a message to a dead port*/
+#define EMACH_SEND_INVALID_DEST 0x10000003
+#define MIG_SERVER_DIED         (-308)
+/*---------------------------------------------------------------------------*/
+/*The open modes of the Hurd, which are not in the flags of the host*/
+#define O_READ     0x10000000
+#define O_WRITE    0x20000000
+#define O_EXEC     0x40000000
+#define O_NOTRANS  0x08000000
+#define O_HURD     (0xffff | O_READ | O_WRITE | O_EXEC | O_NOTRANS)
+#define OPENONLY_STATE_MODES \
+  (O_CREAT | O_EXCL | O_NOCTTY | O_TRUNC | O_NOTRANS)
+/*---------------------------------------------------------------------------*/
+/*The mode bits of the translators of a node*/
+#define S_ITRANS 000070000000
+/*---------------------------------------------------------------------------*/
+/*An anonymous mapping is private by default in the Hurd, which has no
+  MAP_PRIVATE flag*/
+#undef MAP_ANON
+#define MAP_ANON (MAP_ANONYMOUS | MAP_PRIVATE)
+/*---------------------------------------------------------------------------*/
+/*The host keeps the filesystem of a file in `st_dev`*/
+#define st_fsid st_dev
+/*---------------------------------------------------------------------------*/
+/*Rounds `x` to the pages*/
+#define round_page(x) \
+  ((((vm_address_t) (x)) + vm_page_size - 1) & ~(vm_page_size - 1))
+#define trunc_page(x) (((vm_address_t) (x)) & ~(vm_page_size - 1))
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The names of ports; the stand-in translators give their objects these
+  numbers*/
+typedef unsigned int mach_port_t;
+typedef mach_port_t task_t, file_t, io_t, fsys_t, auth_t, fs_notify_t;
+/*---------------------------------------------------------------------------*/
+/*The sizes passed in messages (as wide as size_t, as on the 32-bit Hurd,
+  which the filter relies on)*/
+typedef size_t mach_msg_type_number_t;
+typedef size_t vm_size_t;
+typedef uintptr_t vm_address_t;
+/*---------------------------------------------------------------------------*/
+typedef int kern_return_t;
+typedef unsigned int natural_t;
+typedef unsigned int mach_msg_type_name_t;
+typedef unsigned int mach_port_type_t;
+typedef unsigned int mach_port_right_t;
+typedef int mach_port_delta_t;
+typedef unsigned int mach_msg_id_t;
+typedef char *data_t;
+typedef char string_t[1024];
+typedef struct stat io_statbuf_t;
+typedef struct statfs fsys_statfsbuf_t;
+/*---------------------------------------------------------------------------*/
+/*What the caller of dir_lookup must do with the name returned*/
+typedef int retry_type;
+#define FS_RETRY_NORMAL  1
+#define FS_RETRY_REAUTH  2
+#define FS_RETRY_MAGICAL 3
+/*---------------------------------------------------------------------------*/
+/*The changes reported by file_changed and dir_changed*/
+enum file_changed_type
+{
+  FILE_CHANGED_NULL,
+  FILE_CHANGED_WRITE,
+  FILE_CHANGED_EXTEND,
+  FILE_CHANGED_TRUNCATE,
+  FILE_CHANGED_META
+};
+typedef enum file_changed_type file_changed_type_t;
+enum dir_changed_type
+{
+  DIR_CHANGED_NULL,
+  DIR_CHANGED_NEW,
+  DIR_CHANGED_UNLINK,
+  DIR_CHANGED_RENUMBER
+};
+typedef enum dir_changed_type dir_changed_type_t;
+/*---------------------------------------------------------------------------*/
+/*The header and the type descriptor of a message*/
+typedef struct
+{
+  mach_msg_type_name_t msgh_bits;
+  unsigned int msgh_size;
+  mach_port_t msgh_remote_port;
+  mach_port_t msgh_local_port;
+  mach_port_t msgh_seqno;
+  mach_msg_id_t msgh_id;
+} mach_msg_header_t;
+typedef struct
+{
+  unsigned int msgt_bits;
+} mach_msg_type_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The size of a page*/
+extern vm_size_t vm_page_size;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*The kernel calls on ports; the stand-in ports hold no references, so
+  these only report success*/
+mach_port_t mach_task_self (void);
+kern_return_t mach_port_deallocate (task_t task, mach_port_t name);
+kern_return_t mach_port_mod_refs (task_t task, mach_port_t name,
+				  mach_port_right_t right,
+				  mach_port_delta_t delta);
+kern_return_t mach_port_type (task_t task, mach_port_t name,
+			      mach_port_type_t * type);
+kern_return_t mach_port_request_notification (task_t task, mach_port_t name,
+					      mach_msg_id_t id,
+					      unsigned int sync,
+					      mach_port_t notify,
+					      mach_msg_type_name_t type,
+					      mach_port_t * previous);
+kern_return_t task_get_bootstrap_port (task_t task, mach_port_t * port);
+/*---------------------------------------------------------------------------*/
+/*Frees the data returned out of line; the stand-in translators return it
+  in buffers of their own, so this does nothing*/
+kern_return_t vm_deallocate (task_t task, vm_address_t address,
+			     vm_size_t size);
+/*---------------------------------------------------------------------------*/
+/*Returns the effective user IDs of the process*/
+int geteuids (int n, uid_t * uids);
+/*---------------------------------------------------------------------------*/
+#endif /*__HURD_HURD_TYPES_H__*/
@@ -0,0 +1,73 @@
+/*---------------------------------------------------------------------------*/
+/*ihash.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the integer hash tables of the Hurd*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __HURD_IHASH_H__
+#define __HURD_IHASH_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The offset of the location pointer in the values, if they have none*/
+#define HURD_IHASH_NO_LOCP INTPTR_MIN
+/*---------------------------------------------------------------------------*/
+/*Initializes a table statically*/
+#define HURD_IHASH_INITIALIZER(locp_offs) { 0, 0, NULL, (locp_offs) }
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+typedef uintptr_t hurd_ihash_key_t;
+typedef void *hurd_ihash_value_t;
+typedef hurd_ihash_value_t *hurd_ihash_locp_t;
+/*---------------------------------------------------------------------------*/
+/*An entry of a table (the value is NULL in a free slot)*/
+struct hurd_ihash_item
+{
+  hurd_ihash_key_t key;
+  hurd_ihash_value_t value;
+  int removed;
+};
+/*---------------------------------------------------------------------------*/
+/*A table with open addressing*/
+struct hurd_ihash
+{
+  size_t nr_items;
+  size_t size;
+  struct hurd_ihash_item *items;
+  intptr_t locp_offset;
+};
+typedef struct hurd_ihash *hurd_ihash_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+void hurd_ihash_init (hurd_ihash_t ht, intptr_t locp_offset);
+void hurd_ihash_destroy (hurd_ihash_t ht);
+error_t hurd_ihash_add (hurd_ihash_t ht, hurd_ihash_key_t key,
+			hurd_ihash_value_t value);
+hurd_ihash_value_t hurd_ihash_find (hurd_ihash_t ht, hurd_ihash_key_t key);
+int hurd_ihash_remove (hurd_ihash_t ht, hurd_ihash_key_t key);
+void hurd_ihash_locp_remove (hurd_ihash_t ht, hurd_ihash_locp_t locp);
+/*---------------------------------------------------------------------------*/
+#endif /*__HURD_IHASH_H__*/
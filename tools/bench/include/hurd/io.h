@@ -0,0 +1,43 @@
+/*---------------------------------------------------------------------------*/
+/*io.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the io interface, served by the stand-in translators*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __HURD_IO_H__
+#define __HURD_IO_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+kern_return_t io_read (io_t io, data_t * data,
+		       mach_msg_type_number_t * datalen, loff_t offset,
+		       vm_size_t amount);
+kern_return_t io_write (io_t io, data_t data, mach_msg_type_number_t datalen,
+			loff_t offset, vm_size_t * amount);
+kern_return_t io_stat (io_t io, io_statbuf_t * stat);
+kern_return_t io_map (io_t io, mach_port_t * rdobj, mach_port_t * wrobj);
+kern_return_t io_restrict_auth (io_t io, mach_port_t * newio, uid_t * uids,
+				mach_msg_type_number_t nuids, gid_t * gids,
+				mach_msg_type_number_t ngids);
+/*---------------------------------------------------------------------------*/
+#endif /*__HURD_IO_H__*/
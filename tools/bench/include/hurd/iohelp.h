@@ -0,0 +1,52 @@
+/*---------------------------------------------------------------------------*/
+/*iohelp.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the I/O server helpers of the Hurd*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __HURD_IOHELP_H__
+#define __HURD_IOHELP_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A set of IDs*/
+struct idvec
+{
+  uid_t *ids;
+  unsigned num, alloced;
+};
+/*---------------------------------------------------------------------------*/
+/*The identity of a user*/
+struct iouser
+{
+  struct idvec *uids, *gids;
+  void *hook;
+};
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+error_t iohelp_create_complex_iouser (struct iouser **user, uid_t * uids,
+				      int nuids, gid_t * gids, int ngids);
+void iohelp_free_iouser (struct iouser *user);
+/*---------------------------------------------------------------------------*/
+#endif /*__HURD_IOHELP_H__*/
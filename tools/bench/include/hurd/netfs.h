@@ -0,0 +1,112 @@
+/*---------------------------------------------------------------------------*/
+/*netfs.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the network filesystem library of the Hurd: the nodes
+  and the opens the filter is called with*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __HURD_NETFS_H__
+#define __HURD_NETFS_H__
+/*---------------------------------------------------------------------------*/
+#include <argp.h>
+#include <hurd/hurd_types.h>
+#include <hurd/ports.h>
+#include <hurd/fshelp.h>
+#include <hurd/iohelp.h>
+#include <hurd/fs.h>
+#include <hurd/io.h>
+#include <hurd/fsys.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A node*/
+struct node
+{
+  struct netnode *nn;
+  struct stat nn_stat;
+  int nn_translated;
+  struct mutex lock;
+  int references;
+  struct transbox transbox;
+  struct lock_box userlock;
+};
+/*---------------------------------------------------------------------------*/
+/*An open of a node*/
+struct peropen
+{
+  loff_t filepointer;
+  int lock_status;
+  int refcnt;
+  int openstat;
+  struct node *np;
+  mach_port_t root_parent;
+  mach_port_t shadow_root_parent;
+  struct node *shadow_root;
+};
+/*---------------------------------------------------------------------------*/
+/*A port to an open of a node*/
+struct protid
+{
+  struct port_info pi;
+  struct iouser *user;
+  struct peropen *po;
+};
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+extern struct node *netfs_root_node;
+extern struct port_bucket *netfs_port_bucket;
+extern struct port_class *netfs_control_class;
+extern spin_lock_t netfs_node_refcnt_lock;
+extern struct argp *netfs_runtime_argp;
+extern const struct argp netfs_std_runtime_argp;
+extern const struct argp netfs_std_startup_argp;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*The nodes and their references*/
+struct node *netfs_make_node (struct netnode *nn);
+void netfs_nref (struct node *np);
+void netfs_nrele (struct node *np);
+void netfs_nput (struct node *np);
+/*---------------------------------------------------------------------------*/
+/*The opens*/
+struct peropen *netfs_make_peropen (struct node *np, int flags,
+				    struct peropen *context);
+struct protid *netfs_make_protid (struct peropen *po, struct iouser *user);
+/*---------------------------------------------------------------------------*/
+/*The server*/
+void netfs_init (void);
+mach_port_t netfs_startup (mach_port_t bootstrap, int flags);
+error_t netfs_shutdown (int flags);
+int netfs_demuxer (mach_msg_header_t * inp, mach_msg_header_t * outp);
+error_t netfs_append_std_options (char **argz, size_t * argz_len);
+/*---------------------------------------------------------------------------*/
+/*The callbacks the filter implements*/
+void netfs_node_norefs (struct node *np);
+error_t netfs_validate_stat (struct node *np, struct iouser *cred);
+error_t netfs_check_open_permissions (struct iouser *user, struct node *np,
+				      int flags, int newnode);
+error_t netfs_append_args (char **argz, size_t * argz_len);
+void netfs_release_peropen (struct peropen *po);
+/*---------------------------------------------------------------------------*/
+#endif /*__HURD_NETFS_H__*/
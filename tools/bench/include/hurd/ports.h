@@ -0,0 +1,70 @@
+/*---------------------------------------------------------------------------*/
+/*ports.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the port management library of the Hurd*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __HURD_PORTS_H__
+#define __HURD_PORTS_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+#include <cthreads.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+struct port_bucket;
+struct port_class;
+/*---------------------------------------------------------------------------*/
+/*The header of every object with a port*/
+struct port_info
+{
+  struct port_class *class;
+  int refcnt;
+  mach_port_t port_right;
+  struct port_bucket *bucket;
+};
+/*---------------------------------------------------------------------------*/
+/*The function demultiplexing the incoming messages*/
+typedef int (*ports_demuxer_type) (mach_msg_header_t * inp,
+				   mach_msg_header_t * outp);
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+struct port_class *ports_create_class (void (*clean_routine) (void *),
+				       void (*dropweak_routine) (void *));
+struct port_bucket *ports_create_bucket (void);
+error_t ports_create_port (struct port_class *class,
+			   struct port_bucket *bucket, size_t size,
+			   void *result);
+void *ports_lookup_port (struct port_bucket *bucket, mach_port_t port,
+			 struct port_class *class);
+mach_port_t ports_get_right (void *port);
+void ports_port_deref (void *port);
+error_t ports_destroy_right (void *port);
+error_t ports_inhibit_bucket_rpcs (struct port_bucket *bucket);
+void ports_resume_bucket_rpcs (struct port_bucket *bucket);
+error_t ports_class_iterate (struct port_class *class,
+			     error_t (*fun) (void *port));
+void ports_manage_port_operations_one_thread (struct port_bucket *bucket,
+					      ports_demuxer_type demuxer,
+					      int timeout);
+/*---------------------------------------------------------------------------*/
+#endif /*__HURD_PORTS_H__*/
@@ -0,0 +1,46 @@
+/*---------------------------------------------------------------------------*/
+/*notify.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the notifications of the kernel*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __MACH_NOTIFY_H__
+#define __MACH_NOTIFY_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The notifications sent by the kernel*/
+#define MACH_NOTIFY_FIRST     0100
+#define MACH_NOTIFY_DEAD_NAME (MACH_NOTIFY_FIRST + 010)
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The notification of the death of a port*/
+typedef struct
+{
+  mach_msg_header_t not_header;
+  mach_msg_type_t not_type;
+  mach_port_t not_port;
+} mach_dead_name_notification_t;
+/*---------------------------------------------------------------------------*/
+#endif /*__MACH_NOTIFY_H__*/
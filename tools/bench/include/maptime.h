@@ -0,0 +1,55 @@
+/*---------------------------------------------------------------------------*/
+/*maptime.h*/
+/*---------------------------------------------------------------------------*/
+/*The stand-in for the time mapped from the kernel*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __MAPTIME_H__
+#define __MAPTIME_H__
+/*---------------------------------------------------------------------------*/
+#include <sys/time.h>
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The time mapped from the kernel (unused: the time is read from the
+  host)*/
+struct mapped_time_value
+{
+  volatile long seconds;
+  volatile long microseconds;
+  volatile long check_seconds;
+};
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Maps the time*/
+error_t maptime_map (int use_mach_dev, char *dev_name,
+		     volatile struct mapped_time_value **mtime);
+/*---------------------------------------------------------------------------*/
+/*Reads the current time*/
+static inline void
+maptime_read (volatile struct mapped_time_value *mtime, struct timeval *tv)
+{
+  gettimeofday (tv, NULL);
+}
+/*---------------------------------------------------------------------------*/
+#endif /*__MAPTIME_H__*/
@@ -0,0 +1,436 @@
+/*---------------------------------------------------------------------------*/
+/*target.c*/
+/*---------------------------------------------------------------------------*/
+/*The translators the benchmark of the filter runs against*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <cthreads.h>
+#include <hurd/fs.h>
+#include <hurd/fsys.h>
+#include <hurd/io.h>
+/*---------------------------------------------------------------------------*/
+#include "target.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The size of the pattern the files are copied from (a multiple of the
+  period of the pattern, 26, is added so that a copy may start anywhere in
+  the first period)*/
+#define PATTERN_CHUNK 65536
+#define PATTERN_SIZE (PATTERN_CHUNK + 26)
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The backend*/
+int target_backend = TARGET_MEMORY;
+/*---------------------------------------------------------------------------*/
+/*The delay of every request to the latency backend*/
+long target_latency = 100;
+/*---------------------------------------------------------------------------*/
+/*The rate of the link of the bandwidth backend*/
+long long target_bandwidth = 100LL << 20;
+/*---------------------------------------------------------------------------*/
+/*The size of every file*/
+loff_t target_size = 64LL << 20;
+/*---------------------------------------------------------------------------*/
+/*The level the target sits on*/
+int target_depth = 2;
+/*---------------------------------------------------------------------------*/
+/*The name the target reports*/
+const char *target_translator = "/hurd/target";
+/*---------------------------------------------------------------------------*/
+/*The names of the backends, in the order of their numbers*/
+static const char *target_backends[] = { "mem", "latency", "bandwidth" };
+/*---------------------------------------------------------------------------*/
+/*The contents of every file, starting at the offset 0*/
+static char pattern[PATTERN_SIZE];
+static pthread_once_t pattern_once = PTHREAD_ONCE_INIT;
+/*---------------------------------------------------------------------------*/
+/*The time (in nanoseconds) at which the link of the bandwidth backend
+  becomes free and the lock protecting it*/
+static uint64_t link_free;
+static struct mutex link_lock = MUTEX_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Returns the current time in nanoseconds*/
+static uint64_t now_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}				/*now_ns */
+
+/*---------------------------------------------------------------------------*/
+/*Sleeps until the time `ns`*/
+static void sleep_until (uint64_t ns)
+{
+  struct timespec ts = { ns / 1000000000ULL, ns % 1000000000ULL };
+
+  while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    ;
+}				/*sleep_until */
+
+/*---------------------------------------------------------------------------*/
+/*Delays a request carrying `bytes` bytes of data as the backend would*/
+static void target_delay (size_t bytes)
+{
+  uint64_t start = now_ns (), done;
+
+  switch (target_backend)
+    {
+    case TARGET_LATENCY:
+      sleep_until (start + target_latency * 1000ULL);
+      break;
+
+    case TARGET_BANDWIDTH:
+      /*the data goes over the link after the data of the earlier requests */
+      if (!bytes)
+	break;
+      mutex_lock (&link_lock);
+      if (link_free < start)
+	link_free = start;
+      link_free += bytes * 1000000000ULL / target_bandwidth;
+      done = link_free;
+      mutex_unlock (&link_lock);
+
+      sleep_until (done);
+      break;
+    }
+}				/*target_delay */
+
+/*---------------------------------------------------------------------------*/
+/*Fills the pattern the files are copied from*/
+static void pattern_init (void)
+{
+  size_t i;
+
+  for (i = 0; i < PATTERN_SIZE; ++i)
+    pattern[i] = TARGET_BYTE (i);
+}				/*pattern_init */
+
+/*---------------------------------------------------------------------------*/
+/*Copies `len` bytes from the offset `offset` of a file into `data`*/
+static void target_copy (char *data, loff_t offset, size_t len)
+{
+  size_t chunk;
+
+  pthread_once (&pattern_once, pattern_init);
+
+  for (; len; data += chunk, offset += chunk, len -= chunk)
+    {
+      chunk = (len < PATTERN_CHUNK) ? len : PATTERN_CHUNK;
+      memcpy (data, pattern + offset % 26, chunk);
+    }
+}				/*target_copy */
+
+/*---------------------------------------------------------------------------*/
+/*Finds the backend called `name`*/
+int target_backend_find (const char *name)
+{
+  int i;
+
+  for (i = 0; i < sizeof (target_backends) / sizeof (*target_backends); ++i)
+    if (strcmp (name, target_backends[i]) == 0)
+      return i;
+
+  return -1;
+}				/*target_backend_find */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the name of the backend `backend`*/
+const char *target_backend_name (int backend)
+{
+  return target_backends[backend];
+}				/*target_backend_name */
+
+/*---------------------------------------------------------------------------*/
+/*Reads up to `amount` bytes from `offset` of a file; a short reply is
+  copied into `*data`, a longer one is returned in a new buffer, which the
+  caller unmaps*/
+kern_return_t
+  io_read
+  (io_t io, data_t * data, mach_msg_type_number_t * datalen, loff_t offset,
+   vm_size_t amount)
+{
+  char *buf;
+
+  if (TARGET_CNTL (io))
+    return EOPNOTSUPP;
+
+  /*Nothing is read past the end of the file */
+  if (offset >= target_size)
+    amount = 0;
+  else if (amount > target_size - offset)
+    amount = target_size - offset;
+
+  target_delay (amount);
+
+  /*Return the data out of line if the caller has no room for it */
+  if ((amount > TARGET_INLINE_MAX) || (amount > *datalen))
+    {
+      buf = mmap (NULL, amount, PROT_READ | PROT_WRITE,
+		  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (buf == MAP_FAILED)
+	return ENOMEM;
+      *data = buf;
+    }
+
+  target_copy (*data, offset, amount);
+  *datalen = amount;
+  return 0;
+}				/*io_read */
+
+/*---------------------------------------------------------------------------*/
+/*Accepts the data written to a file and drops it*/
+kern_return_t
+  io_write
+  (io_t io, data_t data, mach_msg_type_number_t datalen, loff_t offset,
+   vm_size_t * amount)
+{
+  if (TARGET_CNTL (io))
+    return EOPNOTSUPP;
+
+  target_delay (datalen);
+  *amount = datalen;
+  return 0;
+}				/*io_write */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the stat information of a file, which is the same on every level
+  of its stack*/
+kern_return_t io_stat (io_t io, io_statbuf_t * stat)
+{
+  if (TARGET_CNTL (io))
+    return EOPNOTSUPP;
+
+  target_delay (0);
+
+  memset (stat, 0, sizeof (*stat));
+  stat->st_mode = TARGET_FILE (io) ? (S_IFREG | 0644) : (S_IFDIR | 0755);
+  stat->st_nlink = 1;
+  stat->st_size = TARGET_FILE (io) ? target_size : 0;
+  stat->st_ino = TARGET_FILE (io) + 1;
+  stat->st_fsid = 1;
+  stat->st_blksize = vm_page_size;
+  stat->st_blocks = stat->st_size / 512;
+  return 0;
+}				/*io_stat */
+
+/*---------------------------------------------------------------------------*/
+/*The files cannot be mapped*/
+kern_return_t io_map (io_t io, mach_port_t * rdobj, mach_port_t * wrobj)
+{
+  return EOPNOTSUPP;
+}				/*io_map */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the same port, since the files check no permissions*/
+kern_return_t
+  io_restrict_auth
+  (io_t io, mach_port_t * newio, uid_t * uids, mach_msg_type_number_t nuids,
+   gid_t * gids, mach_msg_type_number_t ngids)
+{
+  *newio = io;
+  return 0;
+}				/*io_restrict_auth */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the name of the translator on the level of `file`: the target on
+  the level `target_depth`, a stand-in below it. The name is kept until the
+  next call in the same thread; the filter does not free it.*/
+kern_return_t
+  file_get_fs_options
+  (file_t file, data_t * options, mach_msg_type_number_t * options_len)
+{
+  /*The names of the translators below the target */
+  static __thread char name[32];
+
+  if (TARGET_CNTL (file))
+    return EOPNOTSUPP;
+
+  target_delay (0);
+
+  if (TARGET_LEVEL (file) == target_depth)
+    *options = (data_t) target_translator;
+  else
+    {
+      snprintf (name, sizeof (name), "/hurd/layer%d", TARGET_LEVEL (file));
+      *options = name;
+    }
+
+  *options_len = strlen (*options) + 1;
+  return 0;
+}				/*file_get_fs_options */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the control port of the translator on top of `file`; the target
+  has none on top of it*/
+kern_return_t file_get_translator_cntl (file_t file, fsys_t * cntl)
+{
+  if (TARGET_CNTL (file))
+    return EOPNOTSUPP;
+
+  target_delay (0);
+
+  if (TARGET_LEVEL (file) >= target_depth)
+    return ENXIO;
+
+  *cntl = file | 1;
+  return 0;
+}				/*file_get_translator_cntl */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the root of the translator controlled by `fsys`: the same file
+  one level higher*/
+kern_return_t
+  fsys_getroot
+  (fsys_t fsys, mach_port_t dotdot, mach_msg_type_name_t dotdot_type,
+   uid_t * uids, mach_msg_type_number_t nuids, gid_t * gids,
+   mach_msg_type_number_t ngids, int flags, retry_type * retry,
+   string_t retry_name, file_t * file)
+{
+  if (!TARGET_CNTL (fsys))
+    return EOPNOTSUPP;
+
+  target_delay (0);
+
+  *retry = FS_RETRY_NORMAL;
+  *retry_name = 0;
+  *file = TARGET_PORT (TARGET_ALIAS (fsys), TARGET_FILE (fsys),
+		       TARGET_LEVEL (fsys) + 1, 0);
+  return 0;
+}				/*fsys_getroot */
+
+/*---------------------------------------------------------------------------*/
+/*Opens the current directory; nothing else is found*/
+file_t file_name_lookup (const char *name, int flags, mode_t mode)
+{
+  char *cwd = getcwd (NULL, 0);
+  file_t file = MACH_PORT_NULL;
+
+  if (cwd && (strcmp (name, cwd) == 0))
+    file = TARGET_PORT (1, 0, 0, 0);
+  else
+    errno = ENOENT;
+
+  free (cwd);
+  return file;
+}				/*file_name_lookup */
+
+/*---------------------------------------------------------------------------*/
+/*The files cannot be changed in any other way than by writing*/
+kern_return_t file_set_size (file_t file, loff_t size)
+{
+  return EOPNOTSUPP;
+}				/*file_set_size */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t file_sync (file_t file, int wait, int omit_metadata)
+{
+  return 0;
+}				/*file_sync */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t file_syncfs (file_t file, int wait, int do_children)
+{
+  return 0;
+}				/*file_syncfs */
+
+/*---------------------------------------------------------------------------*/
+/*The changes of the files are never notified*/
+kern_return_t
+  file_notice_changes
+  (file_t file, mach_port_t port, mach_msg_type_name_t type)
+{
+  return EOPNOTSUPP;
+}				/*file_notice_changes */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t
+  dir_notice_changes (file_t dir, mach_port_t port, mach_msg_type_name_t type)
+{
+  return EOPNOTSUPP;
+}				/*dir_notice_changes */
+
+/*---------------------------------------------------------------------------*/
+/*The files are not directories*/
+kern_return_t
+  dir_lookup
+  (file_t dir, char *name, int flags, mode_t mode, retry_type * retry,
+   string_t retry_name, mach_port_t * port)
+{
+  return ENOTDIR;
+}				/*dir_lookup */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t
+  dir_readdir
+  (file_t dir, data_t * data, mach_msg_type_number_t * datalen, int entry,
+   int nentries, vm_size_t bufsize, int *amount)
+{
+  return ENOTDIR;
+}				/*dir_readdir */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t dir_mkdir (file_t dir, char *name, mode_t mode)
+{
+  return ENOTDIR;
+}				/*dir_mkdir */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t dir_link (file_t dir, file_t file, char *name, int excl)
+{
+  return ENOTDIR;
+}				/*dir_link */
+
+/*---------------------------------------------------------------------------*/
+/*The benchmark does not start the filter on a node*/
+kern_return_t
+  fsys_startup
+  (mach_port_t bootstrap, int flags, mach_port_t control,
+   mach_msg_type_name_t control_type, mach_port_t * realnode)
+{
+  return EOPNOTSUPP;
+}				/*fsys_startup */
+
+/*---------------------------------------------------------------------------*/
+kern_return_t
+  fsys_forward
+  (mach_port_t server, mach_port_t requestor,
+   mach_msg_type_name_t requestor_type, data_t argv,
+   mach_msg_type_number_t argv_len)
+{
+  return EOPNOTSUPP;
+}				/*fsys_forward */
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,96 @@
+/*---------------------------------------------------------------------------*/
+/*target.h*/
+/*---------------------------------------------------------------------------*/
+/*The translators the benchmark of the filter runs against: a stack of
+  stand-in translators on every file, the topmost of which is the target,
+  served from memory with the delays of the chosen backend*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __TARGET_H__
+#define __TARGET_H__
+/*---------------------------------------------------------------------------*/
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The backends: the data is served from memory at once, after a fixed
+  delay, or at the rate of a link shared by all requests*/
+#define TARGET_MEMORY    0
+#define TARGET_LATENCY   1
+#define TARGET_BANDWIDTH 2
+/*---------------------------------------------------------------------------*/
+/*The port to the object on the level `level` of the stack on the file
+  `file`; `cntl` selects the control port of the translator and `alias`
+  tells apart ports to the same object (the file 0 is the current
+  directory)*/
+#define TARGET_PORT(alias, file, level, cntl) \
+  ((mach_port_t) (((alias) << 20) | ((file) << 8) | ((level) << 1) | (cntl)))
+/*---------------------------------------------------------------------------*/
+/*The parts of a port*/
+#define TARGET_ALIAS(port) ((port) >> 20)
+#define TARGET_FILE(port) (((port) >> 8) & 0xfff)
+#define TARGET_LEVEL(port) (((port) >> 1) & 0x7f)
+#define TARGET_CNTL(port) ((port) & 1)
+/*---------------------------------------------------------------------------*/
+/*The limits of the parts of a port*/
+#define TARGET_ALIASES 4096
+#define TARGET_FILES 4096
+#define TARGET_LEVELS 128
+/*---------------------------------------------------------------------------*/
+/*The largest reply returned in the buffer of the caller; larger ones are
+  returned out of line, in a buffer of their own*/
+#define TARGET_INLINE_MAX 2048
+/*---------------------------------------------------------------------------*/
+/*The byte at `offset` in every file*/
+#define TARGET_BYTE(offset) ((char) ('a' + (offset) % 26))
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The backend (one of TARGET_*)*/
+extern int target_backend;
+/*---------------------------------------------------------------------------*/
+/*The delay (in microseconds) of every request to the latency backend*/
+extern long target_latency;
+/*---------------------------------------------------------------------------*/
+/*The rate (in bytes per second) of the link of the bandwidth backend*/
+extern long long target_bandwidth;
+/*---------------------------------------------------------------------------*/
+/*The size of every file*/
+extern loff_t target_size;
+/*---------------------------------------------------------------------------*/
+/*The level of the stacks the target sits on: the filter climbs this many
+  levels, past translators with other names, to reach it*/
+extern int target_depth;
+/*---------------------------------------------------------------------------*/
+/*The name the target reports (the filter looks for it)*/
+extern const char *target_translator;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Finds the backend called `name`; returns -1 if there is none*/
+int target_backend_find (const char *name);
+/*---------------------------------------------------------------------------*/
+/*Returns the name of the backend `backend`*/
+const char *target_backend_name (int backend);
+/*---------------------------------------------------------------------------*/
+#endif /*__TARGET_H__*/
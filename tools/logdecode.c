@@ -0,0 +1,256 @@
+/*---------------------------------------------------------------------------*/
+/*logdecode.c*/
+/*---------------------------------------------------------------------------*/
+/*Turns the binary debug log of the filter back into text.
+
+  Usage: logdecode [FILE]
+
+  Reads the log written by the filters (by default /var/log/filter.dbg)
+  and prints one line per message: the time, the process and the thread
+  which have logged it and the message itself.
+  The log must be decoded on a machine with the same byte order and the
+  same size of `long` as the one it has been written on.
+
+  Build: gcc -O2 -o logdecode logdecode.c*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <errno.h>
+#include <error.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/*---------------------------------------------------------------------------*/
+#include "../log.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The longest conversion specification handled*/
+#define SPEC_MAX 32
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*The format of a message found in the log*/
+struct site
+{
+  /*the identifier of the site in the records */
+  uint64_t id;
+
+  /*the format */
+  char *fmt;
+
+  struct site *next;
+};				/*struct site */
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The formats read so far*/
+static struct site *sites;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Finds the format of the site `id`*/
+static const char *site_find (uint64_t id)
+{
+  struct site *site;
+
+  for (site = sites; site; site = site->next)
+    if (site->id == id)
+      return site->fmt;
+
+  return NULL;
+}				/*site_find */
+
+/*---------------------------------------------------------------------------*/
+/*Prints the message of `rec` with the format `fmt`, taking the arguments
+  in the same way as the filter has stored them*/
+static void print_message (const char *fmt, log_record_t * rec)
+{
+  const char *p = fmt, *start;
+  char spec[SPEC_MAX];
+  int n = 0, longs;
+  uint64_t arg;
+  double d;
+
+  while (*p)
+    {
+      /*copy the text up to the next conversion */
+      if (*p != '%')
+	{
+	  putchar (*p++);
+	  continue;
+	}
+
+      start = p;
+      p += 1 + strspn (p + 1, "#0123456789.- +'");
+
+      if (*p == '%')
+	{
+	  putchar (*p++);
+	  continue;
+	}
+
+      for (longs = 0; *p && strchr ("hlLqjzt", *p); ++p)
+	if (*p == 'l' || *p == 'z' || *p == 't')
+	  ++longs;
+	else if (*p == 'L' || *p == 'q' || *p == 'j')
+	  longs = 2;
+
+      if (!*p)
+	break;
+      ++p;
+
+      /*the filter stores no more arguments than this */
+      if (n >= LOG_ARGS_MAX)
+	{
+	  fputs ("?", stdout);
+	  continue;
+	}
+
+      /*print the argument with the conversion of the message */
+      snprintf (spec, sizeof (spec), "%.*s", (int) (p - start), start);
+      arg = rec->args[n++];
+
+      switch (p[-1])
+	{
+	case 's':
+	  printf (spec, rec->str + (arg < LOG_STR_MAX ? arg : 0));
+	  break;
+
+	case 'p':
+	  printf (spec, (void *) (uintptr_t) arg);
+	  break;
+
+	case 'e':
+	case 'E':
+	case 'f':
+	case 'g':
+	case 'G':
+	case 'a':
+	  memcpy (&d, &arg, sizeof (d));
+	  printf (spec, d);
+	  break;
+
+	default:
+	  if (longs == 0)
+	    printf (spec, (int) arg);
+	  else if (longs == 1)
+	    printf (spec, (long) arg);
+	  else
+	    printf (spec, (long long) arg);
+	}
+    }
+
+  putchar ('\n');
+}				/*print_message */
+
+/*---------------------------------------------------------------------------*/
+/*Entry point*/
+int main (int argc, char **argv)
+{
+  const char *file = (argc > 1) ? argv[1] : LOG_FILE_DEFAULT;
+  log_header_t header;
+  log_site_entry_t entry;
+  log_record_t rec;
+  struct site *site;
+  const char *fmt;
+  uint32_t kind;
+  FILE *f;
+
+  f = fopen (file, "r");
+  if (!f)
+    error (EXIT_FAILURE, errno, "%s", file);
+
+  /*The log starts with a header */
+  if ((fread (&kind, sizeof (kind), 1, f) != 1) || (kind != LOG_MAGIC))
+    error (EXIT_FAILURE, 0, "%s: Not a log of the filter", file);
+
+  /*Go through the entries; every filter appending to the log starts with
+     a header */
+  do
+    {
+      if (kind == LOG_MAGIC)
+	{
+	  /*check that the log has been written with the same layout */
+	  header.magic = kind;
+	  if (fread ((char *) &header + sizeof (kind),
+		     sizeof (header) - sizeof (kind), 1, f) != 1)
+	    break;
+	  if (header.record_size != sizeof (log_record_t))
+	    error (EXIT_FAILURE, 0, "%s: Records of %u bytes, expected %u",
+		   file, (unsigned) header.record_size,
+		   (unsigned) sizeof (log_record_t));
+	}
+      else if (kind == LOG_ENTRY_SITE)
+	{
+	  /*remember the format of a site */
+	  entry.kind = kind;
+	  if (fread ((char *) &entry + sizeof (kind),
+		     sizeof (entry) - sizeof (kind), 1, f) != 1)
+	    break;
+
+	  site = malloc (sizeof (struct site));
+	  if (!site || !(site->fmt = malloc (entry.len + 1)))
+	    error (EXIT_FAILURE, ENOMEM, "Could not store a format");
+	  if (fread (site->fmt, 1, entry.len, f) != entry.len)
+	    break;
+	  site->fmt[entry.len] = 0;
+	  site->id = entry.site;
+	  site->next = sites;
+	  sites = site;
+	}
+      else if (kind == LOG_ENTRY_RECORD)
+	{
+	  /*print a message */
+	  rec.kind = kind;
+	  if (fread ((char *) &rec + sizeof (kind),
+		     sizeof (rec) - sizeof (kind), 1, f) != 1)
+	    break;
+
+	  printf ("%u.%06u %u/%u: ", (unsigned) rec.sec, (unsigned) rec.usec,
+		  (unsigned) rec.pid, (unsigned) rec.thread);
+
+	  /*the filter reports the messages which have not fit in the ring
+	     of a thread in a record of its own */
+	  fmt = site_find (rec.site);
+	  if (rec.lost)
+	    printf ("-- %u messages lost --\n", (unsigned) rec.lost);
+	  else if (fmt)
+	    print_message (fmt, &rec);
+	  else
+	    printf ("(unknown message 0x%llx)\n",
+		    (unsigned long long) rec.site);
+	}
+      else
+	error (EXIT_FAILURE, 0, "%s: Corrupted entry", file);
+    }
+  while (fread (&kind, sizeof (kind), 1, f) == 1);
+
+  fclose (f);
+  return 0;
+}				/*main */
+
+/*---------------------------------------------------------------------------*/
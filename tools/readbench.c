@@ -0,0 +1,192 @@
+/*---------------------------------------------------------------------------*/
+/*readbench.c*/
+/*---------------------------------------------------------------------------*/
+/*Measures how the read throughput of files scales with the number of
+  concurrent clients.
+
+  Usage: readbench [-c MAX-CLIENTS] [-t SECONDS] [-b BLOCK-KB] FILE...
+
+  For 1, 2, 4, ... up to MAX-CLIENTS clients, every client opens the file
+  number (client % number of files) and reads it in blocks of BLOCK-KB
+  kilobytes from the beginning to the end over and over for SECONDS
+  seconds. One line is printed per number of clients: the number of
+  clients, the total throughput in MB/s and the throughput per client.
+  Giving several files shows whether the reads of different nodes contend.
+
+  Build: gcc -O2 -o readbench readbench.c -lpthread*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <errno.h>
+#include <error.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The files being read and their number*/
+static char **files;
+static int nfiles;
+/*---------------------------------------------------------------------------*/
+/*The size of a read request*/
+static size_t block_size = 64 * 1024;
+/*---------------------------------------------------------------------------*/
+/*The time (in seconds) each round lasts*/
+static int seconds = 5;
+/*---------------------------------------------------------------------------*/
+/*Set when the clients should stop reading*/
+static volatile int stop;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*The body of a client: reads its file until `stop` is set and returns the
+  number of bytes read in `*arg`*/
+static void *client (void *arg)
+{
+  unsigned long long *bytes = arg;
+  int n = *bytes;
+  char *buf;
+  off_t offset = 0;
+  ssize_t len;
+  int fd;
+
+  *bytes = 0;
+
+  fd = open (files[n % nfiles], O_RDONLY);
+  if (fd < 0)
+    error (EXIT_FAILURE, errno, "%s", files[n % nfiles]);
+
+  buf = malloc (block_size);
+  if (!buf)
+    error (EXIT_FAILURE, ENOMEM, "Could not allocate the buffer");
+
+  while (!stop)
+    {
+      len = pread (fd, buf, block_size, offset);
+      if (len < 0)
+	error (EXIT_FAILURE, errno, "%s", files[n % nfiles]);
+
+      /*start over at the end of the file */
+      offset = len ? offset + len : 0;
+      *bytes += len;
+    }
+
+  free (buf);
+  close (fd);
+  return 0;
+}				/*client */
+
+/*---------------------------------------------------------------------------*/
+/*Runs `n` clients for `seconds` seconds and returns the number of bytes
+  they have read per second*/
+static double run (int n)
+{
+  pthread_t *threads;
+  unsigned long long *bytes, total = 0;
+  struct timeval start, end;
+  int i;
+
+  threads = malloc (n * sizeof (pthread_t));
+  bytes = malloc (n * sizeof (unsigned long long));
+  if (!threads || !bytes)
+    error (EXIT_FAILURE, ENOMEM, "Could not allocate the clients");
+
+  stop = 0;
+  gettimeofday (&start, NULL);
+
+  for (i = 0; i < n; ++i)
+    {
+      /*the client learns its number from its counter */
+      bytes[i] = i;
+      if (pthread_create (&threads[i], NULL, client, &bytes[i]))
+	error (EXIT_FAILURE, errno, "Could not start a client");
+    }
+
+  sleep (seconds);
+  stop = 1;
+
+  for (i = 0; i < n; ++i)
+    {
+      pthread_join (threads[i], NULL);
+      total += bytes[i];
+    }
+
+  gettimeofday (&end, NULL);
+
+  free (threads);
+  free (bytes);
+
+  return total / ((end.tv_sec - start.tv_sec)
+		  + (end.tv_usec - start.tv_usec) / 1e6);
+}				/*run */
+
+/*---------------------------------------------------------------------------*/
+/*Entry point*/
+int main (int argc, char **argv)
+{
+  int max_clients = 16, n, opt;
+  double rate;
+
+  while ((opt = getopt (argc, argv, "c:t:b:")) != -1)
+    switch (opt)
+      {
+      case 'c':
+	max_clients = atoi (optarg);
+	break;
+      case 't':
+	seconds = atoi (optarg);
+	break;
+      case 'b':
+	block_size = strtoul (optarg, NULL, 10) * 1024;
+	break;
+      default:
+	error (EXIT_FAILURE, 0,
+	       "Usage: %s [-c MAX-CLIENTS] [-t SECONDS] [-b BLOCK-KB] FILE...",
+	       argv[0]);
+      }
+
+  if ((optind >= argc) || (max_clients < 1) || (seconds < 1)
+      || !block_size)
+    error (EXIT_FAILURE, 0, "Invalid arguments");
+
+  files = argv + optind;
+  nfiles = argc - optind;
+
+  printf ("# clients  total MB/s  MB/s per client\n");
+  for (n = 1; n <= max_clients; n *= 2)
+    {
+      rate = run (n) / (1024 * 1024);
+      printf ("%9d  %10.2f  %15.2f\n", n, rate, rate / n);
+      fflush (stdout);
+    }
+
+  return 0;
+}				/*main */
+
+/*---------------------------------------------------------------------------*/
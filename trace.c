@@ -31,188 +31,481 @@
 /*---------------------------------------------------------------------------*/
 #include "debug.h"
 #include "trace.h"
+#include "tracetab.h"
 #include "node.h"
+#include "stats.h"
 /*---------------------------------------------------------------------------*/
 
 /*---------------------------------------------------------------------------*/
-/*--------Functions----------------------------------------------------------*/
-/*Traces the translator stack on the given underlying node until it
-  finds the first translator called `name` and returns the port
-  pointing to the translator sitting under this one.*/
-error_t
-  trace_find
-  (mach_port_t underlying, const char *name, int flags, mach_port_t * port)
+/*A remembered resolution of a translator stack*/
+struct trace_entry
 {
-  error_t err = 0;
+  /*the arguments of `trace_find` (a send right to `underlying` is held, so
+     that its name is not reused for another node while we remember it) */
+  mach_port_t underlying;
+  char *name;
+  int flags;
+
+  /*the resolved port and the control port of the translator found on top
+     of it (a send right to each is held) */
+  mach_port_t port;
+  fsys_t fsys;
 
-  /*Identity information about the current process */
-  uid_t *uids;
-  size_t nuids;
+  /*the next entry in the list (the most recently used one is the first) */
+  struct trace_entry *next;
+};				/*struct trace_entry */
+/*---------------------------------------------------------------------------*/
+typedef struct trace_entry trace_entry_t;
+/*---------------------------------------------------------------------------*/
 
-  gid_t *gids;
-  size_t ngids;
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The remembered resolutions and their number*/
+static trace_entry_t *trace_cache;
+static int trace_cache_len;
+/*---------------------------------------------------------------------------*/
+/*The lock protecting the list of resolutions*/
+static struct mutex trace_cache_lock = MUTEX_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+/*The identity the translators are asked for their roots with (fetched
+  once by `trace_init`)*/
+static uid_t *trace_uids;
+static size_t trace_nuids;
+static gid_t *trace_gids;
+static size_t trace_ngids;
+/*---------------------------------------------------------------------------*/
+/*The unauthenticated port to the current directory, which is given to the
+  translators as the parent of their roots*/
+static file_t trace_dotdot = MACH_PORT_NULL;
+/*---------------------------------------------------------------------------*/
 
-  /*The name and arguments of the translator being passed now */
-  char *argz = NULL;
-  size_t argz_len = 0;
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Checks whether the port `port` still refers to a live object*/
+static int trace_port_alive (mach_port_t port)
+{
+  mach_port_type_t type;
 
-  /*The current working directory */
-  char *cwd = NULL;
+  if (!MACH_PORT_VALID (port))
+    return 0;
 
-  /*The port to the directory containing the file pointed to by `underlying` */
-  file_t dir;
+  /*When the receiver dies, our send right turns into a dead name */
+  if (mach_port_type (mach_task_self (), port, &type))
+    return 0;
+  return !(type & MACH_PORT_TYPE_DEAD_NAME);
+}				/*trace_port_alive */
 
-  /*The unauthenticated version of `dir` */
-  file_t unauth_dir;
+/*---------------------------------------------------------------------------*/
+/*Frees the entry `entry` and the ports it holds*/
+static void trace_entry_free (trace_entry_t * entry)
+{
+  PORT_DEALLOC (entry->underlying);
+  if (MACH_PORT_VALID (entry->port))
+    PORT_DEALLOC (entry->port);
+  if (MACH_PORT_VALID (entry->fsys))
+    PORT_DEALLOC (entry->fsys);
 
-  /*The control port of the current translator */
-  fsys_t fsys;
+  free (entry->name);
+  free (entry);
+}				/*trace_entry_free */
 
-  /*The port to the translator we are currently looking at */
-  mach_port_t node = underlying;
+/*---------------------------------------------------------------------------*/
+/*Looks up the remembered resolution for the given arguments and returns
+  a new send right to the resolved port in `port`; forgets the resolution
+  if the translators it refers to are gone*/
+static int
+  trace_cache_lookup
+  (mach_port_t underlying, const char *name, int flags, mach_port_t * port)
+{
+  trace_entry_t *entry, **prevp;
 
-  /*The port to the previous translator */
-  mach_port_t prev_node = MACH_PORT_NULL;
+  mutex_lock (&trace_cache_lock);
 
-  /*The retry name and retry type returned by fsys_getroot */
-  string_t retry_name;
-  retry_type retry;
+  for (prevp = &trace_cache; (entry = *prevp); prevp = &entry->next)
+    if ((entry->underlying == underlying) && (entry->flags == flags)
+	&& (strcmp (entry->name, name) == 0))
+      break;
 
-  /*Finalizes the execution of this function */
-  void finalize (void)
-  {
-    /*If there is a working directory, free it */
-    if (cwd)
-      free (cwd);
+  if (!entry)
+    {
+      mutex_unlock (&trace_cache_lock);
+      return 0;
+    }
 
-    /*If the ports to the directory exist */
-    if (dir)
-      PORT_DEALLOC (dir);
-  }				/*finalize */
+  /*Unlink the entry; it will be put back to the head if it is valid */
+  *prevp = entry->next;
 
-  /*Obtain the current working directory */
-  cwd = getcwd (NULL, 0);
-  if (!cwd)
+  /*If either of the translators has died, the stack must be traced again */
+  if (!trace_port_alive (entry->port) || !trace_port_alive (entry->fsys)
+      || mach_port_mod_refs (mach_task_self (), entry->port,
+			     MACH_PORT_RIGHT_SEND, 1))
     {
-      LOG_MSG ("trace_find: Could not obtain cwd.");
-      return EINVAL;
+      LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG,
+	      "trace_find: The remembered resolution is stale.");
+
+      --trace_cache_len;
+      mutex_unlock (&trace_cache_lock);
+
+      trace_entry_free (entry);
+      return 0;
     }
-  LOG_MSG ("trace_find: cwd: '%s'", cwd);
 
-  /*Open a port to this directory */
-  dir = file_name_lookup (cwd, 0, 0);
-  if (!dir)
+  entry->next = trace_cache;
+  trace_cache = entry;
+
+  *port = entry->port;
+
+  mutex_unlock (&trace_cache_lock);
+  return 1;
+}				/*trace_cache_lookup */
+
+/*---------------------------------------------------------------------------*/
+/*Remembers that the stack on `underlying` resolves to `port`, the
+  translator on top of which is controlled by `fsys` (consumes a send right
+  to `fsys`; references to `underlying` and to `port` are taken)*/
+static void
+  trace_cache_insert
+  (mach_port_t underlying, const char *name, int flags, mach_port_t port,
+   fsys_t fsys)
+{
+  error_t err = 0;
+  trace_entry_t *entry, **prevp;
+
+  entry = malloc (sizeof (trace_entry_t));
+  if (entry)
+    entry->name = strdup (name);
+  if (!entry || !entry->name)
+    err = ENOMEM;
+
+  /*Hold both the underlying node and the resolved port */
+  if (!err)
+    err = mach_port_mod_refs (mach_task_self (), underlying,
+			      MACH_PORT_RIGHT_SEND, 1);
+  if (!err)
     {
-      finalize ();
-      return ENOENT;
+      err = mach_port_mod_refs (mach_task_self (), port,
+				MACH_PORT_RIGHT_SEND, 1);
+      if (err)
+	PORT_DEALLOC (underlying);
     }
 
-  /*Try to get the number of effective UIDs */
-  nuids = geteuids (0, 0);
-  if (nuids < 0)
+  /*If we cannot remember the resolution, it is not a problem */
+  if (err)
     {
-      finalize ();
-      return EINVAL;
+      if (entry)
+	{
+	  free (entry->name);
+	  free (entry);
+	}
+      PORT_DEALLOC (fsys);
+      return;
     }
 
-  /*Allocate some memory for the UIDs on the stack */
-  uids = alloca (nuids * sizeof (uid_t));
+  entry->underlying = underlying;
+  entry->flags = flags;
+  entry->port = port;
+  entry->fsys = fsys;
 
-  /*Fetch the UIDs themselves */
-  nuids = geteuids (nuids, uids);
-  if (nuids < 0)
-    {
-      finalize ();
-      return EINVAL;
-    }
+  mutex_lock (&trace_cache_lock);
 
-  /*Try to get the number of effective GIDs */
-  ngids = getgroups (0, 0);
-  if (ngids < 0)
+  entry->next = trace_cache;
+  trace_cache = entry;
+
+  /*Forget the least recently used resolution if there are too many */
+  if (++trace_cache_len > TRACE_CACHE_MAX)
     {
-      finalize ();
-      return EINVAL;
+      for (prevp = &trace_cache; (*prevp)->next; prevp = &(*prevp)->next)
+	;
+      entry = *prevp;
+      *prevp = NULL;
+      --trace_cache_len;
     }
+  else
+    entry = NULL;
+
+  mutex_unlock (&trace_cache_lock);
+
+  if (entry)
+    trace_entry_free (entry);
+}				/*trace_cache_insert */
+
+/*---------------------------------------------------------------------------*/
+/*Fetches the identity of the process and the port to the current
+  directory used for tracing the translator stacks*/
+error_t trace_init (void)
+{
+  error_t err = 0;
 
-  /*Allocate some memory for the GIDs on the stack */
-  gids = alloca (ngids * sizeof (gid_t));
+  /*The number of the UIDs and of the GIDs */
+  int n;
 
-  /*Fetch the GIDs themselves */
-  ngids = getgroups (ngids, gids);
-  if (ngids < 0)
+  /*The current working directory */
+  char *cwd = NULL;
+
+  /*The port to the current working directory */
+  file_t dir;
+
+  /*Obtain the current working directory */
+  cwd = getcwd (NULL, 0);
+  if (!cwd)
     {
-      finalize ();
+      LOG_AT (LOG_TRACE, LOG_LEVEL_ERROR, "trace_init: Could not obtain cwd.");
       return EINVAL;
     }
+  LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG, "trace_init: cwd: '%s'", cwd);
+
+  /*Open a port to this directory */
+  dir = file_name_lookup (cwd, 0, 0);
+  free (cwd);
+  if (dir == MACH_PORT_NULL)
+    return ENOENT;
 
   /*Obtain the unauthenticated version of `dir` */
-  err = io_restrict_auth (dir, &unauth_dir, 0, 0, 0, 0);
+  err = io_restrict_auth (dir, &trace_dotdot, 0, 0, 0, 0);
+  PORT_DEALLOC (dir);
   if (err)
-    {
-      finalize ();
-      return err;
-    }
+    return err;
+
+  /*Fetch the effective UIDs */
+  n = geteuids (0, 0);
+  if (n < 0)
+    return EINVAL;
+  trace_uids = malloc ((n + 1) * sizeof (uid_t));
+  if (!trace_uids)
+    return ENOMEM;
+  n = geteuids (n, trace_uids);
+  if (n < 0)
+    return EINVAL;
+  trace_nuids = n;
+
+  /*Fetch the GIDs */
+  n = getgroups (0, 0);
+  if (n < 0)
+    return EINVAL;
+  trace_gids = malloc ((n + 1) * sizeof (gid_t));
+  if (!trace_gids)
+    return ENOMEM;
+  n = getgroups (n, trace_gids);
+  if (n < 0)
+    return EINVAL;
+  trace_ngids = n;
+
+  return 0;
+}				/*trace_init */
+
+/*---------------------------------------------------------------------------*/
+/*Walks the translator stack on `underlying` up to the first translator
+  called `name`; returns the port to the translator under it, the control
+  port of the translator on top of that port in `fsys_top` and the number
+  of levels climbed in `depth` (-1 if the translator has not been found).
+  The names of the translators on the first `skip` levels are not checked;
+  if `name` is not found exactly on the level `skip`, ESTALE is returned.*/
+static error_t
+  trace_walk
+  (mach_port_t underlying, const char *name, int flags, int skip,
+   mach_port_t * port, fsys_t * fsys_top, int *depth)
+{
+  error_t err = 0;
+
+  /*The number of levels climbed so far */
+  int level;
+
+  /*The name and arguments of the translator being passed now */
+  char *argz = NULL;
+  size_t argz_len = 0;
+
+  /*The control port of the current translator */
+  fsys_t fsys = MACH_PORT_NULL;
+
+  /*The control port of the translator sitting on `prev_node` */
+  fsys_t prev_fsys = MACH_PORT_NULL;
+
+  /*The port to the translator we are currently looking at */
+  mach_port_t node = underlying;
+
+  /*The port to the previous translator */
+  mach_port_t prev_node = MACH_PORT_NULL;
+
+  /*The retry name and retry type returned by fsys_getroot */
+  string_t retry_name;
+  retry_type retry;
 
-  char buf[256];
-  char *_buf = buf;
-  size_t len = 256;
-  io_read (node, &_buf, &len, 0, len);
-  LOG_MSG ("trace_find: Read from underlying: '%s'", buf);
+  /*The identity of the process must be known */
+  if (!MACH_PORT_VALID (trace_dotdot))
+    return EINVAL;
+
+  *depth = -1;
 
   /*Go up the translator stack */
-  for (; !err;)
+  for (level = 0; !err; ++level)
     {
-      /*retreive the name and options of the current translator */
-      err = file_get_fs_options (node, &argz, &argz_len);
-      if (err)
-	break;
+      /*time each level of the stack */
+      STATS_TRACE_LEVEL (level);
 
-      LOG_MSG ("trace_find: Obtained translator '%s'", argz);
-      if (strcmp (argz, name) == 0)
+      /*the translator is known not to be below the level `skip` */
+      if (level >= skip)
 	{
-	  LOG_MSG ("trace_find: Match. Stopping here.");
-	  break;
+	  /*retreive the name and options of the current translator */
+	  err = STATS_RPC (STATS_RPC_FILE_GET_FS_OPTIONS,
+			   file_get_fs_options (node, &argz, &argz_len));
+	  if (err)
+	    break;
+
+	  LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG,
+		  "trace_find: Obtained translator '%s'", argz);
+	  int match = (strcmp (argz, name) == 0);
+
+	  /*the options are returned out of line */
+	  vm_deallocate (mach_task_self (), (vm_address_t) argz, argz_len);
+	  argz = NULL;
+	  argz_len = 0;
+
+	  if (match)
+	    {
+	      LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG,
+		      "trace_find: Match. Stopping here.");
+	      *depth = level;
+	      break;
+	    }
+
+	  /*the stack has changed since the level has been recorded */
+	  if (skip)
+	    {
+	      err = ESTALE;
+	      break;
+	    }
 	}
 
       /*try to fetch the control port for this translator */
-      err = file_get_translator_cntl (node, &fsys);
-      LOG_MSG ("trace_find: err = %d", (int) err);
+      err = STATS_RPC (STATS_RPC_FILE_GET_TRANSLATOR_CNTL,
+		       file_get_translator_cntl (node, &fsys));
+      LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG, "trace_find: err = %d", (int) err);
       if (err)
 	break;
 
-      LOG_MSG ("trace_find: Translator control port: %lu",
-	       (unsigned long) fsys);
+      LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG,
+	      "trace_find: Translator control port: %lu",
+	      (unsigned long) fsys);
 
+      /*only the control port of the topmost level visited is kept */
+      if (MACH_PORT_VALID (prev_fsys))
+	PORT_DEALLOC (prev_fsys);
+      prev_fsys = fsys;
+
+      /*only the port to the topmost level below the current one is kept,
+         too (the underlying node belongs to the caller) */
+      if (MACH_PORT_VALID (prev_node) && (prev_node != underlying))
+	PORT_DEALLOC (prev_node);
       prev_node = node;
+      node = MACH_PORT_NULL;
 
       /*fetch the root of the translator */
-      err = fsys_getroot
-	(fsys, unauth_dir, MACH_MSG_TYPE_COPY_SEND,
-	 uids, nuids, gids, ngids,
-	 flags | O_NOTRANS, &retry, retry_name, &node);
-
-      LOG_MSG ("trace_find: fsys_getroot returned %d", (int) err);
-      LOG_MSG ("trace_find: Translator root: %lu", (unsigned long) node);
-
-      /*TODO: Remove this debug output. */
-      /*char buf[256];
-         char * _buf = buf;
-         size_t len = 256;
-         io_read(node, &_buf, &len, 0, len);
-         LOG_MSG("trace_find: Read: '%s'", buf); */
+      err = STATS_RPC (STATS_RPC_FSYS_GETROOT,
+		       fsys_getroot (fsys, trace_dotdot,
+				     MACH_MSG_TYPE_COPY_SEND, trace_uids,
+				     trace_nuids, trace_gids, trace_ngids,
+				     flags | O_NOTRANS, &retry, retry_name,
+				     &node));
+
+      LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG,
+	      "trace_find: fsys_getroot returned %d", (int) err);
+      LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG, "trace_find: Translator root: %lu",
+	      (unsigned long) node);
     }
 
   /*If the error occurred (most probably) because of the fact that we
      have reached the top of the translator stack */
   if ((err == EMACH_SEND_INVALID_DEST) || (err == ENXIO))
-    /*this is OK */
-    err = 0;
+    /*this is OK, unless the stack should have been higher */
+    err = (skip && (level <= skip)) ? ESTALE : 0;
+
+  /*The root of the level the walk has stopped at is not returned */
+  if (MACH_PORT_VALID (node) && (node != underlying))
+    PORT_DEALLOC (node);
+
+  /*If the recorded level is wrong, the caller will walk the stack again */
+  if (err == ESTALE)
+    {
+      if (MACH_PORT_VALID (prev_fsys))
+	PORT_DEALLOC (prev_fsys);
+      if (MACH_PORT_VALID (prev_node) && (prev_node != underlying))
+	PORT_DEALLOC (prev_node);
+      prev_fsys = MACH_PORT_NULL;
+      prev_node = MACH_PORT_NULL;
+    }
 
   /*Return the port to read from */
   *port = prev_node;
+  *fsys_top = prev_fsys;
+
+  /*Return the result of operations */
+  return err;
+}				/*trace_walk */
+
+/*---------------------------------------------------------------------------*/
+/*Traces the translator stack on the given underlying node until it
+  finds the first translator called `name` and returns the port
+  pointing to the translator sitting under this one. The result of the
+  previous resolution for the same arguments is reused while the
+  translators involved are alive.*/
+error_t
+  trace_find
+  (mach_port_t underlying, const char *name, int flags, mach_port_t * port)
+{
+  error_t err = 0;
+
+  /*The control port of the translator on top of the resolved port */
+  fsys_t fsys = MACH_PORT_NULL;
+
+  /*The stat information of the underlying node, which identifies it in
+     the table shared with the other filters */
+  io_statbuf_t stat;
+  int shared = 0;
+
+  /*The levels of the stack which need not be checked and the level the
+     translator has been found at */
+  int skip = 0, depth;
+
+  /*Try the remembered resolutions first */
+  if (trace_cache_lookup (underlying, name, flags, port))
+    {
+      LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG,
+	      "trace_find: Reused the resolution of the stack.");
+      return 0;
+    }
+
+  /*If another filter has traced the same stack, go straight to the level
+     it has found the translator at */
+  if (tracetab_file
+      && !STATS_RPC (STATS_RPC_IO_STAT, io_stat (underlying, &stat)))
+    {
+      shared = 1;
+      skip = tracetab_lookup (stat.st_fsid, stat.st_ino, name);
+      if (skip < 0)
+	skip = 0;
+    }
+
+  /*Walk the stack */
+  err = trace_walk (underlying, name, flags, skip, port, &fsys, &depth);
+  if (err == ESTALE)
+    {
+      LOG_AT (LOG_TRACE, LOG_LEVEL_DEBUG,
+	      "trace_find: The shared resolution is stale.");
+      err = trace_walk (underlying, name, flags, 0, port, &fsys, &depth);
+    }
+
+  /*Share the level with the other filters */
+  if (!err && shared && (depth > 0) && (depth != skip))
+    tracetab_store (stat.st_fsid, stat.st_ino, name, depth);
+
+  /*Remember the result if it was obtained from a translator we can watch */
+  if (!err && MACH_PORT_VALID (*port) && (*port != underlying)
+      && MACH_PORT_VALID (fsys))
+    trace_cache_insert (underlying, name, flags, *port, fsys);
+  else if (MACH_PORT_VALID (fsys))
+    PORT_DEALLOC (fsys);
 
   /*Return the result of operations */
-  finalize ();
   return err;
 }				/*trace_find */
 
@@ -31,12 +31,24 @@
 #include <hurd/iohelp.h>
 /*---------------------------------------------------------------------------*/
 
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The maximal number of resolved translator stacks remembered*/
+#define TRACE_CACHE_MAX 16
+/*---------------------------------------------------------------------------*/
+
 /*---------------------------------------------------------------------------*/
 /*--------Functions----------------------------------------------------------*/
+/*Fetches the identity of the process and the port to the current
+  directory used for tracing the translator stacks (must be called before
+  the first trace)*/
+error_t trace_init (void);
+/*---------------------------------------------------------------------------*/
 /*Traces the translator stack on the given underlying node until it
   finds the first translator called `name` and returns the port
   pointing to the translator sitting under this one, opened as
-  specified in `flags`.*/
+  specified in `flags`. The result of the previous resolution for the same
+  arguments is reused while the translators involved are alive.*/
 error_t
   trace_find
   (mach_port_t underlying, const char *name, int flags, mach_port_t * port);
@@ -0,0 +1,204 @@
+/*---------------------------------------------------------------------------*/
+/*tracetab.c*/
+/*---------------------------------------------------------------------------*/
+/*The table of the traced translator stacks shared by all the filters on the
+  host*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+/*---------------------------------------------------------------------------*/
+#include "debug.h"
+#include "tracetab.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The file the table is mapped from (the table is not used if unset)*/
+char *tracetab_file = NULL;
+/*---------------------------------------------------------------------------*/
+/*The mapped table (NULL if the table is not used)*/
+static tracetab_t *tracetab;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Computes the index of the first slot for the key*/
+static unsigned int tracetab_hash (dev_t fsid, ino_t ino, const char *name)
+{
+  unsigned int h = 2166136261u;
+
+  /*FNV-1a over the key */
+  h = (h ^ (unsigned int) fsid) * 16777619u;
+  h = (h ^ (unsigned int) ino) * 16777619u;
+  h = (h ^ (unsigned int) ((unsigned long long) ino >> 32)) * 16777619u;
+  for (; *name; ++name)
+    h = (h ^ (unsigned char) *name) * 16777619u;
+
+  return h % TRACETAB_SLOTS;
+}				/*tracetab_hash */
+
+/*---------------------------------------------------------------------------*/
+/*Maps the table from `tracetab_file`, creating the file if needed*/
+error_t tracetab_open (void)
+{
+  int fd, i;
+  struct stat st;
+  tracetab_t *table;
+
+  fd = open (tracetab_file, O_RDWR | O_CREAT, 0644);
+  if (fd < 0)
+    return errno;
+
+  /*A new file is filled with zeros, which make an empty table */
+  if ((fstat (fd, &st) < 0)
+      || ((st.st_size < sizeof (tracetab_t))
+	  && (ftruncate (fd, sizeof (tracetab_t)) < 0)))
+    {
+      error_t err = errno;
+      close (fd);
+      return err;
+    }
+
+  table = mmap (0, sizeof (tracetab_t), PROT_READ | PROT_WRITE, MAP_SHARED,
+		fd, 0);
+  close (fd);
+  if (table == MAP_FAILED)
+    return errno;
+
+  /*The first filter to map the file initializes the table and marks it
+     as initialized only then; the others wait for it */
+  if (__sync_bool_compare_and_swap (&table->magic, 0, TRACETAB_BUSY))
+    {
+      table->nslots = TRACETAB_SLOTS;
+      __sync_synchronize ();
+      table->magic = TRACETAB_MAGIC;
+    }
+  for (i = 0; (table->magic == TRACETAB_BUSY) && (i < TRACETAB_WAIT_TRIES);
+       ++i)
+    usleep (TRACETAB_WAIT_DELAY * 1000);
+  __sync_synchronize ();
+
+  if ((table->magic != TRACETAB_MAGIC) || (table->nslots != TRACETAB_SLOTS))
+    {
+      munmap (table, sizeof (tracetab_t));
+      return EINVAL;
+    }
+
+  LOG_AT (LOG_TRACE, LOG_LEVEL_INFO, "tracetab_open: Mapped '%s'.",
+	  tracetab_file);
+
+  tracetab = table;
+  return 0;
+}				/*tracetab_open */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the number of levels of the translator stack on the inode `ino`
+  of the filesystem `fsid` which have to be climbed to reach the translator
+  `name`, or -1 if this is not known*/
+int tracetab_lookup (dev_t fsid, ino_t ino, const char *name)
+{
+  unsigned int h, i, seq;
+
+  /*The copy of the slot being looked at */
+  tracetab_slot_t copy;
+
+  if (!tracetab || (strlen (name) >= TRACETAB_NAME_MAX))
+    return -1;
+
+  h = tracetab_hash (fsid, ino, name);
+  for (i = 0; i < TRACETAB_PROBES; ++i)
+    {
+      tracetab_slot_t *slot = &tracetab->slots[(h + i) % TRACETAB_SLOTS];
+
+      /*copy the slot, unless it is being written, and make sure it has
+         not been written while it was being copied */
+      seq = slot->seq;
+      if (seq & 1)
+	continue;
+      __sync_synchronize ();
+      memcpy (&copy, slot, sizeof (copy));
+      __sync_synchronize ();
+      if (slot->seq != seq)
+	continue;
+
+      if ((copy.fsid == fsid) && (copy.ino == ino)
+	  && (strncmp (copy.name, name, TRACETAB_NAME_MAX) == 0))
+	return copy.depth;
+    }
+
+  return -1;
+}				/*tracetab_lookup */
+
+/*---------------------------------------------------------------------------*/
+/*Records that the translator `name` is reached by climbing `depth` levels
+  of the translator stack on the inode `ino` of the filesystem `fsid`*/
+void tracetab_store (dev_t fsid, ino_t ino, const char *name, int depth)
+{
+  unsigned int h, i, seq;
+
+  /*The slot the entry is written to */
+  tracetab_slot_t *slot = NULL;
+
+  if (!tracetab || (strlen (name) >= TRACETAB_NAME_MAX))
+    return;
+
+  /*Use the slot of the key or an empty one; if there is none, replace the
+     entry in the first slot for the key */
+  h = tracetab_hash (fsid, ino, name);
+  for (i = 0; i < TRACETAB_PROBES; ++i)
+    {
+      tracetab_slot_t *s = &tracetab->slots[(h + i) % TRACETAB_SLOTS];
+
+      if (((s->fsid == fsid) && (s->ino == ino)
+	   && (strncmp (s->name, name, TRACETAB_NAME_MAX) == 0))
+	  || (!s->fsid && !s->ino))
+	{
+	  slot = s;
+	  break;
+	}
+    }
+  if (!slot)
+    slot = &tracetab->slots[h];
+
+  /*If another filter is writing the slot, let it win */
+  seq = slot->seq;
+  if ((seq & 1) || !__sync_bool_compare_and_swap (&slot->seq, seq, seq + 1))
+    return;
+
+  slot->fsid = fsid;
+  slot->ino = ino;
+  memcpy (slot->name, name, strlen (name) + 1);
+  slot->depth = depth;
+
+  /*Publish the slot */
+  __sync_synchronize ();
+  slot->seq = seq + 2;
+}				/*tracetab_store */
+
+/*---------------------------------------------------------------------------*/
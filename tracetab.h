@@ -0,0 +1,114 @@
+/*---------------------------------------------------------------------------*/
+/*tracetab.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for the table of the traced translator stacks shared by
+  all the filters on the host*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __TRACETAB_H__
+#define __TRACETAB_H__
+/*---------------------------------------------------------------------------*/
+#include <error.h>
+#include <sys/types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The number of slots in the table*/
+#define TRACETAB_SLOTS 4096
+/*---------------------------------------------------------------------------*/
+/*The number of slots looked at for a key*/
+#define TRACETAB_PROBES 8
+/*---------------------------------------------------------------------------*/
+/*The maximal length of a translator name stored in the table (including
+  the terminating zero)*/
+#define TRACETAB_NAME_MAX 64
+/*---------------------------------------------------------------------------*/
+/*Identifies the layout of the table file*/
+#define TRACETAB_MAGIC 0x46545431
+/*---------------------------------------------------------------------------*/
+/*Marks the table while the first filter to map it is initializing it*/
+#define TRACETAB_BUSY 0x46545430
+/*---------------------------------------------------------------------------*/
+/*The number of times a filter checks whether the table being initialized
+  by another filter is ready and the delay (in milliseconds) between the
+  checks*/
+#define TRACETAB_WAIT_TRIES 100
+#define TRACETAB_WAIT_DELAY 1
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A slot of the table: the level of the translator stack on a node at which
+  a translator has been found*/
+struct tracetab_slot
+{
+  /*odd while the slot is being written; readers retry or skip the slot if
+     it changes while they copy the slot */
+  volatile unsigned int seq;
+
+  /*the number of levels climbed from the node to reach the translator */
+  int depth;
+
+  /*the filesystem and the inode number of the node and the name of the
+     translator (all zero in an empty slot) */
+  unsigned long long fsid;
+  unsigned long long ino;
+  char name[TRACETAB_NAME_MAX];
+};				/*struct tracetab_slot */
+/*---------------------------------------------------------------------------*/
+typedef struct tracetab_slot tracetab_slot_t;
+/*---------------------------------------------------------------------------*/
+/*The layout of the table file*/
+struct tracetab
+{
+  /*`TRACETAB_BUSY` while the table is being initialized and
+     `TRACETAB_MAGIC` once it has been */
+  volatile unsigned int magic;
+
+  /*the number of slots */
+  unsigned int nslots;
+
+  tracetab_slot_t slots[TRACETAB_SLOTS];
+};				/*struct tracetab */
+/*---------------------------------------------------------------------------*/
+typedef struct tracetab tracetab_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*The file the table is mapped from (the table is not used if unset)*/
+extern char *tracetab_file;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Maps the table from `tracetab_file`, creating the file if needed*/
+error_t tracetab_open (void);
+/*---------------------------------------------------------------------------*/
+/*Returns the number of levels of the translator stack on the inode `ino`
+  of the filesystem `fsid` which have to be climbed to reach the translator
+  `name`, or -1 if this is not known*/
+int tracetab_lookup (dev_t fsid, ino_t ino, const char *name);
+/*---------------------------------------------------------------------------*/
+/*Records that the translator `name` is reached by climbing `depth` levels
+  of the translator stack on the inode `ino` of the filesystem `fsid`*/
+void tracetab_store (dev_t fsid, ino_t ino, const char *name, int depth);
+/*---------------------------------------------------------------------------*/
+#endif /*__TRACETAB_H__*/
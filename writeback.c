@@ -0,0 +1,511 @@
+/*---------------------------------------------------------------------------*/
+/*writeback.c*/
+/*---------------------------------------------------------------------------*/
+/*Buffering of the written data in the filter and flushing it to the target
+  in large chunks*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+#define _GNU_SOURCE 1
+/*---------------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <hurd/io.h>
+/*---------------------------------------------------------------------------*/
+#include "debug.h"
+#include "filter.h"
+#include "writeback.h"
+#include "stats.h"
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*Set if the written data should be buffered (off by default)*/
+int writeback = 0;
+/*---------------------------------------------------------------------------*/
+/*The age (in milliseconds) after which dirty data is flushed*/
+int writeback_age = WRITEBACK_AGE_DEFAULT;
+/*---------------------------------------------------------------------------*/
+/*The amount of dirty data of a node which causes a flush*/
+size_t writeback_size = WRITEBACK_SIZE_DEFAULT;
+/*---------------------------------------------------------------------------*/
+/*The list of the nodes having dirty data*/
+static struct node *dirty_nodes;
+/*---------------------------------------------------------------------------*/
+/*The lock protecting the list of dirty nodes*/
+static struct mutex dirty_nodes_lock = MUTEX_INITIALIZER;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Frees an extent*/
+static void extent_free (writeback_extent_t * extent)
+{
+  free (extent->data);
+  free (extent);
+}				/*extent_free */
+
+/*---------------------------------------------------------------------------*/
+/*Puts `np` on the list of dirty nodes unless it is already there. The
+  write-back state of the node must be locked.*/
+static void writeback_list (struct node *np)
+{
+  writeback_t *wb = &np->nn->wb;
+
+  if (wb->prevp)
+    return;
+
+  /*The list holds a reference to the node */
+  netfs_nref (np);
+
+  mutex_lock (&dirty_nodes_lock);
+
+  wb->next = dirty_nodes;
+  wb->prevp = &dirty_nodes;
+  if (dirty_nodes)
+    dirty_nodes->nn->wb.prevp = &wb->next;
+  dirty_nodes = np;
+
+  mutex_unlock (&dirty_nodes_lock);
+}				/*writeback_list */
+
+/*---------------------------------------------------------------------------*/
+/*Removes `np` from the list of dirty nodes; returns nonzero if the node
+  was on the list, in which case the caller must drop the reference of the
+  list after unlocking the write-back state of the node*/
+static int writeback_unlist (struct node *np)
+{
+  writeback_t *wb = &np->nn->wb;
+
+  if (!wb->prevp)
+    return 0;
+
+  mutex_lock (&dirty_nodes_lock);
+
+  *wb->prevp = wb->next;
+  if (wb->next)
+    wb->next->nn->wb.prevp = wb->prevp;
+  wb->next = NULL;
+  wb->prevp = NULL;
+
+  mutex_unlock (&dirty_nodes_lock);
+
+  return 1;
+}				/*writeback_unlist */
+
+/*---------------------------------------------------------------------------*/
+/*Writes all the extents of `wb` to `port`; the write-back state must be
+  locked*/
+static error_t writeback_flush_locked (writeback_t * wb, mach_port_t port)
+{
+  error_t err = 0;
+
+  writeback_extent_t *extent;
+
+  /*Go through the extents in the order of their offsets */
+  while ((extent = wb->extents) != NULL)
+    {
+      /*the number of bytes of the extent written so far */
+      size_t done = 0;
+      error_t e = 0;
+
+      /*the target may accept less than offered */
+      while (!e && (done < extent->len))
+	{
+	  vm_size_t amount = 0;
+
+	  e = STATS_RPC (STATS_RPC_IO_WRITE,
+			 io_write (port, extent->data + done,
+				   extent->len - done, extent->offset + done,
+				   &amount));
+	  if (!e && !amount)
+	    e = EIO;
+
+	  done += amount;
+	}
+
+      if (e)
+	{
+	  LOG_AT (LOG_READ, LOG_LEVEL_ERROR,
+		  "writeback_flush_locked: Lost %lu bytes at %lu: %d.",
+		  (unsigned long) (extent->len - done),
+		  (unsigned long) extent->offset, (int) e);
+
+	  /*remember only the first error */
+	  if (!err)
+	    err = e;
+	}
+
+      /*the extent is not dirty anymore */
+      wb->extents = extent->next;
+      wb->dirty -= extent->len;
+      extent_free (extent);
+    }
+
+  /*Return the result of writing */
+  return err;
+}				/*writeback_flush_locked */
+
+/*---------------------------------------------------------------------------*/
+/*Writes all the dirty data of `np` to the target. If `report` is set, the
+  errors of the earlier background flushes are returned as well. The node
+  must be locked, so it stays on the list of dirty nodes until
+  `writeback_release` takes it off.*/
+static error_t writeback_flush_node (struct node *np, int report)
+{
+  error_t err = 0;
+
+  writeback_t *wb = &np->nn->wb;
+
+  mutex_lock (&wb->lock);
+
+  /*Write the data */
+  err = writeback_flush_locked (wb, np->nn->port);
+
+  /*If the error should not be reported now, keep it for the next sync */
+  if (!report)
+    {
+      if (err && !wb->err)
+	wb->err = err;
+    }
+  else
+    {
+      if (!err)
+	err = wb->err;
+      wb->err = 0;
+    }
+
+  mutex_unlock (&wb->lock);
+
+  return err;
+}				/*writeback_flush_node */
+
+/*---------------------------------------------------------------------------*/
+/*Takes `np` off the list of dirty nodes if it has no dirty data left and
+  drops the reference of the list. The node must not be locked, since the
+  reference may be the last one.*/
+static void writeback_release (struct node *np)
+{
+  writeback_t *wb = &np->nn->wb;
+  int unlisted = 0;
+
+  mutex_lock (&wb->lock);
+  if (!wb->extents)
+    unlisted = writeback_unlist (np);
+  mutex_unlock (&wb->lock);
+
+  if (unlisted)
+    netfs_nrele (np);
+}				/*writeback_release */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the nodes having dirty data in a newly allocated array; the
+  caller must drop the references to the nodes*/
+static size_t writeback_dirty_nodes (struct node ***nodes)
+{
+  size_t n = 0;
+  struct node *np;
+
+  mutex_lock (&dirty_nodes_lock);
+
+  /*Count the nodes */
+  for (np = dirty_nodes; np; np = np->nn->wb.next)
+    ++n;
+
+  /*Reference them in the array */
+  *nodes = n ? malloc (n * sizeof (struct node *)) : NULL;
+
+  n = 0;
+  if (*nodes)
+    for (np = dirty_nodes; np; np = np->nn->wb.next)
+      {
+	netfs_nref (np);
+	(*nodes)[n++] = np;
+      }
+
+  mutex_unlock (&dirty_nodes_lock);
+
+  return n;
+}				/*writeback_dirty_nodes */
+
+/*---------------------------------------------------------------------------*/
+/*The flusher thread: writes out the data which has stayed dirty too long*/
+static any_t writeback_thread (any_t arg)
+{
+  struct node **nodes;
+  size_t n, i;
+
+  struct timeval now;
+  long age;
+
+  for (;;)
+    {
+      /*check the ages a few times per the maximal age */
+      usleep ((writeback_age > 40 ? writeback_age / 4 : 10) * 1000);
+
+      maptime_read (maptime, &now);
+
+      n = writeback_dirty_nodes (&nodes);
+      for (i = 0; i < n; ++i)
+	{
+	  struct node *np = nodes[i];
+	  writeback_t *wb = &np->nn->wb;
+
+	  mutex_lock (&np->lock);
+
+	  /*find out how long the data of the node has been dirty */
+	  mutex_lock (&wb->lock);
+	  age = (now.tv_sec - wb->since.tv_sec) * 1000
+	    + (now.tv_usec - wb->since.tv_usec) / 1000;
+	  age = wb->extents ? age : -1;
+	  mutex_unlock (&wb->lock);
+
+	  /*if it is old enough, write it out */
+	  if (age >= writeback_age)
+	    writeback_flush_node (np, 0);
+
+	  mutex_unlock (&np->lock);
+
+	  /*forget the node if it is clean */
+	  writeback_release (np);
+	  netfs_nrele (np);
+	}
+
+      free (nodes);
+    }
+
+  return 0;
+}				/*writeback_thread */
+
+/*---------------------------------------------------------------------------*/
+/*Initializes the write-back state of a node*/
+void writeback_init (writeback_t * wb)
+{
+  mutex_init (&wb->lock);
+
+  wb->extents = NULL;
+  wb->dirty = 0;
+  wb->err = 0;
+  wb->next = NULL;
+  wb->prevp = NULL;
+}				/*writeback_init */
+
+/*---------------------------------------------------------------------------*/
+/*Drops the dirty data of a node which is being destroyed*/
+void writeback_destroy (writeback_t * wb)
+{
+  writeback_extent_t *extent;
+
+  /*A dirty node is referenced by the list, so normally there is nothing
+     left here */
+  while ((extent = wb->extents) != NULL)
+    {
+      wb->extents = extent->next;
+      extent_free (extent);
+    }
+  wb->dirty = 0;
+}				/*writeback_destroy */
+
+/*---------------------------------------------------------------------------*/
+/*Starts the flusher thread*/
+error_t writeback_start (void)
+{
+  /*Start the thread, we will never wait for it */
+  cthread_detach (cthread_fork (writeback_thread, 0));
+  return 0;
+}				/*writeback_start */
+
+/*---------------------------------------------------------------------------*/
+/*Stores `len` bytes of `data` to be written at `offset` of `np` in the
+  dirty buffer of the node. The node must be locked.*/
+error_t
+  writeback_write (struct node *np, loff_t offset, size_t len, void *data)
+{
+  error_t err = 0;
+
+  writeback_t *wb = &np->nn->wb;
+  writeback_extent_t **pe, *extent, *next;
+
+  /*The region being written */
+  loff_t start = offset, end = offset + len;
+
+  mutex_lock (&wb->lock);
+
+  /*If there was no dirty data, the new data is the oldest */
+  if (!wb->extents)
+    maptime_read (maptime, &wb->since);
+
+  /*Skip the extents lying entirely before the region */
+  for (pe = &wb->extents; *pe && ((*pe)->offset + (*pe)->len < start);
+       pe = &(*pe)->next)
+    ;
+  extent = *pe;
+
+  /*If the region starts inside or right after an extent and touches no
+     other one (e.g., it appends to a log), extend the extent in place */
+  if (extent && (extent->offset <= start)
+      && (!extent->next || (extent->next->offset > end)))
+    {
+      size_t need = end - extent->offset;
+
+      if (need < extent->len)
+	need = extent->len;
+
+      /*grow the buffer geometrically to make appends cheap */
+      if (need > extent->alloced)
+	{
+	  size_t alloced = extent->alloced * 2;
+	  if (alloced < need)
+	    alloced = need;
+
+	  char *buf = realloc (extent->data, alloced);
+	  if (!buf)
+	    {
+	      mutex_unlock (&wb->lock);
+	      return ENOMEM;
+	    }
+
+	  extent->data = buf;
+	  extent->alloced = alloced;
+	}
+
+      memcpy (extent->data + (start - extent->offset), data, len);
+      wb->dirty += need - extent->len;
+      extent->len = need;
+    }
+  else
+    {
+      /*find the region covered by the extents touching the new data */
+      loff_t mstart = start, mend = end;
+
+      for (next = extent; next && (next->offset <= end); next = next->next)
+	{
+	  if (next->offset < mstart)
+	    mstart = next->offset;
+	  if (next->offset + next->len > mend)
+	    mend = next->offset + next->len;
+	}
+
+      /*create a single extent covering all of them */
+      writeback_extent_t *merged = malloc (sizeof (writeback_extent_t));
+      if (merged)
+	merged->data = malloc (mend - mstart);
+      if (!merged || !merged->data)
+	{
+	  free (merged);
+	  mutex_unlock (&wb->lock);
+	  return ENOMEM;
+	}
+
+      merged->offset = mstart;
+      merged->len = merged->alloced = mend - mstart;
+
+      /*move the old data into it, then put the new data on top */
+      for (; extent && (extent->offset <= end); extent = next)
+	{
+	  next = extent->next;
+
+	  memcpy (merged->data + (extent->offset - mstart), extent->data,
+		  extent->len);
+	  wb->dirty -= extent->len;
+	  extent_free (extent);
+	}
+      memcpy (merged->data + (start - mstart), data, len);
+
+      merged->next = extent;
+      *pe = merged;
+      wb->dirty += merged->len;
+    }
+
+  /*Make sure the flusher thread sees the node */
+  writeback_list (np);
+
+  /*If the node has accumulated enough dirty data, write it out now */
+  if (wb->dirty >= writeback_size)
+    {
+      mutex_unlock (&wb->lock);
+      err = writeback_flush_node (np, 0);
+      return err;
+    }
+
+  mutex_unlock (&wb->lock);
+  return err;
+}				/*writeback_write */
+
+/*---------------------------------------------------------------------------*/
+/*Writes all the dirty data of `np` to the target. The node must be
+  locked.*/
+error_t writeback_flush (struct node *np)
+{
+  return writeback_flush_node (np, 1);
+}				/*writeback_flush */
+
+/*---------------------------------------------------------------------------*/
+/*Writes the dirty data of all nodes to their targets*/
+error_t writeback_flush_all (void)
+{
+  error_t err = 0;
+
+  struct node **nodes;
+  size_t n, i;
+
+  /*Flush each dirty node */
+  n = writeback_dirty_nodes (&nodes);
+  for (i = 0; i < n; ++i)
+    {
+      mutex_lock (&nodes[i]->lock);
+      error_t e = writeback_flush (nodes[i]);
+      mutex_unlock (&nodes[i]->lock);
+
+      writeback_release (nodes[i]);
+      netfs_nrele (nodes[i]);
+
+      /*remember only the first error */
+      if (!err)
+	err = e;
+    }
+
+  free (nodes);
+  return err;
+}				/*writeback_flush_all */
+
+/*---------------------------------------------------------------------------*/
+/*Returns the offset after the last dirty byte of `np` (0 if there is no
+  dirty data)*/
+loff_t writeback_end (struct node *np)
+{
+  writeback_t *wb = &np->nn->wb;
+  writeback_extent_t *extent;
+  loff_t end = 0;
+
+  mutex_lock (&wb->lock);
+
+  /*The last extent lies the farthest */
+  for (extent = wb->extents; extent; extent = extent->next)
+    end = extent->offset + extent->len;
+
+  mutex_unlock (&wb->lock);
+
+  return end;
+}				/*writeback_end */
+
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,132 @@
+/*---------------------------------------------------------------------------*/
+/*writeback.h*/
+/*---------------------------------------------------------------------------*/
+/*The definitions for buffering the written data in the filter and flushing
+  it to the target in large chunks*/
+/*---------------------------------------------------------------------------*/
+/*Copyright (C) 2001, 2002, 2005, 2008 Free Software Foundation, Inc.
+  Written by Sergiu Ivanov <unlimitedscolobb@gmail.com>.
+
+  This program is free software; you can redistribute it and/or
+  modify it under the terms of the GNU General Public License as
+  published by the Free Software Foundation; either version 2 of the
+  License, or * (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+  USA.*/
+/*---------------------------------------------------------------------------*/
+#ifndef __WRITEBACK_H__
+#define __WRITEBACK_H__
+/*---------------------------------------------------------------------------*/
+#include <error.h>
+#include <cthreads.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <hurd/hurd_types.h>
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Macros-------------------------------------------------------------*/
+/*The default age (in milliseconds) after which dirty data is flushed*/
+#define WRITEBACK_AGE_DEFAULT 1000
+/*---------------------------------------------------------------------------*/
+/*The default amount of dirty data of a node which causes a flush*/
+#define WRITEBACK_SIZE_DEFAULT (256 * 1024)
+/*---------------------------------------------------------------------------*/
+/*Checks whether the written data should be buffered*/
+#define WRITEBACK_ENABLED (writeback != 0)
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*A contiguous region of dirty data*/
+struct writeback_extent
+{
+  /*the region of the file covered by the extent */
+  loff_t offset;
+  size_t len;
+
+  /*the data and the size of the buffer holding it */
+  char *data;
+  size_t alloced;
+
+  /*the next extent (the extents are sorted by their offsets and never
+     overlap or touch each other) */
+  struct writeback_extent *next;
+};				/*struct writeback_extent */
+/*---------------------------------------------------------------------------*/
+typedef struct writeback_extent writeback_extent_t;
+/*---------------------------------------------------------------------------*/
+/*The dirty data of a node*/
+struct writeback
+{
+  /*protects the fields below; it is held while the data is flushed */
+  struct mutex lock;
+
+  /*the dirty extents */
+  writeback_extent_t *extents;
+
+  /*the total number of dirty bytes */
+  size_t dirty;
+
+  /*the time the oldest dirty data has been written at */
+  struct timeval since;
+
+  /*the error which occurred when flushing the data in the background; it
+     is reported by the next sync */
+  error_t err;
+
+  /*the neighbours of the node in the list of dirty nodes (the list holds
+     a reference to the node) */
+  struct node *next, **prevp;
+};				/*struct writeback */
+/*---------------------------------------------------------------------------*/
+typedef struct writeback writeback_t;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Global Variables---------------------------------------------------*/
+/*Set if the written data should be buffered*/
+extern int writeback;
+/*---------------------------------------------------------------------------*/
+/*The age (in milliseconds) after which dirty data is flushed*/
+extern int writeback_age;
+/*---------------------------------------------------------------------------*/
+/*The amount of dirty data of a node which causes a flush*/
+extern size_t writeback_size;
+/*---------------------------------------------------------------------------*/
+
+/*---------------------------------------------------------------------------*/
+/*--------Functions----------------------------------------------------------*/
+/*Initializes the write-back state of a node*/
+void writeback_init (writeback_t * wb);
+/*---------------------------------------------------------------------------*/
+/*Drops the dirty data of a node which is being destroyed*/
+void writeback_destroy (writeback_t * wb);
+/*---------------------------------------------------------------------------*/
+/*Starts the flusher thread*/
+error_t writeback_start (void);
+/*---------------------------------------------------------------------------*/
+/*Stores `len` bytes of `data` to be written at `offset` of `np` in the
+  dirty buffer of the node. The node must be locked.*/
+error_t
+  writeback_write (struct node *np, loff_t offset, size_t len, void *data);
+/*---------------------------------------------------------------------------*/
+/*Writes all the dirty data of `np` to the target. The node must be
+  locked.*/
+error_t writeback_flush (struct node *np);
+/*---------------------------------------------------------------------------*/
+/*Writes the dirty data of all nodes to their targets*/
+error_t writeback_flush_all (void);
+/*---------------------------------------------------------------------------*/
+/*Returns the offset after the last dirty byte of `np` (0 if there is no
+  dirty data)*/
+loff_t writeback_end (struct node *np);
+/*---------------------------------------------------------------------------*/
+#endif /*__WRITEBACK_H__*/